@@ -0,0 +1,499 @@
+/**
+ * @brief Microbenchmarks for the capture/conversion and signaling hot paths
+ *
+ * Run with --benchmark_out=<file> --benchmark_out_format=json to track
+ * regressions between releases (see scripts/run_bench.sh).
+ */
+
+#include "custom_video_source.h"
+#include "frame_overlay.h"
+#include "logger.h"
+#include "sensor_telemetry.h"
+#include "signaling_utils.h"
+#include "static_scene_detector.h"
+#include "test_pattern_source.h"
+
+#include <benchmark/benchmark.h>
+#include <api/jsep.h>
+#include <api/video/i420_buffer.h>
+#include <rtc_base/ref_counted_object.h>
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace {
+
+// 480p / 720p / 1080p / 4K
+void Resolutions(benchmark::internal::Benchmark* b) {
+    b->Args({640, 480})->Args({1280, 720})->Args({1920, 1080})->Args({3840, 2160});
+}
+
+cv::Mat randomMat(int width, int height, int type) {
+    cv::Mat mat(height, width, type);
+    cv::randu(mat, cv::Scalar::all(0), cv::Scalar::all(255));
+    return mat;
+}
+
+// Chrome 生成的典型 sendonly offer（约 3KB）
+std::string sampleOfferSdp() {
+    std::string sdp =
+        "v=0\r\n"
+        "o=- 4611731400430051336 2 IN IP4 127.0.0.1\r\n"
+        "s=-\r\n"
+        "t=0 0\r\n"
+        "a=group:BUNDLE 0\r\n"
+        "a=extmap-allow-mixed\r\n"
+        "a=msid-semantic: WMS stream_id\r\n"
+        "m=video 9 UDP/TLS/RTP/SAVPF 96 97 98 99 100 101 127\r\n"
+        "c=IN IP4 0.0.0.0\r\n"
+        "a=rtcp:9 IN IP4 0.0.0.0\r\n"
+        "a=ice-ufrag:Jq4b\r\n"
+        "a=ice-pwd:7HfZ0bG7zGk3Y6xk8eJ9mE2p\r\n"
+        "a=ice-options:trickle\r\n"
+        "a=fingerprint:sha-256 5B:0A:9E:2C:6F:4D:1A:83:7E:55:C0:91:2B:DF:44:17:"
+        "A6:3C:88:0E:F1:72:9D:B4:05:6A:E3:18:CB:27:90:4F\r\n"
+        "a=setup:actpass\r\n"
+        "a=mid:0\r\n"
+        "a=extmap:1 urn:ietf:params:rtp-hdrext:toffset\r\n"
+        "a=extmap:2 http://www.webrtc.org/experiments/rtp-hdrext/abs-send-time\r\n"
+        "a=extmap:3 urn:3gpp:video-orientation\r\n"
+        "a=extmap:4 http://www.ietf.org/id/draft-holmer-rmcat-transport-wide-cc-extensions-01\r\n"
+        "a=extmap:5 http://www.webrtc.org/experiments/rtp-hdrext/playout-delay\r\n"
+        "a=extmap:6 http://www.webrtc.org/experiments/rtp-hdrext/video-content-type\r\n"
+        "a=extmap:7 http://www.webrtc.org/experiments/rtp-hdrext/video-timing\r\n"
+        "a=extmap:8 http://www.webrtc.org/experiments/rtp-hdrext/color-space\r\n"
+        "a=extmap:9 urn:ietf:params:rtp-hdrext:sdes:mid\r\n"
+        "a=sendrecv\r\n"
+        "a=msid:stream_id video_track\r\n"
+        "a=rtcp-mux\r\n"
+        "a=rtcp-rsize\r\n"
+        "a=rtpmap:96 VP8/90000\r\n"
+        "a=rtcp-fb:96 goog-remb\r\n"
+        "a=rtcp-fb:96 transport-cc\r\n"
+        "a=rtcp-fb:96 ccm fir\r\n"
+        "a=rtcp-fb:96 nack\r\n"
+        "a=rtcp-fb:96 nack pli\r\n"
+        "a=rtpmap:97 rtx/90000\r\n"
+        "a=fmtp:97 apt=96\r\n"
+        "a=rtpmap:98 H264/90000\r\n"
+        "a=rtcp-fb:98 goog-remb\r\n"
+        "a=rtcp-fb:98 transport-cc\r\n"
+        "a=rtcp-fb:98 ccm fir\r\n"
+        "a=rtcp-fb:98 nack\r\n"
+        "a=rtcp-fb:98 nack pli\r\n"
+        "a=fmtp:98 level-asymmetry-allowed=1;packetization-mode=1;profile-level-id=42e01f\r\n"
+        "a=rtpmap:99 rtx/90000\r\n"
+        "a=fmtp:99 apt=98\r\n"
+        "a=rtpmap:100 red/90000\r\n"
+        "a=rtpmap:101 rtx/90000\r\n"
+        "a=fmtp:101 apt=100\r\n"
+        "a=rtpmap:127 ulpfec/90000\r\n"
+        "a=ssrc-group:FID 2863470104 1790542436\r\n"
+        "a=ssrc:2863470104 cname:Yx3kQ2mZ7uN1vB0c\r\n"
+        "a=ssrc:2863470104 msid:stream_id video_track\r\n"
+        "a=ssrc:1790542436 cname:Yx3kQ2mZ7uN1vB0c\r\n"
+        "a=ssrc:1790542436 msid:stream_id video_track\r\n";
+    return sdp;
+}
+
+// 与 rs2::colorizer 默认行为一致：直方图均衡 + Jet 色表
+void colorizeDepth(const cv::Mat& depth, std::vector<uint32_t>& histogram, cv::Mat& normalized,
+                   cv::Mat& colored) {
+    std::fill(histogram.begin(), histogram.end(), 0);
+    for (int y = 0; y < depth.rows; y++) {
+        const uint16_t* row = depth.ptr<uint16_t>(y);
+        for (int x = 0; x < depth.cols; x++) {
+            histogram[row[x]]++;
+        }
+    }
+    for (size_t i = 2; i < histogram.size(); i++) {
+        histogram[i] += histogram[i - 1];   // 0 表示无效深度，不参与均衡
+    }
+    const uint32_t total = histogram.back();
+    normalized.create(depth.size(), CV_8UC1);
+    for (int y = 0; y < depth.rows; y++) {
+        const uint16_t* src = depth.ptr<uint16_t>(y);
+        uint8_t* dst = normalized.ptr<uint8_t>(y);
+        for (int x = 0; x < depth.cols; x++) {
+            dst[x] = src[x] ? static_cast<uint8_t>(histogram[src[x]] * 255ull / total) : 0;
+        }
+    }
+    cv::applyColorMap(normalized, colored, cv::COLORMAP_JET);
+}
+
+// 带行填充的随机帧（step 大于有效宽度），I420 / NV12 为 height * 3 / 2 行
+cv::Mat paddedFrame(PixelFormat format, int width, int height) {
+    int type = CV_8UC1;
+    switch (format) {
+        case PixelFormat::kBGR:
+        case PixelFormat::kRGB:    type = CV_8UC3; break;
+        case PixelFormat::kBGRA:   type = CV_8UC4; break;
+        case PixelFormat::kGRAY16: type = CV_16UC1; break;
+        case PixelFormat::kYUYV:
+        case PixelFormat::kUYVY:   type = CV_8UC2; break;
+        default:                   break;
+    }
+    const int rows = (format == PixelFormat::kI420 || format == PixelFormat::kNV12) ? height * 3 / 2 : height;
+    cv::Mat padded(rows, width + 16, type);
+    cv::randu(padded, cv::Scalar::all(0), cv::Scalar::all(type == CV_16UC1 ? 65535 : 255));
+    return padded(cv::Rect(0, 0, width, rows));
+}
+
+}  // namespace
+
+// ---------------------------------------------------------------------------
+// CustomVideoSource::PushFrame conversion
+// ---------------------------------------------------------------------------
+
+static void BM_PushFrame_BGR(benchmark::State& state) {
+    const int width = state.range(0);
+    const int height = state.range(1);
+    rtc::scoped_refptr<CustomVideoSource> source(new rtc::RefCountedObject<CustomVideoSource>());
+    cv::Mat frame = randomMat(width, height, CV_8UC3);
+
+    uint64_t frame_id = 0;
+    for (auto _ : state) {
+        source->PushFrame(frame, ++frame_id);
+    }
+    state.SetBytesProcessed(state.iterations() * frame.total() * frame.elemSize());
+}
+BENCHMARK(BM_PushFrame_BGR)->Apply(Resolutions);
+
+static void BM_PushFrame_GRAY(benchmark::State& state) {
+    const int width = state.range(0);
+    const int height = state.range(1);
+    rtc::scoped_refptr<CustomVideoSource> source(new rtc::RefCountedObject<CustomVideoSource>());
+    cv::Mat frame = randomMat(width, height, CV_8UC1);
+
+    uint64_t frame_id = 0;
+    for (auto _ : state) {
+        source->PushFrame(frame, ++frame_id);
+    }
+    state.SetBytesProcessed(state.iterations() * frame.total() * frame.elemSize());
+}
+BENCHMARK(BM_PushFrame_GRAY)->Apply(Resolutions);
+
+static void BM_PushFrame_YUYV(benchmark::State& state) {
+    const int width = state.range(0);
+    const int height = state.range(1);
+    rtc::scoped_refptr<CustomVideoSource> source(new rtc::RefCountedObject<CustomVideoSource>());
+    cv::Mat frame = randomMat(width, height, CV_8UC2);
+
+    uint64_t frame_id = 0;
+    for (auto _ : state) {
+        source->PushFrame(frame, PixelFormat::kYUYV, ++frame_id);
+    }
+    state.SetBytesProcessed(state.iterations() * frame.total() * frame.elemSize());
+}
+BENCHMARK(BM_PushFrame_YUYV)->Apply(Resolutions);
+
+static void BM_PushFrame_NV12(benchmark::State& state) {
+    const int width = state.range(0);
+    const int height = state.range(1);
+    rtc::scoped_refptr<CustomVideoSource> source(new rtc::RefCountedObject<CustomVideoSource>());
+    cv::Mat frame = randomMat(width, height * 3 / 2, CV_8UC1);
+
+    uint64_t frame_id = 0;
+    for (auto _ : state) {
+        source->PushFrame(frame, PixelFormat::kNV12, ++frame_id);
+    }
+    state.SetBytesProcessed(state.iterations() * frame.total() * frame.elemSize());
+}
+BENCHMARK(BM_PushFrame_NV12)->Apply(Resolutions);
+
+// UVC 相机常见的 4:2:2 MJPEG；第三个参数为 DCT 缩放目标的分母（1 = 原始分辨率）
+static void BM_PushFrame_MJPEG(benchmark::State& state) {
+    const int width = state.range(0);
+    const int height = state.range(1);
+    const int scale = state.range(2);
+    rtc::scoped_refptr<CustomVideoSource> source(new rtc::RefCountedObject<CustomVideoSource>());
+    if (scale > 1) {
+        source->setMjpegTargetResolution(width / scale, height / scale);
+    }
+
+    TestPatternSource pattern("bars", PixelFormat::kBGR, width, height, 30);
+    pattern.initialize();
+    cv::Mat bgr;
+    pattern.getFrame(bgr);
+    std::vector<uint8_t> jpeg;
+    cv::imencode(".jpg", bgr, jpeg, {cv::IMWRITE_JPEG_QUALITY, 85,
+                                     cv::IMWRITE_JPEG_SAMPLING_FACTOR, cv::IMWRITE_JPEG_SAMPLING_FACTOR_422});
+    cv::Mat frame(1, static_cast<int>(jpeg.size()), CV_8UC1, jpeg.data());
+
+    uint64_t frame_id = 0;
+    for (auto _ : state) {
+        source->PushFrame(frame, PixelFormat::kMJPEG, ++frame_id);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PushFrame_MJPEG)
+    ->Args({1280, 720, 1})->Args({1920, 1080, 1})->Args({1920, 1080, 2})->Args({3840, 2160, 2});
+
+// 转换分派计时（正确性由 test/pixel_conversion_test.cpp 校验）。
+// YUYV / UYVY 要求偶数宽度，I420 / NV12 要求偶数宽高
+static void BM_ConvertToI420(benchmark::State& state, PixelFormat format) {
+    int width = state.range(0);
+    int height = state.range(1);
+    if (format == PixelFormat::kYUYV || format == PixelFormat::kUYVY ||
+        format == PixelFormat::kI420 || format == PixelFormat::kNV12) {
+        width &= ~1;
+    }
+    if (format == PixelFormat::kI420 || format == PixelFormat::kNV12) {
+        height &= ~1;
+    }
+    cv::Mat frame = paddedFrame(format, width, height);
+    rtc::scoped_refptr<webrtc::I420Buffer> buffer = webrtc::I420Buffer::Create(width, height);
+    if (!CustomVideoSource::convertToI420(frame, format, buffer.get())) {
+        state.SkipWithError("conversion rejected the frame");
+        return;
+    }
+
+    for (auto _ : state) {
+        CustomVideoSource::convertToI420(frame, format, buffer.get());
+        benchmark::DoNotOptimize(buffer->DataY());
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(frame.rows) * frame.cols * frame.elemSize());
+}
+static void ConversionSizes(benchmark::internal::Benchmark* b) {
+    b->Args({641, 481})->Args({1920, 1080});
+}
+BENCHMARK_CAPTURE(BM_ConvertToI420, bgr, PixelFormat::kBGR)->Apply(ConversionSizes);
+BENCHMARK_CAPTURE(BM_ConvertToI420, rgb, PixelFormat::kRGB)->Apply(ConversionSizes);
+BENCHMARK_CAPTURE(BM_ConvertToI420, bgra, PixelFormat::kBGRA)->Apply(ConversionSizes);
+BENCHMARK_CAPTURE(BM_ConvertToI420, gray8, PixelFormat::kGRAY8)->Apply(ConversionSizes);
+BENCHMARK_CAPTURE(BM_ConvertToI420, gray16, PixelFormat::kGRAY16)->Apply(ConversionSizes);
+BENCHMARK_CAPTURE(BM_ConvertToI420, yuyv, PixelFormat::kYUYV)->Apply(ConversionSizes);
+BENCHMARK_CAPTURE(BM_ConvertToI420, uyvy, PixelFormat::kUYVY)->Apply(ConversionSizes);
+BENCHMARK_CAPTURE(BM_ConvertToI420, nv12, PixelFormat::kNV12)->Apply(ConversionSizes);
+BENCHMARK_CAPTURE(BM_ConvertToI420, i420, PixelFormat::kI420)->Apply(ConversionSizes);
+
+// ---------------------------------------------------------------------------
+// Synthetic source (must stay far cheaper than conversion + encode)
+// ---------------------------------------------------------------------------
+
+static void BM_TestPattern(benchmark::State& state, const char* pattern, PixelFormat format) {
+    TestPatternSource source(pattern, format, state.range(0), state.range(1), 60);
+    if (!source.initialize()) {
+        state.SkipWithError("failed to initialize test pattern");
+        return;
+    }
+    cv::Mat frame;
+    for (auto _ : state) {
+        source.getFrame(frame);
+        benchmark::DoNotOptimize(frame.data);
+    }
+    state.SetBytesProcessed(state.iterations() * frame.total() * frame.elemSize());
+}
+BENCHMARK_CAPTURE(BM_TestPattern, bars_bgr, "bars", PixelFormat::kBGR)->Apply(Resolutions);
+BENCHMARK_CAPTURE(BM_TestPattern, bars_i420, "bars", PixelFormat::kI420)->Apply(Resolutions);
+BENCHMARK_CAPTURE(BM_TestPattern, noise_i420, "noise", PixelFormat::kI420)->Apply(Resolutions);
+
+// 采集线程的取帧路径：租约获取 + 归还
+static void BM_AcquireFrameLease(benchmark::State& state) {
+    TestPatternSource source("bars", PixelFormat::kI420, state.range(0), state.range(1), 60);
+    if (!source.initialize()) {
+        state.SkipWithError("failed to initialize test pattern");
+        return;
+    }
+    FrameLease lease;
+    for (auto _ : state) {
+        source.acquireFrame(lease);
+        benchmark::DoNotOptimize(lease.image().data);
+        lease.reset();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_AcquireFrameLease)->Apply(Resolutions);
+
+static void BM_PushFrame_I420(benchmark::State& state) {
+    TestPatternSource pattern("noise", PixelFormat::kI420, state.range(0), state.range(1), 60);
+    pattern.initialize();
+    cv::Mat frame;
+    pattern.getFrame(frame);
+    rtc::scoped_refptr<CustomVideoSource> source(new rtc::RefCountedObject<CustomVideoSource>());
+
+    uint64_t frame_id = 0;
+    for (auto _ : state) {
+        source->PushFrame(frame, PixelFormat::kI420, ++frame_id);
+    }
+    state.SetBytesProcessed(state.iterations() * frame.total() * frame.elemSize());
+}
+BENCHMARK(BM_PushFrame_I420)->Apply(Resolutions);
+
+// 数字变焦：中心 1/2 窗口缩放回源分辨率（YUYV 走区域转换 + 缩放，I420 直接缩放）
+static void BM_PushFrame_CropZoom(benchmark::State& state, PixelFormat format) {
+    const int width = state.range(0);
+    const int height = state.range(1);
+    rtc::scoped_refptr<CustomVideoSource> source(new rtc::RefCountedObject<CustomVideoSource>());
+    CropConfig crop;
+    crop.x = 0.25;
+    crop.y = 0.25;
+    crop.width = 0.5;
+    crop.height = 0.5;
+    crop.output_width = width;
+    crop.output_height = height;
+    source->setCropConfig(crop);
+    cv::Mat frame = format == PixelFormat::kYUYV ? randomMat(width, height, CV_8UC2)
+                                                  : randomMat(width, height * 3 / 2, CV_8UC1);
+
+    uint64_t frame_id = 0;
+    for (auto _ : state) {
+        source->PushFrame(frame, format, ++frame_id);
+    }
+    state.SetBytesProcessed(state.iterations() * frame.total() * frame.elemSize());
+}
+BENCHMARK_CAPTURE(BM_PushFrame_CropZoom, yuyv, PixelFormat::kYUYV)->Apply(Resolutions);
+BENCHMARK_CAPTURE(BM_PushFrame_CropZoom, i420, PixelFormat::kI420)->Apply(Resolutions);
+
+// ---------------------------------------------------------------------------
+// Overlay / static-scene detection / depth colorization
+// ---------------------------------------------------------------------------
+
+static void BM_TimestampOverlay(benchmark::State& state) {
+    cv::Mat frame = randomMat(state.range(0), state.range(1), CV_8UC3);
+    for (auto _ : state) {
+        drawTimestampOverlay(frame);
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_TimestampOverlay)->Apply(Resolutions);
+
+// 静止画面：每帧都走完缩小 + 全部块 SAD（最坏情况，没有提前退出）
+static void BM_StaticSceneDetect(benchmark::State& state) {
+    cv::Mat frame = randomMat(state.range(0), state.range(1), CV_8UC1);
+    StaticSceneConfig config;
+    config.enabled = true;
+    StaticSceneDetector detector(config);
+    int64_t now_us = 0;
+    for (auto _ : state) {
+        now_us += 33333;
+        benchmark::DoNotOptimize(detector.shouldDeliver(frame.data, static_cast<int>(frame.step),
+                                                        frame.cols, frame.rows, now_us));
+    }
+    state.SetBytesProcessed(state.iterations() * frame.total());
+}
+BENCHMARK(BM_StaticSceneDetect)->Apply(Resolutions);
+
+static void BM_DepthColorize(benchmark::State& state) {
+    cv::Mat depth(state.range(1), state.range(0), CV_16UC1);
+    cv::randu(depth, cv::Scalar(0), cv::Scalar(6000));   // 0 - 6 m (D455 量程)
+    std::vector<uint32_t> histogram(0x10000);
+    cv::Mat normalized;
+    cv::Mat colored;
+
+    for (auto _ : state) {
+        colorizeDepth(depth, histogram, normalized, colored);
+        benchmark::DoNotOptimize(colored.data);
+    }
+    state.SetBytesProcessed(state.iterations() * depth.total() * depth.elemSize());
+}
+BENCHMARK(BM_DepthColorize)->Apply(Resolutions);
+
+// 一个 10 ms 批次：250 Hz accel + 400 Hz gyro，30 fps 帧元数据
+static void BM_TelemetryPack(benchmark::State& state) {
+    std::vector<ImuSample> imu;
+    for (int i = 0; i < 7; i++) {
+        imu.push_back({1000000 + i * 1400, i % 3 == 0 ? ImuSample::kAccel : ImuSample::kGyro,
+                       0.01f * i, -9.81f, 0.02f});
+    }
+    std::vector<FrameMetadataSample> metadata = {{1003000, 42, 8000, 64, 150, 123456789}};
+    uint16_t sequence = 0;
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(SensorTelemetry::pack(imu, metadata, sequence));
+    }
+}
+BENCHMARK(BM_TelemetryPack);
+
+// ---------------------------------------------------------------------------
+// Signaling
+// ---------------------------------------------------------------------------
+
+static void BM_EncodeWebSocketFrame(benchmark::State& state) {
+    std::string message(state.range(0), 'x');
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(encodeWebSocketFrame(message));
+    }
+    state.SetBytesProcessed(state.iterations() * message.size());
+}
+BENCHMARK(BM_EncodeWebSocketFrame)->Arg(64)->Arg(1024)->Arg(4096)->Arg(60000);
+
+static void BM_DecodeWebSocketFrame(benchmark::State& state) {
+    std::string frame = encodeWebSocketFrame(std::string(state.range(0), 'x'));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(decodeWebSocketFrame(frame.data(), frame.size()));
+    }
+    state.SetBytesProcessed(state.iterations() * frame.size());
+}
+BENCHMARK(BM_DecodeWebSocketFrame)->Arg(64)->Arg(1024)->Arg(4096)->Arg(60000);
+
+static void BM_EscapeJsonString(benchmark::State& state) {
+    std::string sdp = sampleOfferSdp();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(escapeJsonString(sdp));
+    }
+    state.SetBytesProcessed(state.iterations() * sdp.size());
+}
+BENCHMARK(BM_EscapeJsonString);
+
+static void BM_ForceSendOnlyDirection(benchmark::State& state) {
+    const std::string original = sampleOfferSdp();
+    for (auto _ : state) {
+        std::string sdp = original;
+        benchmark::DoNotOptimize(forceSendOnlyDirection(sdp));
+    }
+}
+BENCHMARK(BM_ForceSendOnlyDirection);
+
+// OnOfferCreated 的完整 munging 流程：改写方向属性 + 重新解析 + 序列化
+static void BM_OfferSdpMunging(benchmark::State& state) {
+    const std::string original = sampleOfferSdp();
+    for (auto _ : state) {
+        std::string sdp = original;
+        forceSendOnlyDirection(sdp);
+
+        webrtc::SdpParseError error;
+        std::unique_ptr<webrtc::SessionDescriptionInterface> desc =
+            webrtc::CreateSessionDescription(webrtc::SdpType::kOffer, sdp, &error);
+        if (!desc) {
+            state.SkipWithError(error.description.c_str());
+            break;
+        }
+
+        std::string final_sdp;
+        desc->ToString(&final_sdp);
+        benchmark::DoNotOptimize(final_sdp);
+    }
+}
+BENCHMARK(BM_OfferSdpMunging);
+
+// ---------------------------------------------------------------------------
+// Logging (cost paid by the capture / encoder threads)
+// ---------------------------------------------------------------------------
+
+// 低于运行时级别：一次原子读，不格式化
+static void BM_LogFiltered(benchmark::State& state) {
+    LogConfig config;
+    config.level = "info";
+    Logger::instance().configure(config);
+    uint64_t frame_id = 0;
+    for (auto _ : state) {
+        LOG_DEBUG("📺 Pushed frame " << ++frame_id << " to WebRTC");
+    }
+}
+BENCHMARK(BM_LogFiltered);
+
+// 逐帧消息限速：绝大多数调用只更新省略计数
+static void BM_LogRateLimited(benchmark::State& state) {
+    LogConfig config;
+    config.level = "info";
+    Logger::instance().configure(config);
+    uint64_t frame_id = 0;
+    for (auto _ : state) {
+        LOG_EVERY_MS(LogLevel::kInfo, 1000, "📹 Captured " << ++frame_id << " frames");
+    }
+}
+BENCHMARK(BM_LogRateLimited)->Threads(1)->Threads(4);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,91 @@
+#ifndef ADAPTATION_CONTROLLER_H
+#define ADAPTATION_CONTROLLER_H
+
+#include "config_parser.h"
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Link state sampled from PeerConnection::GetStats (-1 = not reported yet)
+ */
+struct LinkStats {
+    double rtt_ms;                          // remote-inbound-rtp / candidate-pair RTT
+    double loss;                            // 接收端报告的丢包率 0-1（最近一个 RTCP RR）
+    int64_t available_bitrate_bps;          // candidate-pair availableOutgoingBitrate（BWE）
+    int64_t sent_bitrate_bps;               // 两次采样间 outbound-rtp bytesSent 的增量
+    std::string quality_limitation;         // none | bandwidth | cpu | other
+
+    LinkStats() : rtt_ms(-1), loss(-1), available_bitrate_bps(-1), sent_bitrate_bps(-1) {}
+};
+
+/**
+ * @brief One step of the adaptation ladder
+ */
+struct AdaptationLevel {
+    double scale;           // scale_resolution_down_by
+    double fps_factor;      // 乘以源帧率得到 max_framerate
+};
+
+/**
+ * @brief Steers resolution and frame rate from RTT / loss / BWE samples
+ *
+ * The policy picks a ladder of (scale, fps) levels: "maintain-framerate"
+ * gives up resolution first, "maintain-resolution" frame rate first, and
+ * "latency-first" drops both together, treats queueing delay (RTT more
+ * than 50 ms above the lowest RTT seen) as congestion and steps down two
+ * levels at a time when RTT is above twice max_rtt_ms.
+ *
+ * Congestion is decided from RTT, loss and the sent bitrate overshooting
+ * the bandwidth estimate only. WebRTC's qualityLimitationReason is not a
+ * trigger: it reads "bandwidth" throughout BWE ramp-up and whenever
+ * WebRTC's own degradation is active. It only breaks ties: no up-step is
+ * taken while the encoder reports "cpu".
+ *
+ * Down-steps need two consecutive congested samples (so a 500 ms interval
+ * reacts within a second), up-steps need upgrade_hold_ms of clean samples
+ * and BWE headroom. An up-step that is followed by congestion within the
+ * hold time doubles the hold (up to 60 s), so the controller does not
+ * keep probing a level the link cannot carry. Every level change is
+ * logged to stdout and, if configured, appended as a JSON line to
+ * log_file.
+ *
+ * Not thread-safe; WebRTCClient calls it from the stats callback.
+ */
+class AdaptationController {
+public:
+    explicit AdaptationController(const AdaptationConfig& config);
+
+    /**
+     * @brief Feed one stats sample
+     * @param now_ms Monotonic time of the sample
+     * @return true if the level changed
+     */
+    bool update(const LinkStats& stats, int64_t now_ms);
+
+    const AdaptationLevel& level() const { return ladder_[level_]; }
+
+    // WebRTC 内部降级策略，与本控制器的取舍保持一致
+    std::string degradationPreference() const;
+
+private:
+    bool isCongested(const LinkStats& stats, std::string& reason) const;
+    bool hasHeadroom(const LinkStats& stats) const;
+    void changeLevel(size_t level, const LinkStats& stats, const std::string& reason, int64_t now_ms);
+
+    static constexpr int64_t kMaxHoldMs = 60000;
+    static constexpr double kOvershootRatio = 1.2;   // 发送码率超过带宽估计的比例
+
+    AdaptationConfig config_;
+    std::vector<AdaptationLevel> ladder_;
+    size_t level_;
+    int congested_samples_;
+    int64_t clean_since_ms_;                // 连续无拥塞的起点，-1 = 当前拥塞
+    int64_t last_upgrade_ms_;
+    int64_t hold_ms_;                       // 当前升档等待时间（退避后可能大于配置值）
+    double min_rtt_ms_;                     // 见过的最小 RTT，latency-first 以此判断排队
+    std::ofstream log_;
+};
+
+#endif // ADAPTATION_CONTROLLER_H
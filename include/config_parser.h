@@ -30,19 +30,39 @@ struct WebRTCConfig {
     std::string client_id;      // 客户端 ID
     std::string target_id;      // 目标接收方 ID（可选，为空则广播）
     std::vector<IceServer> ice_servers;
+    bool control_channel;       // 创建 "control" DataChannel，运行时调整码率/帧率/分辨率/裁剪
     
     WebRTCConfig() : server_ip("192.168.1.34"), server_port(50061),
-                     client_id("sender_001"), target_id("") {
+                     client_id("sender_001"), target_id(""), control_channel(true) {
         // 默认添加 Google STUN 服务器
         std::vector<std::string> stun_urls = {"stun:stun.l.google.com:19302"};
         ice_servers.push_back(IceServer(stun_urls));
     }
 };
 
+/**
+ * @brief Digital pan/zoom: region of interest cropped and scaled before encode
+ */
+struct CropConfig {
+    double x;                       // 裁剪窗口（归一化 [0, 1]），默认整幅画面
+    double y;
+    double width;
+    double height;
+    int output_width;               // 输出分辨率，0 = 与源相同（窗口变化时编码分辨率不变）
+    int output_height;
+    int transition_ms;              // 窗口变化的平滑过渡时间，0 = 立即切换
+    
+    CropConfig() : x(0), y(0), width(1.0), height(1.0),
+                   output_width(0), output_height(0), transition_ms(300) {}
+    
+    bool isFullFrame() const { return x <= 0 && y <= 0 && width >= 1.0 && height >= 1.0; }
+};
+
 /**
  * @brief Video source configuration
  */
 struct VideoConfig {
+    std::string name;               // 轨道 ID（多路视频时区分各路，空则自动命名）
     std::string source;
     int width;
     int height;
@@ -50,30 +70,257 @@ struct VideoConfig {
     int device_id;
     std::string file_path;
     bool enable_depth;
+    std::string pattern;            // 测试图案: bars|box|noise|static (source = pattern)
+    std::string pattern_format;     // 测试图案输出格式: bgr|i420
+    std::string shm_name;           // 共享内存帧环名称或路径 (source = shm)
+    std::string v4l2_format;        // V4L2 像素格式: yuyv|uyvy|nv12|grey|y16|mjpeg (source = v4l2)
+    int v4l2_buffers;               // V4L2 mmap 缓冲区数量
+    int mjpeg_scale_width;          // MJPEG DCT 缩放解码目标宽度，0 表示原始分辨率
+    int mjpeg_scale_height;         // MJPEG DCT 缩放解码目标高度
+    double bitrate_priority;        // 共享拥塞控制下的相对码率权重 (RtpEncodingParameters::bitrate_priority)
+    CropConfig crop;                // 数字变焦：编码前裁剪并缩放感兴趣区域
+    bool timestamp_overlay;         // 在画面上叠加采集时间戳（画在转换后的 I420 上）
     
     VideoConfig() : source("realsense"), width(640), height(480), 
-                    fps(30), device_id(0), enable_depth(false) {}
+                    fps(30), device_id(0), enable_depth(false),
+                    pattern("bars"), pattern_format("bgr"), shm_name("/webrtc_frames"),
+                    v4l2_format("yuyv"), v4l2_buffers(4),
+                    mjpeg_scale_width(0), mjpeg_scale_height(0), bitrate_priority(1.0),
+                    timestamp_overlay(true) {}
+};
+
+/**
+ * @brief Mosaic tile rectangle on the output canvas
+ */
+struct MosaicTile {
+    int x;
+    int y;
+    int width;
+    int height;
+    
+    MosaicTile() : x(0), y(0), width(0), height(0) {}
+    MosaicTile(int x_, int y_, int w, int h) : x(x_), y(y_), width(w), height(h) {}
+};
+
+/**
+ * @brief Mosaic compositor configuration (all video sources → one stream)
+ */
+struct MosaicConfig {
+    bool enabled;
+    int width;                      // 画布分辨率
+    int height;
+    int fps;                        // 画布输出帧率
+    std::string layout;             // grid | pip | custom
+    bool keep_aspect;               // 保持源宽高比（黑边），否则拉伸填满
+    std::vector<MosaicTile> tiles;  // layout = custom 时按视频源顺序给出各自区域
+    
+    MosaicConfig() : enabled(false), width(1280), height(720), fps(30),
+                     layout("grid"), keep_aspect(true) {}
+};
+
+/**
+ * @brief Static-scene frame skipping (per video track)
+ */
+struct StaticSceneConfig {
+    bool enabled;
+    double threshold;       // 任一分析块的平均亮度差（0-255）超过该值即视为运动
+    int hold_ms;            // 持续静止多久后开始降帧率
+    int keepalive_fps;      // 静止时的最低发送帧率
+    
+    StaticSceneConfig() : enabled(false), threshold(3.0), hold_ms(2000), keepalive_fps(1) {}
+};
+
+/**
+ * @brief RealSense IMU and frame-metadata side channel
+ */
+struct TelemetryConfig {
+    bool enabled;
+    bool imu;               // 陀螺仪 + 加速度计（需要带 IMU 的型号，如 D455 / D435i）
+    bool metadata;          // 每帧元数据：曝光、增益、激光功率、传感器时间戳
+    int accel_fps;          // 加速度计采样率，D455: 63 | 250
+    int gyro_fps;           // 陀螺仪采样率，D455: 200 | 400
+    int packet_rate_hz;     // 打包发送频率，批量间隔即附加延迟（100 Hz = 10 ms）
+    
+    TelemetryConfig() : enabled(false), imu(true), metadata(true),
+                        accel_fps(250), gyro_fps(200), packet_rate_hz(100) {}
+};
+
+/**
+ * @brief Application-level adaptation of resolution / frame rate from link stats
+ */
+struct AdaptationConfig {
+    bool enabled;
+    std::string policy;         // maintain-framerate | maintain-resolution | latency-first
+    int interval_ms;            // GetStats 采样间隔，连续两次拥塞才降档
+    int max_rtt_ms;             // RTT 超过该值视为拥塞
+    double max_loss;            // 丢包率（0-1）超过该值视为拥塞
+    int upgrade_hold_ms;        // 持续无拥塞多久后升一档
+    std::string log_file;       // 决策日志（JSON Lines），空 = 只打印到控制台
+    
+    AdaptationConfig() : enabled(false), policy("maintain-framerate"), interval_ms(500),
+                         max_rtt_ms(250), max_loss(0.05), upgrade_hold_ms(5000) {}
+};
+
+/**
+ * @brief Loss protection, codec preference and bitrate limits
+ */
+struct ResilienceConfig {
+    std::vector<std::string> codec_preferences; // 编码格式优先顺序，如 ["H264", "VP8"]；空 = WebRTC 默认
+    bool nack;                  // 接收端 NACK 请求重传
+    bool rtx;                   // 重传走独立的 RTX 流（关闭后 NACK 重传复用原 SSRC）
+    bool red_ulpfec;            // RED + ULPFEC 前向纠错
+    bool flexfec;               // FlexFEC-03（需 field trial，对突发丢包更有效）
+    int start_bitrate_kbps;     // 带宽估计的起始/下限/上限，0 = WebRTC 默认
+    int min_bitrate_kbps;
+    int max_bitrate_kbps;
+    
+    ResilienceConfig() : nack(true), rtx(true), red_ulpfec(true), flexfec(false),
+                         start_bitrate_kbps(0), min_bitrate_kbps(0), max_bitrate_kbps(0) {}
+};
+
+/**
+ * @brief VP8 (libvpx) encoder tuning
+ */
+struct Vp8EncoderConfig {
+    int threads;                // 传给编码器的核数，libvpx 按分辨率决定实际线程数；0 = 全部 CPU
+    std::string complexity;     // normal | high | higher | max（cpu-used -6 / -5 / -4 / -3）
+    
+    Vp8EncoderConfig() : threads(0), complexity("normal") {}
+};
+
+/**
+ * @brief H.264 encoder tuning
+ */
+struct H264EncoderConfig {
+    std::string implementation; // openh264（WebRTC 内置，单线程单 slice）| libx264（经 FFmpeg）
+    int threads;                // libx264 slice 线程数，0 = 全部 CPU
+    std::string preset;         // libx264 preset: ultrafast | superfast | veryfast | faster | fast | medium
+    int slices;                 // libx264 每帧 slice 数，0 = 与线程数相同
+    int vbv_ms;                 // libx264 VBV 缓冲时长，0 = 一帧（每帧大小接近平均值，排队延迟最小）
+    bool intra_refresh;         // libx264 周期性帧内刷新：只有首帧和 PLI 是 IDR，不再有大关键帧
+    
+    H264EncoderConfig() : implementation("openh264"), threads(0), preset("veryfast"), slices(0),
+                          vbv_ms(500), intra_refresh(false) {}
+};
+
+/**
+ * @brief Encoder configuration
+ */
+struct EncoderConfig {
+    Vp8EncoderConfig vp8;
+    H264EncoderConfig h264;
+    std::string degradation_preference; // CPU/带宽不足时: balanced | maintain_resolution | maintain_framerate
+    int playout_delay_ms;       // 经 playout-delay RTP 扩展要求接收端播放延迟 min=max=该值，-1 = 由接收端决定
+    
+    EncoderConfig() : degradation_preference("balanced"), playout_delay_ms(-1) {}
+};
+
+/**
+ * @brief Name, CPU affinity and scheduling policy of one thread role
+ */
+struct ThreadSettings {
+    std::string name;           // 线程名（最长 15 字符），空则使用默认名
+    std::vector<int> cpus;      // 允许运行的 CPU，空表示不限制
+    std::string policy;         // other | fifo | rr（fifo/rr 需要 CAP_SYS_NICE）
+    int priority;               // SCHED_FIFO / SCHED_RR 优先级 1-99
+    
+    ThreadSettings() : policy("other"), priority(0) {}
+    
+    // 未做任何配置（保持系统/WebRTC 默认）
+    bool isDefault() const { return name.empty() && cpus.empty() && policy == "other"; }
+};
+
+/**
+ * @brief Thread model configuration
+ */
+struct ThreadConfig {
+    ThreadSettings capture;     // 采集线程（每路视频一个，帧格式转换也在其中进行）
+    ThreadSettings encoder;     // WebRTC 编码队列线程
+    ThreadSettings network;     // WebRTC network 线程（socket / 打包发送）
+    ThreadSettings worker;      // WebRTC worker 线程（媒体引擎）
+    ThreadSettings signaling;   // WebSocket 信令线程与 WebRTC signaling 线程
+    ThreadSettings adaptation;  // 自适应控制轮询线程（默认调度，不继承 signaling 的设置）
 };
 
 /**
  * @brief Logging configuration
  */
 struct LogConfig {
-    std::string level;
+    std::string level;              // trace | debug | info | warn | error | off
     bool enable_timestamp;
+    std::string format;             // text | json（每行一个 JSON 对象）
+    
+    LogConfig() : level("info"), enable_timestamp(true), format("text") {}
+};
+
+/**
+ * @brief Latency tracing configuration
+ */
+struct TracingConfig {
+    bool enabled;
+    std::string output_file;    // Chrome trace_event JSON 输出路径
+    
+    TracingConfig() : enabled(false), output_file("latency_trace.json") {}
+};
+
+/**
+ * @brief Encoded-stream recording configuration
+ */
+struct RecordingConfig {
+    bool enabled;
+    std::string directory;      // 输出目录
+    std::string prefix;         // 文件名前缀，后接时间戳
+    std::string format;         // mkv | mp4（分片 MP4）
+    int segment_seconds;        // 分段时长，到期后在下一个关键帧切换文件
+    int max_queue_mb;           // 写盘队列上限，超出则丢帧直到下一个关键帧
     
-    LogConfig() : level("info"), enable_timestamp(true) {}
+    RecordingConfig() : enabled(false), directory("recordings"), prefix("stream"),
+                        format("mkv"), segment_seconds(300), max_queue_mb(32) {}
 };
 
 /**
  * @brief Application configuration
  */
 struct AppConfig {
+    std::string latency_mode;               // normal | ultra（见 applyLatencyProfile）
+    bool hot_reload;                        // 监视配置文件，修改后不重启直接应用可在线生效的设置
     WebRTCConfig webrtc;
-    VideoConfig video;
+    VideoConfig video;                      // 主视频源（命令行参数作用于它）
+    std::vector<VideoConfig> extra_videos;  // "video" 为数组时的其余视频源，与主视频共用一个 PeerConnection
+    MosaicConfig mosaic;                    // 启用时所有视频源合成一路画面
+    StaticSceneConfig static_scene;         // 画面静止时降低发送帧率
+    TelemetryConfig telemetry;              // RealSense IMU / 帧元数据，经无序不可靠 DataChannel 发送
+    AdaptationConfig adaptation;            // 按 RTT / 丢包调整分辨率与帧率
+    ResilienceConfig resilience;            // FEC / RTX / NACK、编码格式优先级与码率范围
+    ThreadConfig threads;
+    EncoderConfig encoder;
     LogConfig logging;
+    TracingConfig tracing;
+    RecordingConfig recording;
+    
+    AppConfig() : latency_mode("normal"), hot_reload(true) {}
 };
 
+/**
+ * @brief Expand latency_mode into the individual settings it stands for
+ *
+ * "ultra" trades smoothness for latency (teleoperation on a LAN):
+ * zero playout delay, libx264 preferred with a one-frame VBV and periodic
+ * intra refresh instead of large IDR frames. Capture-side settings
+ * (newest frame only) are applied to the sources by the caller. Call
+ * after the config file and command line have been applied; settings the
+ * profile does not touch keep their configured values.
+ * @return false if latency_mode is unknown (config left unchanged)
+ */
+bool applyLatencyProfile(AppConfig& config);
+
+/**
+ * @brief Config file fields a latency profile overrides unconditionally
+ * @param latency_mode Profile name (normal | ultra)
+ * @return Dotted field names as reported by ConfigParser::changedFields
+ */
+std::vector<std::string> latencyProfileFields(const std::string& latency_mode);
+
 /**
  * @brief Configuration parser class
  */
@@ -111,9 +358,20 @@ public:
      * @return true if successful
      */
     static bool createDefaultConfig(const std::string& config_file);
+    
+    /**
+     * @brief Fields whose value differs between the files two parsers loaded
+     * @param other Parser that loaded the newer version of the file
+     * @return Dotted field names, each listed once. Array indices are dropped
+     *         ("webrtc.ice_servers.urls") except for the sources of a "video"
+     *         array: the first is named like a single object ("video.crop.x"),
+     *         the others keep their index ("video.1.crop.x")
+     */
+    std::vector<std::string> changedFields(const ConfigParser& other) const;
 
 private:
     AppConfig config_;
+    std::string document_;      // 最近一次成功解析的 JSON（紧凑格式），供 changedFields 比较
 };
 
 #endif // CONFIG_PARSER_H
@@ -0,0 +1,44 @@
+#ifndef CONFIG_WATCHER_H
+#define CONFIG_WATCHER_H
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+
+/**
+ * @brief Watches one file with inotify and reports when it has been rewritten
+ *
+ * The containing directory is watched rather than the file itself, so
+ * editors that save by writing a temporary file and renaming it over the
+ * original (vim, most config management tools) are seen as well. Events
+ * are debounced: the callback runs on the watcher thread once no further
+ * write to the file has been seen for kDebounceMs.
+ */
+class ConfigWatcher {
+public:
+    using Callback = std::function<void()>;
+
+    ConfigWatcher(const std::string& path, Callback on_change);
+    ~ConfigWatcher();
+
+    bool start();
+    void stop();
+
+private:
+    static constexpr int kDebounceMs = 300;
+    static constexpr int kPollTimeoutMs = 100;
+
+    void watchThread();
+
+    std::string path_;
+    std::string directory_;
+    std::string file_name_;
+    Callback on_change_;
+
+    int inotify_fd_;
+    std::atomic<bool> should_stop_;
+    std::thread thread_;
+};
+
+#endif // CONFIG_WATCHER_H
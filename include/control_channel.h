@@ -0,0 +1,72 @@
+#ifndef CONTROL_CHANNEL_H
+#define CONTROL_CHANNEL_H
+
+#include <api/data_channel_interface.h>
+#include <api/scoped_refptr.h>
+#include <functional>
+#include <string>
+
+/**
+ * @brief One runtime control command received over the control DataChannel
+ *
+ * Wire format (UTF-8 JSON text message), e.g.
+ *   {"cmd": "bitrate", "max_kbps": 800}
+ *   {"cmd": "fps", "max_fps": 10, "track": "video_track_1"}
+ *   {"cmd": "scale", "factor": 2}
+ *   {"cmd": "crop", "x": 0.25, "y": 0.25, "width": 0.5, "height": 0.5}
+ *   {"cmd": "crop"}                      (back to the full frame)
+ *   {"cmd": "keyframe"}
+ * "track" selects one track by id; without it the command applies to all.
+ * "keyframe" always applies to every track of the connection and rejects
+ * "track".
+ */
+struct ControlCommand {
+    std::string cmd;            // bitrate | fps | scale | crop | keyframe
+    std::string track;          // 轨道 ID，空 = 所有轨道
+    int max_kbps;               // bitrate: 0 = 不限制
+    double max_fps;             // fps: 0 = 不限制
+    double scale;               // scale: 分辨率缩小倍数，>= 1
+    double crop_x;              // crop: 归一化窗口 [0, 1]，默认整幅画面
+    double crop_y;
+    double crop_width;
+    double crop_height;
+
+    ControlCommand() : max_kbps(0), max_fps(0), scale(1.0),
+                       crop_x(0), crop_y(0), crop_width(1.0), crop_height(1.0) {}
+};
+
+/**
+ * @brief Observer for the "control" DataChannel
+ *
+ * Parses each text message into a ControlCommand, passes it to the handler
+ * (called on the WebRTC signaling thread) and replies with
+ * {"type": "ack", "cmd": ..., "ok": true|false, "error": ...}.
+ */
+class ControlChannel : public webrtc::DataChannelObserver {
+public:
+    // 返回 false 时 error 说明原因，会原样回复给对端
+    using Handler = std::function<bool(const ControlCommand& command, std::string& error)>;
+
+    ControlChannel(rtc::scoped_refptr<webrtc::DataChannelInterface> channel, Handler handler);
+    ~ControlChannel() override;
+
+    /**
+     * @brief Parse one JSON command
+     * @return false (with error set) for malformed JSON, unknown commands or out-of-range values
+     */
+    static bool parseCommand(const std::string& text, ControlCommand& command, std::string& error);
+
+    std::string label() const { return channel_->label(); }
+
+    // DataChannelObserver implementation
+    void OnStateChange() override;
+    void OnMessage(const webrtc::DataBuffer& buffer) override;
+
+private:
+    void reply(const std::string& cmd, bool ok, const std::string& error);
+
+    rtc::scoped_refptr<webrtc::DataChannelInterface> channel_;
+    Handler handler_;
+};
+
+#endif // CONTROL_CHANNEL_H
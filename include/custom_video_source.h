@@ -5,12 +5,24 @@
 #include <api/video/video_source_interface.h>
 #include <media/base/adapted_video_track_source.h>
 #include <rtc_base/ref_counted_object.h>
+#include <common_video/include/video_frame_buffer_pool.h>
 #include <opencv2/opencv.hpp>
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <vector>
+#include "mjpeg_decoder.h"
+#include "pixel_format.h"
+#include "static_scene_detector.h"
 
 /**
  * @brief Custom video source for WebRTC
  * Adapts OpenCV Mat frames to WebRTC video frames
+ *
+ * Every uncompressed frame, whatever its source, is converted here in a
+ * single pass straight into a pooled I420 buffer (libyuv picks the SIMD
+ * kernels for the running CPU). Adding a pixel format means adding one
+ * entry to the conversion table, not another copy.
  */
 class CustomVideoSource : public rtc::AdaptedVideoTrackSource {
 public:
@@ -18,7 +30,60 @@ public:
     ~CustomVideoSource() override = default;
     
     // Push a new frame to the source
-    void PushFrame(const cv::Mat& frame);
+    // frame_id: capture sequence number, used to correlate latency traces
+    // capture_time_us: CLOCK_MONOTONIC capture time (e.g. kernel timestamp), 0 = now
+    void PushFrame(const cv::Mat& frame, PixelFormat format, uint64_t frame_id = 0,
+                   int64_t capture_time_us = 0);
+    
+    // Push a BGR (CV_8UC3), BGRA (CV_8UC4) or grayscale (CV_8UC1 / CV_16UC1) frame
+    void PushFrame(const cv::Mat& frame, uint64_t frame_id = 0);
+    
+    // MJPEG: decode at the smallest DCT scale covering width x height (0 = full size)
+    void setMjpegTargetResolution(int width, int height);
+    
+    // Skip frames of an unchanging scene down to config.keepalive_fps; name is used in logs
+    // ignore_region: area that changes every frame regardless of the scene (e.g. timestamp overlay)
+    void enableStaticSceneDetection(const StaticSceneConfig& config, const std::string& name,
+                                    const cv::Rect& ignore_region = cv::Rect());
+    
+    // Draw the wall-clock time into each output frame. Drawn on the converted I420 buffer, so the
+    // source's buffers (driver, SDK or shared memory) are never written. Thread-safe.
+    void setTimestampOverlay(bool enable) { timestamp_overlay_ = enable; }
+    
+    // Digital pan/zoom: initial window, fixed output size and transition time; jumps to the window
+    void setCropConfig(const CropConfig& config);
+    
+    // Move the crop window (x, y, width, height in [0, 1]) smoothly over the configured
+    // transition; (0, 0, 1, 1) sends the full frame. Thread-safe.
+    void setCropWindow(double x, double y, double width, double height);
+    
+    // Deliver the most recent frame again with a current timestamp, so an encoder that was
+    // asked for a key frame produces it now instead of at the next capture. Thread-safe.
+    void repeatLastFrame();
+    
+    // Plane pointers of a stacked I420 frame (see PixelFormat::kI420)
+    struct I420Planes {
+        const uint8_t* y = nullptr;
+        const uint8_t* u = nullptr;
+        const uint8_t* v = nullptr;
+        int stride_y = 0;
+        int stride_uv = 0;
+        int width = 0;
+        int height = 0;
+    };
+    
+    // Locate the planes of an I420 Mat; false if its size or type cannot hold I420
+    static bool i420Planes(const cv::Mat& frame, I420Planes* planes);
+    
+    // Convert an uncompressed frame into buffer (same size as the frame); false if unsupported
+    static bool convertToI420(const cv::Mat& frame, PixelFormat format, webrtc::I420Buffer* buffer);
+    
+    // Convert only region (source pixels, even-aligned origin, any size) of an uncompressed frame
+    // into I420 planes; false if the format, Mat type and region do not fit together
+    static bool convertRegionToI420(const cv::Mat& frame, PixelFormat format, const cv::Rect& region,
+                                    uint8_t* dst_y, int dst_stride_y,
+                                    uint8_t* dst_u, int dst_stride_u,
+                                    uint8_t* dst_v, int dst_stride_v);
     
     // AdaptedVideoTrackSource implementation
     bool is_screencast() const override { return false; }
@@ -31,7 +96,50 @@ public:
     bool remote() const override { return false; }
 
 private:
+    // 静止检测：返回是否发送该帧，并在进入/退出静止状态时打印日志
+    bool checkScene(const uint8_t* y, int stride, int width, int height, int64_t now_us);
+    
+    // 裁剪输出尺寸（未配置时为源尺寸）
+    cv::Size cropOutputSize(int width, int height);
+    
+    // 窗口向目标平滑移动一步，返回本帧的源区域（输出宽高比、偶数对齐）
+    cv::Rect updateCropRect(int width, int height, const cv::Size& output, int64_t now_us);
+    
+    // 源区域一次缩放到输出尺寸；decoded 为 MJPEG 解码结果（其他格式为 nullptr）
+    rtc::scoped_refptr<webrtc::I420Buffer> cropAndScale(const cv::Mat& frame, PixelFormat format,
+                                                        const webrtc::I420Buffer* decoded,
+                                                        const cv::Rect& roi, const cv::Size& output);
+    
+    // 交给 WebRTC 并记为最近一帧；deliverFrameLocked 须持有 deliver_mutex_
+    void deliverFrame(const rtc::scoped_refptr<webrtc::VideoFrameBuffer>& buffer,
+                      uint64_t frame_id, int64_t capture_us);
+    void deliverFrameLocked(const rtc::scoped_refptr<webrtc::VideoFrameBuffer>& buffer,
+                            uint64_t frame_id, int64_t capture_us);
+    
+    // 编码队列中同时存在的帧数有限，池满说明下游卡住，直接丢帧
+    static constexpr size_t kMaxPooledBuffers = 16;
+    
+    webrtc::VideoFrameBufferPool buffer_pool_;
+    webrtc::VideoFrameBufferPool crop_pool_;    // 与 buffer_pool_ 分开，尺寸不同的缓冲区不会互相挤占
+    std::mutex crop_mutex_;
+    cv::Rect2d crop_target_;                    // 归一化目标窗口（crop_mutex_ 保护）
+    cv::Size crop_output_;
+    int crop_transition_ms_;
+    bool crop_snap_;                            // 下一帧直接跳到目标
+    cv::Rect2d crop_current_;                   // 以下仅在采集线程访问
+    int64_t crop_last_us_;
+    std::vector<uint8_t> roi_scratch_;          // 打包格式区域转换的暂存区（区域大小）
+    MjpegDecoder mjpeg_decoder_;
+    StaticSceneDetector scene_detector_;
+    std::string name_;
+    std::atomic<bool> timestamp_overlay_;
+    // 采集线程与 repeatLastFrame（signaling 线程）共用，保证时间戳单调
+    std::mutex deliver_mutex_;
+    rtc::scoped_refptr<webrtc::VideoFrameBuffer> last_buffer_;   // 占用一个池缓冲区
+    uint64_t last_frame_id_;
     int64_t timestamp_us_;
+    int frame_counter_;
+    int skipped_frames_;
 };
 
 #endif // CUSTOM_VIDEO_SOURCE_H
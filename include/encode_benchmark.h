@@ -0,0 +1,48 @@
+#ifndef ENCODE_BENCHMARK_H
+#define ENCODE_BENCHMARK_H
+
+#include "config_parser.h"
+#include "video_source.h"
+#include <atomic>
+#include <memory>
+#include <string>
+
+/**
+ * @brief Options for the headless encode benchmark (--bench)
+ */
+struct EncodeBenchmarkOptions {
+    std::string codec;      // VP8 | H264
+    int duration_s;         // 运行时长（秒），与 max_frames 先到者为准
+    int max_frames;         // 最大帧数，0 表示不限
+    int bitrate_kbps;       // 目标码率
+    EncoderConfig tuning;   // 编码器调优，与实时会话相同
+
+    EncodeBenchmarkOptions() : codec("VP8"), duration_s(10), max_frames(0), bitrate_kbps(2000) {}
+};
+
+/**
+ * @brief Headless source → convert (+ overlay) → encode benchmark
+ *
+ * Runs the same pipeline as a live session, using SimpleVideoEncoderFactory,
+ * but without signaling or network, as fast as the source delivers frames.
+ * Prints sustained fps, wall/CPU time per stage, encode time percentiles
+ * and output bitrate.
+ */
+class EncodeBenchmark {
+public:
+    EncodeBenchmark(std::shared_ptr<VideoSource> video_source,
+                    const EncodeBenchmarkOptions& options);
+
+    /**
+     * @brief Run the benchmark and print the report to stdout
+     * @param keep_running Cleared by the caller (e.g. on SIGINT) to stop early
+     * @return true if the encoder could be created and at least one frame was encoded
+     */
+    bool run(const std::atomic<bool>& keep_running);
+
+private:
+    std::shared_ptr<VideoSource> video_source_;
+    EncodeBenchmarkOptions options_;
+};
+
+#endif // ENCODE_BENCHMARK_H
@@ -0,0 +1,83 @@
+#ifndef ENCODED_RECORDER_H
+#define ENCODED_RECORDER_H
+
+#include "config_parser.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct AVFormatContext;
+struct AVStream;
+
+/**
+ * @brief One encoded video frame handed to the recorder
+ */
+struct EncodedFramePacket {
+    std::vector<uint8_t> data;
+    uint32_t rtp_timestamp;     // 90 kHz
+    bool key_frame;
+    int width;
+    int height;
+    std::string codec;          // "VP8" | "H264"
+};
+
+/**
+ * @brief Records already-encoded frames to fragmented MP4 / MKV segments
+ *
+ * push() only moves the frame into a bounded queue and never blocks; a
+ * dedicated I/O thread muxes it with libavformat. When the queue is full
+ * (slow disk) frames are dropped and recording resumes at the next key
+ * frame, so the files stay decodable. Segments rotate at the first key
+ * frame after segment_seconds.
+ */
+class EncodedRecorder {
+public:
+    explicit EncodedRecorder(const RecordingConfig& config);
+    ~EncodedRecorder();
+
+    bool start();
+    void stop();
+
+    /**
+     * @brief Queue a frame for writing (called from the encoder thread)
+     * @return false if the frame was dropped
+     */
+    bool push(EncodedFramePacket&& packet);
+
+    uint64_t droppedFrames() const { return dropped_frames_; }
+
+private:
+    void ioThread();
+    void writePacket(const EncodedFramePacket& packet);
+    bool openSegment(const EncodedFramePacket& first_key_frame);
+    void closeSegment();
+    std::string nextSegmentPath() const;
+
+    RecordingConfig config_;
+    size_t max_queue_bytes_;
+
+    std::thread io_thread_;
+    std::atomic<bool> should_stop_;
+    std::mutex queue_mutex_;
+    std::condition_variable queue_cv_;
+    std::deque<EncodedFramePacket> queue_;
+    size_t queued_bytes_;
+    bool waiting_for_key_frame_;        // 丢帧后需等待下一个关键帧
+    std::atomic<uint64_t> dropped_frames_;
+
+    // 以下成员只在 I/O 线程中访问
+    AVFormatContext* format_context_;
+    AVStream* stream_;
+    int64_t segment_start_ts_;          // 展开后的 RTP 时间戳
+    int64_t last_unwrapped_ts_;
+    uint32_t last_rtp_timestamp_;
+    uint64_t segment_frames_;
+    std::string segment_path_;
+};
+
+#endif // ENCODED_RECORDER_H
@@ -0,0 +1,76 @@
+#ifndef FFMPEG_H264_ENCODER_H
+#define FFMPEG_H264_ENCODER_H
+
+#include "config_parser.h"
+#include <api/video_codecs/video_encoder.h>
+#include <common_video/h264/h264_bitstream_parser.h>
+#include <modules/video_coding/codecs/h264/include/h264_globals.h>
+
+struct AVCodecContext;
+struct AVFrame;
+struct AVPacket;
+
+/**
+ * @brief H.264 encoder using libx264 through libavcodec
+ *
+ * WebRTC's built-in OpenH264 encoder is fixed to one thread and one slice.
+ * This encoder uses x264's sliced threading (tune=zerolatency, so there
+ * are no B-frames, no lookahead and no extra frame delay), with a
+ * configurable thread count, preset and number of slices per frame, to
+ * keep high resolutions at full size on multi-core boards.
+ * Output is Annex B with SPS/PPS repeated before every IDR.
+ *
+ * For the lowest latency, vbv_ms = 0 limits the VBV to one frame and
+ * intra_refresh replaces periodic IDR frames with a refresh column that
+ * sweeps the picture once per second, so no frame is much larger than
+ * the average and none has to queue behind the pacer.
+ */
+class FfmpegH264Encoder : public webrtc::VideoEncoder {
+public:
+    /**
+     * @param config Thread / preset / slice settings
+     * @param packetization_mode Negotiated mode; SingleNalUnit limits slices to the RTP payload size
+     */
+    FfmpegH264Encoder(const H264EncoderConfig& config,
+                      webrtc::H264PacketizationMode packetization_mode);
+    ~FfmpegH264Encoder() override;
+
+    /**
+     * @brief Whether libavcodec was built with libx264
+     */
+    static bool isAvailable();
+
+    // VideoEncoder implementation
+    int32_t InitEncode(const webrtc::VideoCodec* codec_settings,
+                       const webrtc::VideoEncoder::Settings& settings) override;
+    int32_t RegisterEncodeCompleteCallback(webrtc::EncodedImageCallback* callback) override;
+    int32_t Release() override;
+    int32_t Encode(const webrtc::VideoFrame& frame,
+                   const std::vector<webrtc::VideoFrameType>* frame_types) override;
+    void SetRates(const RateControlParameters& parameters) override;
+    EncoderInfo GetEncoderInfo() const override;
+
+private:
+    bool openCodec();
+    void closeCodec();
+    int vbvBufferSize(double framerate) const;
+
+    H264EncoderConfig config_;
+    webrtc::H264PacketizationMode packetization_mode_;
+    webrtc::EncodedImageCallback* callback_;
+
+    AVCodecContext* context_;
+    AVFrame* frame_;
+    AVPacket* packet_;
+
+    webrtc::VideoCodec codec_;
+    int threads_;
+    int slices_;
+    size_t max_payload_size_;
+    uint32_t target_bitrate_bps_;
+    uint32_t last_rtp_timestamp_;
+    int64_t pts_;
+    webrtc::H264BitstreamParser bitstream_parser_;
+};
+
+#endif // FFMPEG_H264_ENCODER_H
@@ -0,0 +1,14 @@
+#ifndef FRAME_OVERLAY_H
+#define FRAME_OVERLAY_H
+
+#include <opencv2/opencv.hpp>
+
+/**
+ * @brief Draw the current wall-clock time (ms precision) in the top-left corner
+ * @param frame BGR, GRAY8, I420, NV12 or YUYV frame, modified in place (for
+ *              planar YUV only the Y plane is touched, giving white text).
+ *              Compressed frames (MJPEG) must not be passed.
+ */
+void drawTimestampOverlay(cv::Mat& frame);
+
+#endif // FRAME_OVERLAY_H
@@ -0,0 +1,121 @@
+#ifndef INSTRUMENTED_VIDEO_ENCODER_H
+#define INSTRUMENTED_VIDEO_ENCODER_H
+
+#include "config_parser.h"
+#include <api/video_codecs/video_encoder.h>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <thread>
+
+/**
+ * @brief Key-frame requests for the encoders of one peer connection
+ *
+ * Owned by the WebRTCClient and handed to every encoder its factory
+ * creates, so a viewer joining one connection does not force key frames
+ * on the encoders of another. Usable from any thread.
+ */
+class KeyFrameTrigger {
+public:
+    /**
+     * @brief Make each encoder sharing this trigger produce a key frame on its next Encode()
+     */
+    void request();
+
+    uint64_t generation() const { return generation_.load(); }
+
+    /**
+     * @brief Time of the pending request (0 if none), cleared so it is reported once
+     */
+    int64_t takeRequestTime() { return requested_us_.exchange(0); }
+
+private:
+    std::atomic<uint64_t> generation_{0};
+    std::atomic<int64_t> requested_us_{0};
+};
+
+/**
+ * @brief VideoEncoder wrapper that records encode/packetize latency
+ *
+ * Encode spans run from Encode() to the matching OnEncodedImage();
+ * packetize spans cover the downstream callback (RTP packetization
+ * happens synchronously inside it).
+ *
+ * WebRTC owns the encoder queue thread, so the configured encoder thread
+ * settings (affinity / scheduling) are applied from inside InitEncode()
+ * and Encode(), which run on that thread. Codec worker threads created
+ * during InitEncode() inherit them.
+ *
+ * The encoder tuning (thread count, VP8 complexity) is applied to the
+ * VideoCodec / Settings passed to InitEncode(), and the settings actually
+ * in effect are printed once per InitEncode(). A configured playout delay
+ * is stamped on every encoded image, which the RTP sender carries in the
+ * playout-delay header extension.
+ */
+class InstrumentedVideoEncoder : public webrtc::VideoEncoder,
+                                 public webrtc::EncodedImageCallback {
+public:
+    /**
+     * @param key_frames Sender-side equivalent of a PLI (control command, peer
+     *        joining) without renegotiation; the time from request to the key
+     *        frame leaving the encoder is logged. nullptr: no external requests
+     */
+    InstrumentedVideoEncoder(std::unique_ptr<webrtc::VideoEncoder> encoder,
+                             const EncoderConfig& tuning = EncoderConfig(),
+                             const ThreadSettings& thread_settings = ThreadSettings(),
+                             std::shared_ptr<KeyFrameTrigger> key_frames = nullptr);
+    ~InstrumentedVideoEncoder() override = default;
+
+    // VideoEncoder implementation
+    void SetFecControllerOverride(webrtc::FecControllerOverride* fec_controller_override) override;
+    int32_t InitEncode(const webrtc::VideoCodec* codec_settings,
+                       const webrtc::VideoEncoder::Settings& settings) override;
+    int32_t RegisterEncodeCompleteCallback(webrtc::EncodedImageCallback* callback) override;
+    int32_t Release() override;
+    int32_t Encode(const webrtc::VideoFrame& frame,
+                   const std::vector<webrtc::VideoFrameType>* frame_types) override;
+    void SetRates(const RateControlParameters& parameters) override;
+    void OnPacketLossRateUpdate(float packet_loss_rate) override;
+    void OnRttUpdate(int64_t rtt_ms) override;
+    void OnLossNotification(const LossNotification& loss_notification) override;
+    EncoderInfo GetEncoderInfo() const override;
+
+    // EncodedImageCallback implementation
+    Result OnEncodedImage(const webrtc::EncodedImage& encoded_image,
+                          const webrtc::CodecSpecificInfo* codec_specific_info) override;
+    void OnDroppedFrame(DropReason reason) override;
+
+private:
+    // 已提交编码但尚未输出的帧（按 capture_time_ms 匹配）
+    struct PendingFrame {
+        int64_t capture_time_ms = -1;
+        uint64_t frame_id = 0;
+        int64_t encode_start_us = 0;
+    };
+    static constexpr size_t kMaxPendingFrames = 8;
+
+    // 记录编码/打包耗时并交给下游回调
+    Result deliver(const webrtc::EncodedImage& encoded_image,
+                   const webrtc::CodecSpecificInfo* codec_specific_info);
+    uint64_t unwrapFrameId(uint16_t id);
+    void configureCurrentThread();
+    void reportSettings(const webrtc::VideoCodec& codec, int number_of_cores) const;
+
+    std::unique_ptr<webrtc::VideoEncoder> encoder_;
+    webrtc::EncodedImageCallback* callback_;
+    std::array<PendingFrame, kMaxPendingFrames> pending_;
+    size_t pending_pos_;
+    uint64_t last_frame_id_;
+    
+    EncoderConfig tuning_;
+    ThreadSettings thread_settings_;
+    std::thread::id configured_thread_;
+    
+    // 触发器的代数与本编码器已处理的值不同则强制关键帧；真正产出关键帧后才记为已处理
+    // （异步编码器在其他线程回调 OnEncodedImage）
+    std::shared_ptr<KeyFrameTrigger> key_frames_;
+    std::atomic<uint64_t> handled_key_frame_generation_;
+    std::atomic<uint64_t> forced_key_frame_generation_;
+};
+
+#endif // INSTRUMENTED_VIDEO_ENCODER_H
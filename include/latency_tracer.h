@@ -0,0 +1,159 @@
+#ifndef LATENCY_TRACER_H
+#define LATENCY_TRACER_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+/**
+ * @brief Pipeline stages instrumented by the latency tracer
+ */
+enum class TraceStage : uint8_t {
+    kCapture = 0,   // VideoSource::getFrame
+    kOverlay,       // 时间戳叠加
+    kConvert,       // PushFrame 中的颜色空间转换
+    kDeliver,       // AdaptedVideoTrackSource::OnFrame
+    kEncode,        // VideoEncoder::Encode -> OnEncodedImage
+    kPacketize,     // OnEncodedImage 下游回调（RTP 打包）
+    kCount
+};
+
+/**
+ * @brief Get the printable name of a stage
+ */
+const char* traceStageName(TraceStage stage);
+
+/**
+ * @brief Lock-free log-linear latency histogram (microseconds)
+ *
+ * Each power of two is split into 16 sub-buckets, so percentiles are
+ * accurate to about 6%. Recording is a couple of relaxed atomic ops.
+ */
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+
+    void record(int64_t value_us);
+    void reset();
+
+    uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+    int64_t max() const { return max_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Get a percentile estimate
+     * @param p Percentile in [0, 100]
+     * @return Value in microseconds (lower bound of the matching bucket)
+     */
+    int64_t percentile(double p) const;
+
+private:
+    static constexpr int kSubBucketBits = 4;
+    static constexpr int kSubBuckets = 1 << kSubBucketBits;
+    static constexpr int kMaxExponent = 40;
+    static constexpr int kNumBuckets = (kMaxExponent - kSubBucketBits + 2) * kSubBuckets;
+
+    static int bucketIndex(int64_t value);
+    static int64_t bucketLowerBound(int index);
+
+    std::array<std::atomic<uint64_t>, kNumBuckets> buckets_;
+    std::atomic<uint64_t> count_;
+    std::atomic<int64_t> max_;
+};
+
+/**
+ * @brief Process-wide per-stage latency tracer
+ *
+ * Stage spans are written into a fixed-size lock-free ring buffer (the
+ * oldest events are overwritten) and aggregated into per-stage histograms.
+ * When disabled, the hot-path cost is a single relaxed atomic load.
+ */
+class LatencyTracer {
+public:
+    static LatencyTracer& instance();
+
+    void setEnabled(bool enabled) { enabled_.store(enabled, std::memory_order_relaxed); }
+    bool isEnabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Record a completed stage span
+     * @param stage Pipeline stage
+     * @param frame_id Frame identifier (capture sequence number)
+     * @param begin_us Start time from nowUs()
+     * @param end_us End time from nowUs()
+     */
+    void record(TraceStage stage, uint64_t frame_id, int64_t begin_us, int64_t end_us);
+
+    /**
+     * @brief Print p50/p99/max per stage
+     */
+    void printSummary(std::ostream& os) const;
+
+    /**
+     * @brief Write the ring buffer contents as Chrome trace_event JSON
+     *        (loadable in Perfetto / chrome://tracing)
+     * @param path Output file path
+     * @return true if successful
+     */
+    bool dumpChromeTrace(const std::string& path) const;
+
+    /**
+     * @brief Clear histograms (the ring buffer is left intact)
+     */
+    void resetHistograms();
+
+    const LatencyHistogram& histogram(TraceStage stage) const {
+        return histograms_[static_cast<size_t>(stage)];
+    }
+
+    /**
+     * @brief Monotonic clock in microseconds (same base as rtc::TimeMicros)
+     */
+    static int64_t nowUs();
+
+private:
+    LatencyTracer();
+
+    static constexpr size_t kRingSize = 1 << 16;   // 必须是 2 的幂
+
+    struct Slot {
+        std::atomic<uint64_t> sequence{0};   // 写入序号 + 1，0 表示空
+        std::atomic<uint64_t> frame_id{0};
+        std::atomic<int64_t> begin_us{0};
+        std::atomic<int64_t> end_us{0};
+        std::atomic<uint32_t> thread_id{0};
+        std::atomic<uint8_t> stage{0};
+    };
+
+    std::atomic<bool> enabled_;
+    std::atomic<uint64_t> write_pos_;
+    std::array<Slot, kRingSize> ring_;
+    std::array<LatencyHistogram, static_cast<size_t>(TraceStage::kCount)> histograms_;
+};
+
+/**
+ * @brief RAII helper that records a stage span on destruction
+ */
+class ScopedTrace {
+public:
+    ScopedTrace(TraceStage stage, uint64_t frame_id)
+        : stage_(stage), frame_id_(frame_id),
+          begin_us_(LatencyTracer::instance().isEnabled() ? LatencyTracer::nowUs() : -1) {}
+
+    ~ScopedTrace() {
+        if (begin_us_ >= 0) {
+            LatencyTracer::instance().record(stage_, frame_id_, begin_us_, LatencyTracer::nowUs());
+        }
+    }
+
+    ScopedTrace(const ScopedTrace&) = delete;
+    ScopedTrace& operator=(const ScopedTrace&) = delete;
+
+private:
+    TraceStage stage_;
+    uint64_t frame_id_;
+    int64_t begin_us_;
+};
+
+#endif // LATENCY_TRACER_H
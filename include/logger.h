@@ -0,0 +1,187 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include "config_parser.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <thread>
+
+/**
+ * @brief Log severity, in increasing order
+ */
+enum class LogLevel : uint8_t {
+    kTrace = 0,
+    kDebug,
+    kInfo,
+    kWarn,
+    kError,
+    kOff
+};
+
+// 编译期最低级别（CMake LOG_COMPILE_LEVEL），更低级别的日志语句连同参数求值一起被编译器删除
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL 0
+#endif
+
+/**
+ * @brief Parse "trace" | "debug" | "info" | "warn" | "error" | "off"
+ * @return false if the name is unknown (level is left unchanged)
+ */
+bool parseLogLevel(const std::string& name, LogLevel& level);
+
+const char* logLevelName(LogLevel level);
+
+constexpr bool logLevelCompiledIn(LogLevel level) {
+    return level >= static_cast<LogLevel>(LOG_COMPILE_LEVEL);
+}
+
+/**
+ * @brief Process-wide asynchronous logger
+ *
+ * Callers format the message on their own thread and push it into a
+ * fixed-size lock-free MPSC ring (one CAS, no lock, no syscall); a
+ * background thread writes batches to stdout (warn and error to stderr)
+ * and flushes once per batch, so a slow console never stalls capture or
+ * encoding. When the ring is full the message is dropped and counted
+ * rather than blocking the caller.
+ *
+ * Use the LOG_* macros: statements below LOG_COMPILE_LEVEL compile to
+ * nothing, and below the runtime level cost one relaxed atomic load.
+ */
+class Logger {
+public:
+    static Logger& instance();
+
+    /**
+     * @brief Apply level, timestamp and format settings (safe at any time)
+     * @return false if the level or format is unknown (that setting is kept)
+     */
+    bool configure(const LogConfig& config);
+
+    bool isEnabled(LogLevel level) const {
+        return level >= level_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Queue a message (called by the LOG_* macros)
+     */
+    void write(LogLevel level, std::string message);
+
+    /**
+     * @brief Wait until everything queued so far has been written
+     */
+    void flush();
+
+    uint64_t droppedMessages() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    Logger();
+    ~Logger();
+
+    static constexpr size_t kRingSize = 1 << 12;     // 必须是 2 的幂
+    static constexpr int kIdleWaitMs = 10;
+
+    struct Slot {
+        std::atomic<uint64_t> sequence{0};   // == 位置：可写；== 位置 + 1：可读
+        LogLevel level = LogLevel::kInfo;
+        int64_t wall_time_us = 0;
+        uint32_t thread_id = 0;
+        std::string message;
+    };
+
+    void writerThread();
+    void format(const Slot& slot, std::string& out) const;
+
+    std::array<Slot, kRingSize> ring_;
+    std::atomic<uint64_t> enqueue_pos_;
+    std::atomic<uint64_t> written_pos_;      // 写线程已输出到的位置
+    std::atomic<uint64_t> dropped_;
+
+    std::atomic<LogLevel> level_;
+    std::atomic<bool> timestamps_;
+    std::atomic<bool> json_;
+
+    std::atomic<bool> should_stop_;
+    std::thread writer_;
+};
+
+/**
+ * @brief Per-thread reusable stream used by the LOG_* macros
+ */
+class LogStream {
+public:
+    LogStream();
+
+    template <typename T>
+    LogStream& operator<<(const T& value) {
+        stream_ << value;
+        return *this;
+    }
+    LogStream& operator<<(std::ostream& (*manipulator)(std::ostream&)) {
+        stream_ << manipulator;
+        return *this;
+    }
+    LogStream& operator<<(std::ios_base& (*manipulator)(std::ios_base&)) {
+        stream_ << manipulator;
+        return *this;
+    }
+
+    std::string str() const { return stream_.str(); }
+
+private:
+    std::ostringstream& stream_;
+};
+
+/**
+ * @brief Per-call-site rate limit for LOG_EVERY_MS
+ */
+class LogRateLimiter {
+public:
+    explicit LogRateLimiter(int interval_ms) : interval_us_(interval_ms * 1000LL), next_us_(0), suppressed_(0) {}
+
+    /**
+     * @brief Decide whether this occurrence is logged
+     * @param suppressed Set to the number of occurrences skipped since the last one logged
+     */
+    bool allow(uint64_t& suppressed);
+
+private:
+    const int64_t interval_us_;
+    std::atomic<int64_t> next_us_;
+    std::atomic<uint64_t> suppressed_;
+};
+
+#define LOG_AT(level, expr)                                                             \
+    do {                                                                                \
+        if (::logLevelCompiledIn(level) && ::Logger::instance().isEnabled(level)) {     \
+            ::Logger::instance().write(level, (::LogStream() << expr).str());           \
+        }                                                                               \
+    } while (0)
+
+// 逐帧消息：同一调用点每 interval_ms 最多一条，并注明期间省略的条数
+#define LOG_EVERY_MS(level, interval_ms, expr)                                          \
+    do {                                                                                \
+        if (::logLevelCompiledIn(level) && ::Logger::instance().isEnabled(level)) {     \
+            static ::LogRateLimiter log_rate_limiter(interval_ms);                      \
+            uint64_t log_suppressed = 0;                                                \
+            if (log_rate_limiter.allow(log_suppressed)) {                               \
+                ::LogStream log_stream;                                                 \
+                log_stream << expr;                                                     \
+                if (log_suppressed > 0) {                                               \
+                    log_stream << " (" << log_suppressed << " similar suppressed)";     \
+                }                                                                       \
+                ::Logger::instance().write(level, log_stream.str());                    \
+            }                                                                           \
+        }                                                                               \
+    } while (0)
+
+#define LOG_TRACE(expr) LOG_AT(::LogLevel::kTrace, expr)
+#define LOG_DEBUG(expr) LOG_AT(::LogLevel::kDebug, expr)
+#define LOG_INFO(expr) LOG_AT(::LogLevel::kInfo, expr)
+#define LOG_WARN(expr) LOG_AT(::LogLevel::kWarn, expr)
+#define LOG_ERROR(expr) LOG_AT(::LogLevel::kError, expr)
+
+#endif // LOGGER_H
@@ -0,0 +1,51 @@
+#ifndef MJPEG_DECODER_H
+#define MJPEG_DECODER_H
+
+#include <api/scoped_refptr.h>
+#include <api/video/i420_buffer.h>
+#include <common_video/include/video_frame_buffer_pool.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Decodes MJPEG camera frames straight into pooled I420 buffers
+ *
+ * With libjpeg-turbo (ENABLE_TURBOJPEG) the JPEG is decoded to its native
+ * YUV planes (4:2:0 directly into the I420 buffer, 4:2:2 / 4:4:4 through
+ * libyuv chroma downsampling), skipping the BGR round trip. When a target
+ * resolution is set, the smallest DCT scaling factor (1/8 steps) that
+ * still covers it is used, so e.g. 1080p MJPEG sent at 540p decodes a
+ * quarter of the pixels. Without libjpeg-turbo it falls back to
+ * cv::imdecode + BGR→I420.
+ */
+class MjpegDecoder {
+public:
+    MjpegDecoder();
+    ~MjpegDecoder();
+
+    MjpegDecoder(const MjpegDecoder&) = delete;
+    MjpegDecoder& operator=(const MjpegDecoder&) = delete;
+
+    /**
+     * @brief Decode at the smallest DCT scale that is at least width x height
+     * @param width Target width, 0 = full resolution
+     * @param height Target height, 0 = full resolution
+     */
+    void setTargetResolution(int width, int height);
+
+    /**
+     * @brief Decode one JPEG image
+     * @return I420 buffer from the pool, nullptr if the data is not a valid JPEG
+     */
+    rtc::scoped_refptr<webrtc::I420Buffer> decode(const uint8_t* data, size_t size,
+                                                  webrtc::VideoFrameBufferPool& pool);
+
+private:
+    void* handle_;          // tjhandle
+    int target_width_;
+    int target_height_;
+    std::vector<uint8_t> chroma_;   // 4:2:2 / 4:4:4 中间色度平面
+};
+
+#endif // MJPEG_DECODER_H
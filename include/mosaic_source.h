@@ -0,0 +1,90 @@
+#ifndef MOSAIC_SOURCE_H
+#define MOSAIC_SOURCE_H
+
+#include "video_source.h"
+#include "config_parser.h"
+#include "mjpeg_decoder.h"
+#include <api/scoped_refptr.h>
+#include <api/video/i420_buffer.h>
+#include <common_video/include/video_frame_buffer_pool.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Composites several video sources into one I420 mosaic
+ *
+ * Each input runs on its own capture thread and scales every new frame
+ * (libyuv box filter) into a tile-sized I420 buffer. getFrame() only
+ * re-blits tiles that received a new frame since the last output (plus
+ * tiles stacked above them), so unchanged inputs cost nothing. The canvas
+ * is returned as kI420 and goes through the normal CustomVideoSource path,
+ * so the receiver decodes a single stream instead of one per camera.
+ *
+ * Layouts:
+ * - grid:   ceil(sqrt(n)) columns of equal tiles
+ * - pip:    first source fills the canvas, the others are quarter-size
+ *           insets along the bottom-right edge
+ * - custom: one rectangle per source from MosaicConfig::tiles
+ */
+class MosaicSource : public MatVideoSource {
+public:
+    /**
+     * @brief Constructor
+     * @param inputs Initialized sources, in tile order (released together with the mosaic)
+     * @param config Canvas size, frame rate and layout
+     */
+    MosaicSource(std::vector<std::shared_ptr<VideoSource>> inputs, const MosaicConfig& config);
+
+    ~MosaicSource() override;
+
+    bool initialize() override;
+    bool getFrame(cv::Mat& frame) override;
+    PixelFormat getPixelFormat() const override { return PixelFormat::kI420; }
+    int getWidth() const override { return width_; }
+    int getHeight() const override { return height_; }
+    int getFrameRate() const override { return fps_; }
+    void release() override;
+    std::string getName() const override;
+    bool isReady() const override { return is_initialized_; }
+
+    /**
+     * @brief Compute tile rectangles for a layout (even-aligned for I420)
+     * @return One rectangle per input, empty if the layout is invalid
+     */
+    static std::vector<cv::Rect> computeLayout(const MosaicConfig& config, size_t count);
+
+private:
+    struct Tile {
+        std::shared_ptr<VideoSource> source;
+        cv::Rect rect;                  // 画布上的区域
+        MjpegDecoder mjpeg_decoder;
+        std::unique_ptr<webrtc::VideoFrameBufferPool> source_pool;   // 源分辨率的解码/转换结果
+        std::unique_ptr<webrtc::VideoFrameBufferPool> scaled_pool;   // 小窗分辨率的缩放结果
+        std::thread thread;
+
+        std::mutex mutex;
+        rtc::scoped_refptr<webrtc::I420Buffer> latest;  // 最近一帧缩放结果
+        cv::Rect placement;             // latest 在画布上的位置（保持宽高比时居中于 rect 内）
+        bool dirty = false;
+    };
+
+    void captureThread(Tile* tile);
+    bool scaleToTile(Tile* tile, const cv::Mat& frame, PixelFormat format);
+    void blitTile(Tile* tile);
+
+    std::vector<std::shared_ptr<VideoSource>> inputs_;
+    MosaicConfig config_;
+    int width_;
+    int height_;
+    int fps_;
+    bool is_initialized_;
+    std::atomic<bool> should_stop_;
+
+    std::vector<std::unique_ptr<Tile>> tiles_;
+    cv::Mat canvas_;                    // I420，height * 3 / 2 行
+};
+
+#endif // MOSAIC_SOURCE_H
@@ -2,12 +2,15 @@
 #define OPENCV_SOURCE_H
 
 #include "video_source.h"
+#include <array>
+#include <atomic>
 #include <mutex>
 
 /**
  * @brief Video source implementation using OpenCV VideoCapture
  * 
- * Supports USB cameras, video files, and RTSP streams
+ * Supports USB cameras, video files, and RTSP streams. Frames are read
+ * into a small pool of reused cv::Mat buffers and leased from there.
  */
 class OpenCVSource : public VideoSource {
 public:
@@ -30,15 +33,24 @@ public:
     ~OpenCVSource() override;
 
     bool initialize() override;
-    bool getFrame(cv::Mat& frame) override;
+    bool acquireFrame(FrameLease& lease) override;
     int getWidth() const override { return width_; }
     int getHeight() const override { return height_; }
     int getFrameRate() const override { return fps_; }
+    // 驱动队列深度为 1 时 read() 阻塞到下一帧
+    bool isSelfPaced() const override { return latest_frame_only_; }
+    bool setLatestFrameOnly(bool enable) override;
     void release() override;
     std::string getName() const override;
     bool isReady() const override { return capture_.isOpened(); }
 
+protected:
+    void releaseFrame(int buffer_index) override;
+
 private:
+    static constexpr int kFramePoolSize = 3;
+
+
     cv::VideoCapture capture_;
     int device_id_;
     std::string source_path_;
@@ -47,7 +59,10 @@ private:
     int fps_;
     bool is_camera_;
     bool is_initialized_;
+    bool latest_frame_only_;
     std::mutex frame_mutex_;
+    std::array<cv::Mat, kFramePoolSize> frame_pool_;             // 分辨率不变时 read() 原地复用
+    std::array<std::atomic<bool>, kFramePoolSize> frame_leased_{};
 };
 
 #endif // OPENCV_SOURCE_H
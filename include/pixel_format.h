@@ -0,0 +1,72 @@
+#ifndef PIXEL_FORMAT_H
+#define PIXEL_FORMAT_H
+
+/**
+ * @brief Pixel layout of the cv::Mat frames produced by a VideoSource
+ *
+ * All layouts honour the Mat's step (row padding is allowed).
+ *
+ * - kBGR:    CV_8UC3, packed B-G-R
+ * - kRGB:    CV_8UC3, packed R-G-B
+ * - kBGRA:   CV_8UC4, packed B-G-R-A (alpha ignored)
+ * - kGRAY8:  CV_8UC1, luma only
+ * - kGRAY16: CV_16UC1, 16-bit luma (host byte order, high byte is used)
+ * - kI420:   CV_8UC1 with height * 3 / 2 rows (Y plane followed by U and V,
+ *            the same layout as cv::COLOR_YUV2BGR_I420; chroma rows use
+ *            half the Mat's step). Width and height must be even.
+ * - kYUYV:   CV_8UC2, packed Y0 U Y1 V (V4L2 YUYV / libyuv YUY2), even width
+ * - kUYVY:   CV_8UC2, packed U Y0 V Y1, even width
+ * - kNV12:   CV_8UC1 with height * 3 / 2 rows (Y plane followed by
+ *            interleaved UV, both with the Mat's step). Width and height
+ *            must be even.
+ * - kMJPEG:  CV_8UC1 with a single row holding one compressed JPEG image
+ */
+enum class PixelFormat {
+    kBGR,
+    kRGB,
+    kBGRA,
+    kGRAY8,
+    kGRAY16,
+    kI420,
+    kYUYV,
+    kUYVY,
+    kNV12,
+    kMJPEG
+};
+
+/**
+ * @brief Get the printable name of a pixel format
+ */
+inline const char* pixelFormatName(PixelFormat format) {
+    switch (format) {
+        case PixelFormat::kBGR:    return "BGR";
+        case PixelFormat::kRGB:    return "RGB";
+        case PixelFormat::kBGRA:   return "BGRA";
+        case PixelFormat::kGRAY8:  return "GRAY8";
+        case PixelFormat::kGRAY16: return "GRAY16";
+        case PixelFormat::kI420:   return "I420";
+        case PixelFormat::kYUYV:   return "YUYV";
+        case PixelFormat::kUYVY:   return "UYVY";
+        case PixelFormat::kNV12:   return "NV12";
+        case PixelFormat::kMJPEG:  return "MJPEG";
+        default:                   return "unknown";
+    }
+}
+
+/**
+ * @brief Whether frames of this format are compressed and must not be drawn on
+ */
+inline bool isCompressedFormat(PixelFormat format) {
+    return format == PixelFormat::kMJPEG;
+}
+
+/**
+ * @brief Picture height of a frame with the given number of Mat rows
+ *
+ * I420 and NV12 stack their chroma planes below the Y plane.
+ */
+inline int pixelFormatHeight(PixelFormat format, int rows) {
+    return (format == PixelFormat::kI420 || format == PixelFormat::kNV12) ? rows * 2 / 3 : rows;
+}
+
+#endif // PIXEL_FORMAT_H
@@ -2,13 +2,21 @@
 #define REALSENSE_SOURCE_H
 
 #include "video_source.h"
+#include "sensor_telemetry.h"
 #include <librealsense2/rs.hpp>
+#include <array>
+#include <atomic>
 #include <mutex>
 
 /**
  * @brief Video source implementation for Intel RealSense cameras (D455, etc.)
  * 
- * Supports color stream and optionally depth stream
+ * Supports color stream and optionally depth stream. With telemetry
+ * attached, IMU samples (a second pipeline on the motion module, delivered
+ * through a librealsense callback) and per-frame metadata are published
+ * with timestamps mapped onto the same clock as the video frames.
+ * Color frames are leased zero-copy: the lease holds a reference to the
+ * librealsense frame and its image points at the frame's own buffer.
  */
 class RealSenseSource : public VideoSource {
 public:
@@ -24,23 +32,38 @@ public:
     ~RealSenseSource() override;
 
     bool initialize() override;
-    bool getFrame(cv::Mat& frame) override;
+    bool acquireFrame(FrameLease& lease) override;
     int getWidth() const override { return width_; }
     int getHeight() const override { return height_; }
     int getFrameRate() const override { return fps_; }
     void release() override;
     std::string getName() const override { return "Intel RealSense"; }
     bool isReady() const override { return is_initialized_; }
+    int64_t getLastCaptureTimeUs() const override { return last_capture_time_us_; }
+    bool attachTelemetry(std::shared_ptr<SensorTelemetry> telemetry) override;
+    // wait_for_frames() 本身阻塞到下一帧；只取最新帧时不再额外按帧率等待
+    bool isSelfPaced() const override { return latest_frame_only_; }
+    bool setLatestFrameOnly(bool enable) override;
 
     /**
-     * @brief Get the depth frame (if enabled)
-     * @param depth_frame Output depth frame
+     * @brief Get the latest depth frame, colorized (if enabled)
+     * @param depth_frame Output depth frame (a copy)
      * @return true if depth frame available
      */
     bool getDepthFrame(cv::Mat& depth_frame);
 
+protected:
+    void releaseFrame(int buffer_index) override;
+
 private:
+    static constexpr int kFramePoolSize = 4;     // librealsense 自己的帧池有限，不宜长期占用更多
+
+    bool startImu(std::shared_ptr<SensorTelemetry> telemetry);
+    void stopImu();
+    void publishMetadata(const rs2::frame& color, const rs2::frame& depth, int64_t capture_us);
+    
     rs2::pipeline pipe_;
+    rs2::pipeline imu_pipe_;
     rs2::config cfg_;
     rs2::colorizer color_map_;
     
@@ -49,10 +72,21 @@ private:
     int fps_;
     bool enable_depth_;
     bool is_initialized_;
+    bool imu_started_;
+    bool latest_frame_only_;
+    std::string serial_;
     
+    // 视频帧与 IMU 共用，时间戳可以直接比较
+    SensorClockMapper clock_;
+    int64_t last_capture_time_us_;
+    // 采集线程启动前设置、停止后清除，acquireFrame 中无需加锁
+    std::shared_ptr<SensorTelemetry> telemetry_;
+    
+    std::array<rs2::frame, kFramePoolSize> leased_frames_;
+    std::array<std::atomic<bool>, kFramePoolSize> frame_leased_{};
+
     std::mutex frame_mutex_;
-    cv::Mat last_color_frame_;
-    cv::Mat last_depth_frame_;
+    rs2::frame last_depth_frame_;    // 未着色的原始深度帧
 };
 
 #endif // REALSENSE_SOURCE_H
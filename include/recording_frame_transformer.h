@@ -0,0 +1,44 @@
+#ifndef RECORDING_FRAME_TRANSFORMER_H
+#define RECORDING_FRAME_TRANSFORMER_H
+
+#include "encoded_recorder.h"
+#include <api/frame_transformer_interface.h>
+#include <api/scoped_refptr.h>
+#include <map>
+#include <memory>
+#include <mutex>
+
+/**
+ * @brief Encoder-to-packetizer transformer that tees encoded frames into an EncodedRecorder
+ *
+ * Installed on the video RtpSender. Each frame is copied into the recorder
+ * queue and handed back to the packetizer unchanged, so the live stream is
+ * never re-encoded or delayed by disk I/O.
+ */
+class RecordingFrameTransformer : public webrtc::FrameTransformerInterface {
+public:
+    RecordingFrameTransformer(std::shared_ptr<EncodedRecorder> recorder, const std::string& codec);
+
+    /**
+     * @brief Update the codec name after negotiation (VP8 | H264)
+     */
+    void setCodec(const std::string& codec);
+
+    // FrameTransformerInterface implementation
+    void Transform(std::unique_ptr<webrtc::TransformableFrameInterface> frame) override;
+    void RegisterTransformedFrameCallback(
+        rtc::scoped_refptr<webrtc::TransformedFrameCallback> callback) override;
+    void RegisterTransformedFrameSinkCallback(
+        rtc::scoped_refptr<webrtc::TransformedFrameCallback> callback, uint32_t ssrc) override;
+    void UnregisterTransformedFrameCallback() override;
+    void UnregisterTransformedFrameSinkCallback(uint32_t ssrc) override;
+
+private:
+    std::shared_ptr<EncodedRecorder> recorder_;
+    std::mutex mutex_;
+    std::string codec_;
+    rtc::scoped_refptr<webrtc::TransformedFrameCallback> callback_;
+    std::map<uint32_t, rtc::scoped_refptr<webrtc::TransformedFrameCallback>> sink_callbacks_;
+};
+
+#endif // RECORDING_FRAME_TRANSFORMER_H
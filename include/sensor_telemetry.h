@@ -0,0 +1,128 @@
+#ifndef SENSOR_TELEMETRY_H
+#define SENSOR_TELEMETRY_H
+
+#include "config_parser.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief One gyro or accelerometer sample
+ */
+struct ImuSample {
+    enum Type : uint8_t { kAccel = 1, kGyro = 2 };
+
+    int64_t timestamp_us;       // CLOCK_MONOTONIC，与视频帧采集时间同一时钟
+    Type type;
+    float x, y, z;              // accel: m/s², gyro: rad/s
+};
+
+/**
+ * @brief Per-frame camera metadata (-1 where the device does not report a field)
+ */
+struct FrameMetadataSample {
+    int64_t timestamp_us;       // CLOCK_MONOTONIC，与该帧 VideoFrame 的 timestamp_us 相同
+    uint32_t frame_number;      // 设备帧号
+    int32_t exposure_us;
+    int32_t gain;
+    int32_t laser_power;
+    int64_t sensor_timestamp_us;  // 设备硬件时钟（曝光中点）
+};
+
+/**
+ * @brief Maps device timestamps onto CLOCK_MONOTONIC
+ *
+ * Tracks the lower envelope of (arrival - device) time: the sample with
+ * the least transport delay gives the best offset, and the envelope is
+ * allowed to rise by 100 ppm of elapsed time so device clock drift is
+ * followed. Thread-safe; video frames and IMU samples of one device share
+ * one mapper so their timestamps are directly comparable.
+ */
+class SensorClockMapper {
+public:
+    SensorClockMapper() : valid_(false), offset_us_(0), last_arrival_us_(0) {}
+
+    int64_t toMonotonicUs(int64_t device_us, int64_t arrival_us);
+
+private:
+    std::mutex mutex_;
+    bool valid_;
+    int64_t offset_us_;
+    int64_t last_arrival_us_;
+};
+
+/**
+ * @brief Batches IMU samples and frame metadata into compact binary packets
+ *
+ * Producers (librealsense callback threads, capture threads) only append
+ * to a vector under a mutex. A sender thread wakes at packet_rate_hz and
+ * hands each packet to the Sender, which is expected to drop rather than
+ * queue when the link is congested — late IMU data is worthless for
+ * stabilization.
+ *
+ * Packet layout (little-endian, no padding):
+ *   header    u8 'T', u8 version (1), u16 sequence, i64 base_us,
+ *             u16 imu_count, u16 metadata_count                  (16 bytes)
+ *   imu       i32 offset_us, u8 type (1 accel, 2 gyro), f32 x, y, z (17 bytes)
+ *   metadata  i32 offset_us, u32 frame_number, i32 exposure_us, i32 gain,
+ *             i32 laser_power, i64 sensor_timestamp_us          (28 bytes)
+ * Record timestamps are base_us + offset_us, in CLOCK_MONOTONIC
+ * microseconds like the video frame timestamps. A gap in sequence means
+ * a packet was lost.
+ */
+class SensorTelemetry {
+public:
+    using Sender = std::function<void(const uint8_t* data, size_t size)>;
+
+    // 单包上限：保持在一个 SCTP 分片内，丢包只丢这一批
+    static constexpr size_t kMaxPacketBytes = 1100;
+    static constexpr size_t kHeaderBytes = 16;
+    static constexpr size_t kImuRecordBytes = 17;
+    static constexpr size_t kMetadataRecordBytes = 28;
+
+    explicit SensorTelemetry(const TelemetryConfig& config);
+    ~SensorTelemetry();
+
+    bool start(Sender sender);
+    void stop();
+
+    const TelemetryConfig& config() const { return config_; }
+
+    void addImu(const ImuSample& sample);
+    void addFrameMetadata(const FrameMetadataSample& sample);
+
+    /**
+     * @brief Serialize samples into packets of at most kMaxPacketBytes
+     * @param sequence Sequence number of the first packet, advanced per packet
+     * @return Packets in order
+     */
+    static std::vector<std::vector<uint8_t>> pack(const std::vector<ImuSample>& imu,
+                                                  const std::vector<FrameMetadataSample>& metadata,
+                                                  uint16_t& sequence);
+
+    uint64_t sentPackets() const { return sent_packets_; }
+
+private:
+    // 发送线程未运行（尚未连接）时的积压上限，超出丢弃最旧的数据
+    static constexpr size_t kMaxPendingSamples = 4096;
+
+    void senderThread();
+
+    TelemetryConfig config_;
+    Sender sender_;
+
+    std::thread sender_thread_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool should_stop_;
+    std::vector<ImuSample> pending_imu_;
+    std::vector<FrameMetadataSample> pending_metadata_;
+    std::atomic<uint64_t> sent_packets_;
+    uint16_t sequence_;                 // 只在发送线程中访问
+};
+
+#endif // SENSOR_TELEMETRY_H
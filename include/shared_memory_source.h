@@ -0,0 +1,71 @@
+#ifndef SHARED_MEMORY_SOURCE_H
+#define SHARED_MEMORY_SOURCE_H
+
+#include "video_source.h"
+#include "shm_frame_format.h"
+#include <cstdint>
+
+/**
+ * @brief Video source reading frames from a shared-memory ring (see shm_frame_format.h)
+ *
+ * Lets another process on the same machine (e.g. the perception stack)
+ * hand over annotated frames without a file/RTSP round trip. getFrame()
+ * blocks on the ring's futex until a new frame is published and returns a
+ * cv::Mat header pointing straight into the shared slot, so the only copy
+ * is the I420 conversion in CustomVideoSource. The slot stays reserved for
+ * this process until the next getFrame() or release().
+ */
+class SharedMemorySource : public MatVideoSource {
+public:
+    /**
+     * @brief Constructor
+     * @param name POSIX shm name ("/frames") or a file path, e.g. /dev/shm/frames
+     *             or /proc/<pid>/fd/<n> for a memfd
+     * @param timeout_ms Maximum time getFrame() waits for a new frame (default: 100)
+     */
+    explicit SharedMemorySource(const std::string& name, int timeout_ms = 100);
+
+    ~SharedMemorySource() override;
+
+    bool initialize() override;
+    bool getFrame(cv::Mat& frame) override;
+    int getWidth() const override { return width_; }
+    int getHeight() const override { return height_; }
+    int getFrameRate() const override { return fps_; }
+    PixelFormat getPixelFormat() const override { return format_; }
+    bool isSelfPaced() const override { return true; }
+    // 总是读取 latest_slot，本身就不会积压
+    bool setLatestFrameOnly(bool enable) override { return true; }
+    int64_t getLastCaptureTimeUs() const override { return last_capture_time_us_; }
+    void release() override;
+    std::string getName() const override;
+    bool isReady() const override { return ring_ != nullptr; }
+
+    /**
+     * @brief Frames published by the producer that were never read
+     */
+    uint64_t skippedFrames() const { return skipped_frames_; }
+
+private:
+    bool waitForFrame();
+    void releaseSlot();
+
+    std::string name_;
+    int timeout_ms_;
+    int fd_;
+    void* base_;
+    size_t mapped_size_;
+    ShmRingHeader* ring_;
+
+    int width_;
+    int height_;
+    int fps_;
+    size_t stride_;
+    PixelFormat format_;
+
+    uint32_t last_counter_;
+    int64_t last_capture_time_us_;
+    uint64_t skipped_frames_;
+};
+
+#endif // SHARED_MEMORY_SOURCE_H
@@ -0,0 +1,141 @@
+#ifndef SHM_FRAME_FORMAT_H
+#define SHM_FRAME_FORMAT_H
+
+/**
+ * @brief Shared-memory frame ring layout used by SharedMemorySource
+ *
+ * The producer (e.g. the perception process) creates a POSIX shm object
+ * (shm_open) or a memfd and lays it out as:
+ *
+ *   offset 0                          ShmRingHeader (header_size bytes)
+ *   header_size + i * slot_size       ShmSlotHeader (64 bytes) + pixel data
+ *
+ * Pixel data of every slot starts kShmSlotDataOffset bytes into the slot
+ * and uses the ring-wide width/height/stride/pixel_format. BGR rows may be
+ * padded (stride >= width * 3); GRAY8 and I420 must be tightly packed
+ * (stride == width, I420 planes Y, U, V back to back).
+ *
+ * Producer protocol (single producer, single consumer), all accesses with
+ * sequentially consistent atomics:
+ *   1. Pick a slot other than latest_slot and reader_slot.
+ *   2. Store an odd value into slot.sequence, then re-read reader_slot; if
+ *      the consumer has just claimed this slot, restore the old sequence
+ *      and pick another one.
+ *   3. Write pixels, frame_id, timestamp_us, then store the next even
+ *      value into slot.sequence (generation = sequence / 2).
+ *   4. Store the slot index into latest_slot, increment frame_counter and
+ *      FUTEX_WAKE it (shared futex, no FUTEX_PRIVATE_FLAG).
+ *
+ * The consumer claims a slot by writing reader_slot before checking its
+ * sequence, so the producer never overwrites a frame that is being read.
+ * shmRingBeginWrite() / shmRingEndWrite() implement steps 1-4.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <climits>
+
+constexpr uint32_t kShmFrameMagic = 0x4D524653;     // "SFRM"
+constexpr uint32_t kShmFrameVersion = 1;
+constexpr size_t kShmSlotDataOffset = 64;
+constexpr uint32_t kShmMaxSlots = 16;
+
+/**
+ * @brief Pixel formats understood by SharedMemorySource (values are ABI)
+ */
+enum ShmPixelFormat : uint32_t {
+    kShmPixelBGR = 0,
+    kShmPixelGRAY8 = 1,
+    kShmPixelI420 = 2
+};
+
+struct ShmRingHeader {
+    // 只读描述，生产者创建时写入
+    uint32_t magic;
+    uint32_t version;
+    uint32_t header_size;       // 第一个槽位的偏移，64 字节对齐
+    uint32_t slot_count;        // 2..kShmMaxSlots
+    uint64_t slot_size;         // 每个槽位字节数（含 ShmSlotHeader），64 字节对齐
+    uint32_t width;
+    uint32_t height;
+    uint32_t stride;            // 第一个平面的行字节数
+    uint32_t pixel_format;      // ShmPixelFormat
+    uint32_t fps;               // 名义帧率，仅用于显示和码率估计
+    uint32_t producer_pid;
+
+    // 生产者写
+    alignas(64) uint32_t frame_counter;   // futex 字：每发布一帧加一
+    int32_t latest_slot;                  // 最新完整帧所在槽位，-1 表示尚无
+
+    // 消费者写
+    alignas(64) int32_t reader_slot;      // 正在读取的槽位，-1 表示无
+    uint32_t reader_pid;
+};
+
+struct ShmSlotHeader {
+    uint64_t sequence;          // seqlock：奇数表示正在写入，非零偶数表示完整
+    uint64_t frame_id;          // 生产者帧号
+    int64_t timestamp_us;       // 采集时间 (CLOCK_MONOTONIC)
+    uint32_t data_size;         // 有效像素字节数
+    uint32_t reserved[9];
+};
+
+static_assert(sizeof(ShmRingHeader) <= 256, "ShmRingHeader must fit in 256 bytes");
+static_assert(sizeof(ShmSlotHeader) == kShmSlotDataOffset, "ShmSlotHeader must be 64 bytes");
+
+inline ShmSlotHeader* shmSlotHeader(void* base, const ShmRingHeader* ring, uint32_t index) {
+    return reinterpret_cast<ShmSlotHeader*>(
+        static_cast<uint8_t*>(base) + ring->header_size + index * ring->slot_size);
+}
+
+inline uint8_t* shmSlotData(void* base, const ShmRingHeader* ring, uint32_t index) {
+    return reinterpret_cast<uint8_t*>(shmSlotHeader(base, ring, index)) + kShmSlotDataOffset;
+}
+
+/**
+ * @brief Producer side: claim a slot for writing (protocol steps 1-2)
+ * @return Slot index whose pixel data may now be written
+ */
+inline uint32_t shmRingBeginWrite(void* base) {
+    ShmRingHeader* ring = static_cast<ShmRingHeader*>(base);
+    int32_t latest = __atomic_load_n(&ring->latest_slot, __ATOMIC_SEQ_CST);
+    uint32_t index = latest < 0 ? 0 : (static_cast<uint32_t>(latest) + 1) % ring->slot_count;
+    while (true) {
+        if (static_cast<int32_t>(index) == latest ||
+            static_cast<int32_t>(index) == __atomic_load_n(&ring->reader_slot, __ATOMIC_SEQ_CST)) {
+            index = (index + 1) % ring->slot_count;
+            continue;
+        }
+        ShmSlotHeader* slot = shmSlotHeader(base, ring, index);
+        uint64_t previous = __atomic_load_n(&slot->sequence, __ATOMIC_SEQ_CST);
+        __atomic_store_n(&slot->sequence, previous | 1, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&ring->reader_slot, __ATOMIC_SEQ_CST) != static_cast<int32_t>(index)) {
+            return index;
+        }
+        // 消费者刚好占用了该槽位，恢复后换下一个
+        __atomic_store_n(&slot->sequence, previous, __ATOMIC_SEQ_CST);
+        index = (index + 1) % ring->slot_count;
+    }
+}
+
+/**
+ * @brief Producer side: publish a written slot and wake the consumer (steps 3-4)
+ */
+inline void shmRingEndWrite(void* base, uint32_t index, uint64_t frame_id,
+                            int64_t timestamp_us, uint32_t data_size) {
+    ShmRingHeader* ring = static_cast<ShmRingHeader*>(base);
+    ShmSlotHeader* slot = shmSlotHeader(base, ring, index);
+    slot->frame_id = frame_id;
+    slot->timestamp_us = timestamp_us;
+    slot->data_size = data_size;
+    uint64_t sequence = __atomic_load_n(&slot->sequence, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&slot->sequence, sequence + 1, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&ring->latest_slot, static_cast<int32_t>(index), __ATOMIC_SEQ_CST);
+    __atomic_add_fetch(&ring->frame_counter, 1, __ATOMIC_SEQ_CST);
+    syscall(SYS_futex, &ring->frame_counter, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+#endif // SHM_FRAME_FORMAT_H
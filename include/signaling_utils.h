@@ -0,0 +1,42 @@
+#ifndef SIGNALING_UTILS_H
+#define SIGNALING_UTILS_H
+
+#include <cstddef>
+#include <string>
+
+/**
+ * @brief Escape a string for embedding in a JSON string literal
+ */
+std::string escapeJsonString(const std::string& input);
+
+/**
+ * @brief Encode a text message as a masked WebSocket frame (client → server)
+ */
+std::string encodeWebSocketFrame(const std::string& message);
+
+/**
+ * @brief Decode a WebSocket data frame
+ * @return Payload, or empty string for control frames / incomplete data
+ */
+std::string decodeWebSocketFrame(const char* data, size_t len);
+
+/**
+ * @brief Rewrite every media direction attribute in an SDP to a=sendonly
+ *
+ * a=sendrecv / a=recvonly are replaced; if the SDP has no direction
+ * attribute at all, a=sendonly is inserted after the m=video line.
+ * @param sdp SDP text, modified in place
+ * @return Number of attributes replaced or inserted
+ */
+int forceSendOnlyDirection(std::string& sdp);
+
+/**
+ * @brief Remove generic NACK feedback (a=rtcp-fb:<pt> nack) from an SDP
+ *
+ * "nack pli" is kept, so key frame requests still work.
+ * @param sdp SDP text, modified in place
+ * @return Number of lines removed
+ */
+int removeNackFeedback(std::string& sdp);
+
+#endif // SIGNALING_UTILS_H
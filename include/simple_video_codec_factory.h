@@ -8,18 +8,28 @@
 #include "api/video_codecs/sdp_video_format.h"
 #include "modules/video_coding/codecs/vp8/include/vp8.h"
 #include "modules/video_coding/codecs/h264/include/h264.h"
+#include "instrumented_video_encoder.h"
+#include "ffmpeg_h264_encoder.h"
+#include "config_parser.h"
+#include "logger.h"
 
 namespace webrtc {
 
 // 视频编码器工厂（支持 VP8 和 H.264）
 class SimpleVideoEncoderFactory : public VideoEncoderFactory {
 public:
-    SimpleVideoEncoderFactory() {
-        std::cout << "SimpleVideoEncoderFactory created" << std::endl;
+    // tuning: 各编码器的线程数/速度/slice 配置
+    // encoder_thread: 编码队列线程的亲和性/调度配置
+    // key_frames: 本工厂创建的编码器共用的关键帧触发器（nullptr = 不支持主动请求）
+    explicit SimpleVideoEncoderFactory(const EncoderConfig& tuning = EncoderConfig(),
+                                       const ThreadSettings& encoder_thread = ThreadSettings(),
+                                       std::shared_ptr<KeyFrameTrigger> key_frames = nullptr)
+        : tuning_(tuning), encoder_thread_(encoder_thread), key_frames_(std::move(key_frames)) {
+        LOG_INFO("SimpleVideoEncoderFactory created");
     }
 
     std::vector<SdpVideoFormat> GetSupportedFormats() const override {
-        std::cout << "SimpleVideoEncoderFactory::GetSupportedFormats called" << std::endl;
+        LOG_DEBUG("SimpleVideoEncoderFactory::GetSupportedFormats called");
         std::vector<SdpVideoFormat> formats;
         // VP8
         formats.push_back(SdpVideoFormat("VP8"));
@@ -40,20 +50,43 @@ public:
     CodecSupport QueryCodecSupport(
         const SdpVideoFormat& format,
         absl::optional<std::string> scalability_mode) const override {
-        std::cout << "SimpleVideoEncoderFactory::QueryCodecSupport called for " << format.name << std::endl;
+        LOG_DEBUG("SimpleVideoEncoderFactory::QueryCodecSupport called for " << format.name);
         return VideoEncoderFactory::QueryCodecSupport(format, scalability_mode);
     }
 
     std::unique_ptr<VideoEncoder> CreateVideoEncoder(
         const SdpVideoFormat& format) override {
-        std::cout << "Creating video encoder for format: " << format.name << std::endl;
+        LOG_INFO("Creating video encoder for format: " << format.name);
+        std::unique_ptr<VideoEncoder> encoder;
         if (format.name == "VP8") {
-            return VP8Encoder::Create();
+            encoder = VP8Encoder::Create();
         } else if (format.name == "H264") {
-            return H264Encoder::Create();
+            if (tuning_.h264.implementation == "libx264") {
+                if (FfmpegH264Encoder::isAvailable()) {
+                    auto it = format.parameters.find("packetization-mode");
+                    H264PacketizationMode mode = (it != format.parameters.end() && it->second == "1")
+                        ? H264PacketizationMode::NonInterleaved : H264PacketizationMode::SingleNalUnit;
+                    encoder = std::make_unique<FfmpegH264Encoder>(tuning_.h264, mode);
+                } else {
+                    LOG_WARN("⚠️  libx264 not available in libavcodec, falling back to OpenH264");
+                }
+            }
+            if (!encoder) {
+                encoder = H264Encoder::Create();
+            }
         }
-        return nullptr;
+        if (!encoder) {
+            return nullptr;
+        }
+        // 包装一层以记录编码/打包延迟，并应用调优参数
+        return std::make_unique<InstrumentedVideoEncoder>(std::move(encoder), tuning_, encoder_thread_,
+                                                          key_frames_);
     }
+
+private:
+    EncoderConfig tuning_;
+    ThreadSettings encoder_thread_;
+    std::shared_ptr<KeyFrameTrigger> key_frames_;
 };
 
 // 视频解码器工厂
@@ -0,0 +1,61 @@
+#ifndef STATIC_SCENE_DETECTOR_H
+#define STATIC_SCENE_DETECTOR_H
+
+#include "config_parser.h"
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+
+/**
+ * @brief Decides per frame whether a mostly unchanging scene needs to be sent
+ *
+ * The Y plane is box-downsampled to about kAnalysisWidth pixels wide and
+ * compared block by block with the last delivered frame using OpenCV's
+ * SIMD L1 norm (sum of absolute differences). Any block whose mean
+ * difference exceeds the threshold counts as motion and the frame is sent
+ * at once. After hold_ms without motion, frames are only sent at
+ * keepalive_fps until the next motion.
+ *
+ * Comparing against the last delivered frame (not the previous capture)
+ * means slow changes still accumulate until they are sent.
+ */
+class StaticSceneDetector {
+public:
+    explicit StaticSceneDetector(const StaticSceneConfig& config = StaticSceneConfig());
+
+    void setConfig(const StaticSceneConfig& config);
+    bool isEnabled() const { return config_.enabled; }
+
+    /**
+     * @brief Exclude a region (source pixels) that changes every frame, e.g. the timestamp overlay
+     */
+    void setIgnoreRegion(const cv::Rect& region) { ignore_region_ = region; }
+
+    /**
+     * @brief Analyze one frame
+     * @param y Luma plane
+     * @param stride Bytes per luma row
+     * @param now_us Capture time (monotonic)
+     * @return true if the frame should be delivered
+     */
+    bool shouldDeliver(const uint8_t* y, int stride, int width, int height, int64_t now_us);
+
+    // 当前是否处于静止降帧率状态
+    bool isStatic() const { return static_; }
+
+private:
+    // 分析图像宽度与块大小（分析像素）；1080p 时每块约覆盖 96x96 源像素
+    static constexpr int kAnalysisWidth = 320;
+    static constexpr int kBlockSize = 16;
+
+    bool hasMotion(int factor);
+
+    StaticSceneConfig config_;
+    cv::Rect ignore_region_;
+    cv::Mat reference_;     // 上一次发送帧的分析图像
+    cv::Mat current_;
+    int64_t last_motion_us_;
+    int64_t last_delivered_us_;
+    bool static_;
+};
+
+#endif // STATIC_SCENE_DETECTOR_H
@@ -0,0 +1,73 @@
+#ifndef TEST_PATTERN_SOURCE_H
+#define TEST_PATTERN_SOURCE_H
+
+#include "video_source.h"
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Synthetic video source for camera-less benchmarking
+ *
+ * Patterns:
+ * - bars:   color bars scrolling horizontally
+ * - box:    static color bars with a moving box
+ * - noise:  high-entropy noise (worst case for the encoder)
+ * - static: a fixed image that never changes
+ *
+ * Frames are generated directly in BGR or I420. Each pattern is
+ * pre-rendered once in initialize(), so getFrame() costs a single frame
+ * copy and never becomes the bottleneck. getFrame() does not pace itself;
+ * the caller is responsible for timing.
+ */
+class TestPatternSource : public MatVideoSource {
+public:
+    /**
+     * @brief Constructor
+     * @param pattern Pattern name: bars|box|noise|static (default: bars)
+     * @param format Output format, kBGR or kI420 (default: kBGR)
+     * @param width Frame width, up to 3840 (default: 1280)
+     * @param height Frame height, up to 2160 (default: 720)
+     * @param fps Nominal frame rate, up to 120 (default: 30)
+     */
+    TestPatternSource(const std::string& pattern = "bars",
+                      PixelFormat format = PixelFormat::kBGR,
+                      int width = 1280, int height = 720, int fps = 30);
+
+    ~TestPatternSource() override;
+
+    bool initialize() override;
+    bool getFrame(cv::Mat& frame) override;
+    int getWidth() const override { return width_; }
+    int getHeight() const override { return height_; }
+    int getFrameRate() const override { return fps_; }
+    PixelFormat getPixelFormat() const override { return format_; }
+    // 每次 getFrame 现场生成，没有队列
+    bool setLatestFrameOnly(bool enable) override { return true; }
+    void release() override;
+    std::string getName() const override;
+    bool isReady() const override { return is_initialized_; }
+
+private:
+    enum class Pattern { kBars, kBox, kNoise, kStatic };
+
+    void renderBars(cv::Mat& bgr, int period) const;
+    void copyShifted(int offset);
+    void copyNoise(uint64_t frame_index);
+    void drawBox(uint64_t frame_index);
+
+    std::string pattern_name_;
+    Pattern pattern_;
+    PixelFormat format_;
+    int width_;
+    int height_;
+    int fps_;
+    bool is_initialized_;
+    uint64_t frame_index_;
+
+    // 预渲染画布：bars 为两倍宽度（滚动取窗口），noise 为一帧加额外尾部（每帧错位读取）
+    cv::Mat canvas_;
+    std::vector<uint8_t> noise_;
+    cv::Mat output_;
+};
+
+#endif // TEST_PATTERN_SOURCE_H
@@ -0,0 +1,21 @@
+#ifndef THREAD_UTILS_H
+#define THREAD_UTILS_H
+
+#include "config_parser.h"
+#include <string>
+
+/**
+ * @brief Apply name, CPU affinity and scheduling policy to the calling thread
+ *
+ * Used for our own std::threads as well as the WebRTC-owned threads
+ * (invoked on them after they start). Failures (e.g. SCHED_FIFO without
+ * CAP_SYS_NICE, CPUs outside the allowed set) are logged and leave the
+ * thread running with its previous settings.
+ *
+ * @param settings Settings for this thread role
+ * @param default_name Name used when settings.name is empty (truncated to 15 chars)
+ * @return true if every requested setting was applied
+ */
+bool applyThreadSettings(const ThreadSettings& settings, const std::string& default_name);
+
+#endif // THREAD_UTILS_H
@@ -0,0 +1,96 @@
+#ifndef V4L2_SOURCE_H
+#define V4L2_SOURCE_H
+
+#include "video_source.h"
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Video source reading UVC/V4L2 devices directly with mmap streaming I/O
+ *
+ * Unlike cv::VideoCapture this keeps the camera's native pixel format
+ * (YUYV, UYVY, NV12, GREY, Y16 or MJPEG, converted once in CustomVideoSource), exposes the
+ * number of queued buffers and reports the kernel capture timestamp of
+ * each frame. acquireFrame() leases the dequeued mmap buffer itself; the
+ * buffer is queued back to the driver when the lease is released, so the
+ * caller can hold at most buffer_count - 1 frames before capture stalls.
+ * DMABUF file descriptors are exported for each buffer when the driver
+ * supports VIDIOC_EXPBUF.
+ *
+ * Can be tested without hardware using the vivid virtual driver
+ * (modprobe vivid).
+ */
+class V4L2Source : public VideoSource {
+public:
+    /**
+     * @brief Constructor
+     * @param device Device node (default: /dev/video0)
+     * @param width Desired width (default: 1920)
+     * @param height Desired height (default: 1080)
+     * @param fps Desired frame rate (default: 30)
+     * @param format Requested pixel format: yuyv|uyvy|nv12|grey|y16|mjpeg (default: yuyv)
+     * @param buffer_count Number of mmap buffers queued to the driver, 2-32 (default: 4)
+     */
+    V4L2Source(const std::string& device = "/dev/video0",
+               int width = 1920, int height = 1080, int fps = 30,
+               const std::string& format = "yuyv", int buffer_count = 4);
+
+    ~V4L2Source() override;
+
+    bool initialize() override;
+    bool acquireFrame(FrameLease& lease) override;
+    int getWidth() const override { return width_; }
+    int getHeight() const override { return height_; }
+    int getFrameRate() const override { return fps_; }
+    PixelFormat getPixelFormat() const override { return format_; }
+    bool isSelfPaced() const override { return true; }
+    bool setLatestFrameOnly(bool enable) override;
+    int64_t getLastCaptureTimeUs() const override { return last_capture_time_us_; }
+    void release() override;
+    std::string getName() const override;
+    bool isReady() const override { return streaming_; }
+
+    /**
+     * @brief DMABUF fd of a buffer (-1 if the driver does not support export)
+     */
+    int getDmabufFd(size_t index) const;
+
+protected:
+    void releaseFrame(int buffer_index) override;
+
+private:
+    struct Buffer {
+        void* start = nullptr;
+        size_t length = 0;
+        int dmabuf_fd = -1;
+    };
+
+    bool setFormat();
+    bool setFrameRate();
+    bool setupBuffers();
+    bool queueBuffer(uint32_t index);
+    void updateSequence(uint32_t sequence);
+    int xioctl(unsigned long request, void* arg) const;
+
+    std::string device_;
+    std::string format_name_;
+    int width_;
+    int height_;
+    int fps_;
+    int buffer_count_;
+    PixelFormat format_;
+    uint32_t fourcc_;
+    uint32_t bytes_per_line_;
+
+    int fd_;
+    bool streaming_;
+    bool monotonic_timestamps_;
+    std::vector<Buffer> buffers_;
+    int64_t last_capture_time_us_;
+    uint32_t last_sequence_;
+    uint64_t dropped_frames_;
+    bool latest_frame_only_;
+    uint64_t skipped_frames_;       // 只取最新帧时跳过的积压帧
+};
+
+#endif // V4L2_SOURCE_H
@@ -4,6 +4,65 @@
 #include <memory>
 #include <string>
 #include <opencv2/opencv.hpp>
+#include "pixel_format.h"
+
+class SensorTelemetry;
+class VideoSource;
+
+/**
+ * @brief A captured frame on loan from a VideoSource
+ *
+ * image() is a header over the source's own buffer (driver mmap buffer,
+ * librealsense frame or pooled cv::Mat); nothing is copied. The buffer goes
+ * back to the source's pool when the lease is reset or destroyed, so release
+ * it as soon as the frame has been converted. Move-only.
+ */
+class FrameLease {
+public:
+    FrameLease() = default;
+    ~FrameLease() { reset(); }
+
+    FrameLease(FrameLease&& other) noexcept { *this = std::move(other); }
+    FrameLease& operator=(FrameLease&& other) noexcept;
+    FrameLease(const FrameLease&) = delete;
+    FrameLease& operator=(const FrameLease&) = delete;
+
+    bool valid() const { return !image_.empty(); }
+
+    /**
+     * @brief Frame data, read-only
+     *
+     * May point into driver, SDK (librealsense) or shared-memory buffers that
+     * other consumers read as well, so never draw into it; convert first.
+     * For I420 and NV12 the planes are stacked, so rows is 3/2 of height().
+     */
+    const cv::Mat& image() const { return image_; }
+
+    PixelFormat format() const { return format_; }
+    int width() const { return image_.cols; }
+    int height() const { return pixelFormatHeight(format_, image_.rows); }
+    size_t stride() const { return image_.step; }
+
+    /**
+     * @brief Capture time in CLOCK_MONOTONIC microseconds, 0 if unknown
+     */
+    int64_t captureTimeUs() const { return capture_time_us_; }
+
+    /**
+     * @brief Return the buffer to the source (no-op if nothing is leased)
+     */
+    void reset();
+
+private:
+    friend class VideoSource;
+    friend class MatVideoSource;
+
+    cv::Mat image_;
+    PixelFormat format_ = PixelFormat::kBGR;
+    int64_t capture_time_us_ = 0;
+    VideoSource* owner_ = nullptr;    // nullptr：image_ 自己持有数据，无需归还
+    int buffer_index_ = -1;
+};
 
 /**
  * @brief Abstract base class for video sources
@@ -21,12 +80,64 @@ public:
      */
     virtual bool initialize() = 0;
 
+    /**
+     * @brief Borrow the next frame without copying it
+     *
+     * Any frame still held in @p lease is released first. Sources with a
+     * buffer pool hand out their own buffers, so steady-state capture does
+     * no heap allocation. Sources that only fill a cv::Mat derive from
+     * MatVideoSource instead, which implements this on top of getFrame().
+     * @return false if no frame was available (or every buffer is leased)
+     */
+    virtual bool acquireFrame(FrameLease& lease) = 0;
+
     /**
      * @brief Get the next frame from the video source
-     * @param frame Output frame in BGR format
+     *
+     * Compatibility wrapper around acquireFrame(): the returned Mat may point
+     * into the source's buffer and stays valid until the next getFrame() call.
+     * @param frame Output frame in the format reported by getPixelFormat()
      * @return true if frame was successfully retrieved, false otherwise
      */
-    virtual bool getFrame(cv::Mat& frame) = 0;
+    virtual bool getFrame(cv::Mat& frame);
+
+    /**
+     * @brief Get the pixel layout of frames returned by acquireFrame() / getFrame()
+     * @return Pixel format (BGR unless the source says otherwise)
+     */
+    virtual PixelFormat getPixelFormat() const { return PixelFormat::kBGR; }
+
+    /**
+     * @brief Whether getFrame() itself blocks until the next frame is available
+     * @return true if the caller should not add its own frame-rate pacing
+     */
+    virtual bool isSelfPaced() const { return false; }
+
+    /**
+     * @brief Keep at most one frame queued: getFrame() returns the newest frame
+     *
+     * Frames that were captured while the previous one was being processed
+     * are dropped instead of delivered late. Sources that support it block
+     * in getFrame() and report isSelfPaced(). Call before initialize().
+     * @return false if the source cannot skip queued frames
+     */
+    virtual bool setLatestFrameOnly(bool enable) { return false; }
+
+    /**
+     * @brief Capture time of the frame last returned (FrameLease::captureTimeUs() for leases)
+     * @return CLOCK_MONOTONIC microseconds (e.g. a kernel timestamp), 0 if unknown
+     */
+    virtual int64_t getLastCaptureTimeUs() const { return 0; }
+
+    /**
+     * @brief Start publishing sensor data (IMU, frame metadata) to telemetry
+     *
+     * Called before the capture thread starts; nullptr detaches again after
+     * it has stopped. Timestamps must use the same clock as
+     * getLastCaptureTimeUs().
+     * @return false if the source has no sensor data to offer
+     */
+    virtual bool attachTelemetry(std::shared_ptr<SensorTelemetry> telemetry) { return false; }
 
     /**
      * @brief Get the width of the video frames
@@ -62,6 +173,36 @@ public:
      * @return true if ready, false otherwise
      */
     virtual bool isReady() const = 0;
+
+protected:
+    friend class FrameLease;
+
+    /**
+     * @brief Hand out one of this source's buffers; releaseFrame(buffer_index) is called when it comes back
+     */
+    void lend(FrameLease& lease, const cv::Mat& image, PixelFormat format,
+              int64_t capture_time_us, int buffer_index);
+
+    /**
+     * @brief A lease on buffer_index was released (may be called from any thread)
+     */
+    virtual void releaseFrame(int buffer_index) {}
+
+private:
+    FrameLease compat_lease_;    // getFrame() 返回的帧在下次调用前保持有效
+};
+
+/**
+ * @brief Base for sources that produce frames into a cv::Mat (no buffer pool)
+ *
+ * Subclasses implement getFrame(); acquireFrame() wraps its result in a
+ * lease that is not returned to the source. Keeping the two directions in
+ * separate classes means no source can end up with neither overridden.
+ */
+class MatVideoSource : public VideoSource {
+public:
+    bool acquireFrame(FrameLease& lease) override;
+    bool getFrame(cv::Mat& frame) override = 0;
 };
 
 #endif // VIDEO_SOURCE_H
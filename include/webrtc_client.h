@@ -10,6 +10,8 @@
 #include <queue>
 #include <mutex>
 #include <condition_variable>
+#include <functional>
+#include <vector>
 
 // WebRTC headers
 #include "api/scoped_refptr.h"
@@ -17,17 +19,92 @@
 #include "api/media_stream_interface.h"
 #include "api/data_channel_interface.h"
 #include "api/jsep.h"
+#include "api/stats/rtc_stats_report.h"
+#include "rtc_base/thread.h"
 
 class PeerConnectionObserver;
 class CreateSessionDescriptionObserver;
 class SetSessionDescriptionObserver;
 class CustomVideoSource;
+class ControlChannel;
+struct ControlCommand;
+class EncodedRecorder;
+class RecordingFrameTransformer;
+class SensorTelemetry;
+class AdaptationController;
+class KeyFrameTrigger;
+
+/**
+ * @brief One video source sent as its own track on the shared PeerConnection
+ */
+struct VideoTrackContext {
+    VideoConfig config;
+    std::string track_id;
+    std::shared_ptr<VideoSource> source;
+    rtc::scoped_refptr<CustomVideoSource> track_source;
+    rtc::scoped_refptr<webrtc::VideoTrackInterface> track;
+    rtc::scoped_refptr<webrtc::RtpSenderInterface> sender;
+    
+    // Encoded-stream recording (per track)
+    std::shared_ptr<EncodedRecorder> recorder;
+    rtc::scoped_refptr<RecordingFrameTransformer> recording_transformer;
+    
+    // 控制通道设置的上限（自适应控制在此基础上再降低）
+    double control_scale = 1.0;
+    double control_max_fps = 0;
+    // 热加载把 video.fps 调低到采集帧率以下时的发送帧率上限
+    double config_max_fps = 0;
+    
+    std::thread capture_thread;
+    int frame_count = 0;
+};
 
 /**
  * @brief WebRTC client with native API and H.265 support
+ *
+ * Every video source becomes its own track on a single bundled
+ * PeerConnection, so all cameras share one DTLS transport and one
+ * congestion controller; bandwidth is split by each track's
+ * bitrate_priority. Each source is captured on its own thread.
+ *
+ * The client owns all of its threads (WebRTC network/worker/signaling
+ * rtc::Threads, the WebSocket signaling thread and the capture threads)
+ * and applies AppConfig::threads (name, CPU affinity, scheduling policy)
+ * to each of them.
+ *
+ * A "control" DataChannel (created with the offer, or opened by the
+ * receiver) accepts runtime commands (see ControlCommand) that are
+ * applied via RtpSender::SetParameters and the capture pipeline, without
+ * renegotiation.
+ *
+ * With telemetry enabled, IMU samples and frame metadata from the source
+ * (RealSense) are batched and sent on an unordered, no-retransmit
+ * "telemetry" DataChannel, timestamped in the video frames' clock.
+ *
+ * Whenever the PeerConnection reaches "connected" (a viewer joining or
+ * reconnecting), every encoder is asked for a key frame and the last
+ * captured frame is delivered again, so the viewer does not wait for a
+ * PLI round trip or the next capture before the first picture.
+ *
+ * With adaptation enabled, GetStats is polled every interval_ms and an
+ * AdaptationController turns RTT / loss / BWE into scale and max frame
+ * rate on every track, following the configured policy.
+ *
+ * applyConfig() takes a reloaded configuration (see ConfigWatcher) and
+ * applies what can change on a live session: ICE servers (used from the
+ * next ICE gathering), bandwidth estimation limits, degradation
+ * preference, per-track frame-rate cap, bitrate priority, crop and
+ * timestamp overlay, logging and tracing. Anything else is reported back as
+ * needing a restart.
  */
 class WebRTCClient {
 public:
+    // video_sources[0] 对应 config.video，其余依次对应 config.extra_videos
+    WebRTCClient(std::vector<std::shared_ptr<VideoSource>> video_sources,
+                 const AppConfig& config);
+    WebRTCClient(std::shared_ptr<VideoSource> video_source,
+                 const AppConfig& config);
+    // 只提供信令配置，其余使用默认值
     WebRTCClient(std::shared_ptr<VideoSource> video_source,
                  const WebRTCConfig& webrtc_config);
     ~WebRTCClient();
@@ -37,42 +114,93 @@ public:
     void stop();
     bool isStreaming() const { return is_streaming_; }
     
+    /**
+     * @brief Apply a reloaded configuration to the running session
+     * @param next Reloaded configuration (command-line overrides already applied)
+     * @param changed Fields that differ from the running configuration
+     *                (ConfigParser::changedFields)
+     * @return Changed fields that could not be applied and need a restart
+     */
+    std::vector<std::string> applyConfig(const AppConfig& next,
+                                         const std::vector<std::string>& changed);
+    
     // Callbacks from observers
     void OnIceCandidate(const webrtc::IceCandidateInterface* candidate);
     void OnConnectionChange(bool connected);
+    void OnPeerJoined();
     void OnOfferCreated(webrtc::SessionDescriptionInterface* desc);
     void OnAnswerSet();
+    void OnDataChannel(rtc::scoped_refptr<webrtc::DataChannelInterface> channel);
+    void OnStatsDelivered(const rtc::scoped_refptr<const webrtc::RTCStatsReport>& report);
 
 private:
     void streamingThread();
     void signalingThread();
-    void captureAndEncodeFrames();
+    void adaptationThread();
+    void captureAndEncodeFrames(VideoTrackContext* track);
     
+    void startRtcThread(rtc::Thread* thread, const ThreadSettings& settings,
+                        const std::string& default_name);
     bool createPeerConnection();
-    bool addVideoTrack();
+    std::vector<webrtc::PeerConnectionInterface::IceServer> iceServers() const;
+    void applyBitrateLimits();
+    bool applyVideoConfig(VideoTrackContext* track, const VideoConfig& next,
+                          const std::string& field_prefix, std::vector<std::string>& restart);
+    bool addVideoTracks();
+    bool addVideoTrack(VideoTrackContext* track);
+    rtc::scoped_refptr<webrtc::RtpTransceiverInterface> findTransceiver(VideoTrackContext* track) const;
+    bool applyCodecPreferences(VideoTrackContext* track);
+    bool enablePlayoutDelayExtension(VideoTrackContext* track);
+    bool createControlChannel();
+    bool handleControlCommand(const ControlCommand& command, std::string& error);
+    void startTelemetry();
+    bool createTelemetryChannel();
+    void sendTelemetry(const uint8_t* data, size_t size);
+    bool applyEncodingLimits(VideoTrackContext* track, std::string& error);
+    bool updateEncodings(VideoTrackContext* track,
+                         const std::function<void(webrtc::RtpEncodingParameters&)>& update,
+                         std::string& error);
     void createOffer();
     void sendMessage(const std::string& message);
     std::string receiveMessage();
     
-    std::shared_ptr<VideoSource> video_source_;
-    WebRTCConfig webrtc_config_;
+    std::vector<std::unique_ptr<VideoTrackContext>> tracks_;
+    AppConfig config_;
     
     std::atomic<bool> is_streaming_;
     std::atomic<bool> should_stop_;
     std::atomic<bool> peer_connected_;
     
-    std::thread streaming_thread_;
     std::thread signaling_thread_;
     
+    // WebRTC threads (destroyed after the factory)
+    std::unique_ptr<rtc::Thread> rtc_network_thread_;
+    std::unique_ptr<rtc::Thread> rtc_worker_thread_;
+    std::unique_ptr<rtc::Thread> rtc_signaling_thread_;
+    
     // WebRTC components
     rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> peer_connection_factory_;
     rtc::scoped_refptr<webrtc::PeerConnectionInterface> peer_connection_;
-    rtc::scoped_refptr<webrtc::VideoTrackInterface> video_track_;
-    rtc::scoped_refptr<CustomVideoSource> custom_video_source_;
     
     // Observers
     std::shared_ptr<PeerConnectionObserver> pc_observer_;
     
+    // Control DataChannels（本端创建的和对端打开的）
+    std::vector<std::unique_ptr<ControlChannel>> control_channels_;
+    std::mutex control_mutex_;
+    
+    // Sensor telemetry（IMU / 帧元数据）
+    static constexpr uint64_t kMaxTelemetryBufferedBytes = 16 * 1024;
+    std::shared_ptr<SensorTelemetry> telemetry_;
+    rtc::scoped_refptr<webrtc::DataChannelInterface> telemetry_channel_;
+    std::mutex telemetry_mutex_;
+    
+    // Adaptation：adaptation 线程定时 GetStats，结果在 signaling 线程处理
+    std::unique_ptr<AdaptationController> adaptation_;
+    std::thread adaptation_thread_;
+    uint64_t last_bytes_sent_;          // 上次统计的 bytesSent（signaling 线程）
+    int64_t last_stats_us_;
+    
     // WebSocket connection
     int ws_socket_;
     std::mutex ws_mutex_;
@@ -83,7 +211,11 @@ private:
     std::condition_variable queue_cv_;
     static const size_t MAX_QUEUE_SIZE = 10;
     
-    int frame_count_;
+    // 所有轨道共用，保证延迟追踪中的帧 ID 唯一
+    std::atomic<uint64_t> next_frame_id_;
+    
+    // 只作用于本客户端（本 PeerConnection）的编码器
+    std::shared_ptr<KeyFrameTrigger> key_frames_;
 };
 
 #endif // WEBRTC_CLIENT_H
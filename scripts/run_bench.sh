@@ -0,0 +1,30 @@
+#!/bin/bash
+
+# WebRTC Streamer - 微基准测试脚本
+# 用途：编译并运行 webrtc_streamer_bench，结果以 JSON 保存，便于版本间对比
+# 用法：./scripts/run_bench.sh [额外的 benchmark 参数，如 --benchmark_filter=PushFrame]
+
+set -e
+
+SCRIPT_DIR="$( cd "$( dirname "${BASH_SOURCE[0]}" )" && pwd )"
+PROJECT_ROOT="$( cd "$SCRIPT_DIR/.." && pwd )"
+BUILD_DIR="$PROJECT_ROOT/build-bench"
+RESULTS_DIR="$PROJECT_ROOT/bench_results"
+
+cmake -S "$PROJECT_ROOT" -B "$BUILD_DIR" \
+      -DCMAKE_BUILD_TYPE=Release \
+      -DBUILD_BENCHMARKS=ON
+cmake --build "$BUILD_DIR" --target webrtc_streamer_bench -j"$(nproc)"
+
+mkdir -p "$RESULTS_DIR"
+VERSION=$(git -C "$PROJECT_ROOT" describe --tags --always --dirty 2>/dev/null || echo unknown)
+OUTPUT="$RESULTS_DIR/bench_${VERSION}_$(date +%Y%m%d_%H%M%S).json"
+
+"$BUILD_DIR/webrtc_streamer_bench" \
+    --benchmark_out="$OUTPUT" \
+    --benchmark_out_format=json \
+    "$@"
+
+echo ""
+echo "结果已保存: $OUTPUT"
+echo "对比两个版本: compare.py benchmarks <old.json> <new.json> (Google Benchmark tools/)"
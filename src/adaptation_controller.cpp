@@ -0,0 +1,148 @@
+#include "adaptation_controller.h"
+#include "signaling_utils.h"
+#include "logger.h"
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+AdaptationController::AdaptationController(const AdaptationConfig& config)
+    : config_(config), level_(0), congested_samples_(0), clean_since_ms_(-1),
+      last_upgrade_ms_(-1), hold_ms_(std::max(config.upgrade_hold_ms, 0)), min_rtt_ms_(-1) {
+    if (config_.policy == "maintain-resolution") {
+        // 先降帧率，最后才动分辨率
+        ladder_ = {{1.0, 1.0}, {1.0, 0.75}, {1.0, 0.5}, {1.0, 0.34}, {1.5, 0.34}, {2.0, 0.34}};
+    } else if (config_.policy == "latency-first") {
+        // 分辨率和帧率一起降，尽快让队列排空
+        ladder_ = {{1.0, 1.0}, {1.5, 0.75}, {2.0, 0.5}, {3.0, 0.5}, {4.0, 0.34}};
+    } else {
+        if (config_.policy != "maintain-framerate") {
+            LOG_WARN("⚠️  Unknown adaptation policy '" << config_.policy
+                     << "', using maintain-framerate");
+            config_.policy = "maintain-framerate";
+        }
+        // 遥操作默认：先降分辨率，帧率留到最后
+        ladder_ = {{1.0, 1.0}, {1.5, 1.0}, {2.0, 1.0}, {3.0, 1.0}, {4.0, 1.0}, {4.0, 0.5}};
+    }
+
+    if (!config_.log_file.empty()) {
+        log_.open(config_.log_file, std::ios::app);
+        if (!log_.is_open()) {
+            LOG_WARN("⚠️  Cannot open adaptation log " << config_.log_file);
+        }
+    }
+}
+
+std::string AdaptationController::degradationPreference() const {
+    if (config_.policy == "maintain-framerate") {
+        return "maintain_framerate";
+    } else if (config_.policy == "maintain-resolution") {
+        return "maintain_resolution";
+    }
+    return "balanced";
+}
+
+bool AdaptationController::isCongested(const LinkStats& stats, std::string& reason) const {
+    std::ostringstream why;
+    if (stats.loss >= 0 && stats.loss > config_.max_loss) {
+        why << "loss " << std::fixed << std::setprecision(1) << stats.loss * 100 << "%";
+    } else if (stats.rtt_ms > config_.max_rtt_ms) {
+        why << "rtt " << static_cast<int>(stats.rtt_ms) << " ms";
+    } else if (config_.policy == "latency-first" && stats.rtt_ms > 0 && min_rtt_ms_ > 0 &&
+               stats.rtt_ms > min_rtt_ms_ + 50) {
+        why << "queueing, rtt " << static_cast<int>(stats.rtt_ms) << " ms (base "
+            << static_cast<int>(min_rtt_ms_) << " ms)";
+    } else if (stats.available_bitrate_bps > 0 && stats.sent_bitrate_bps > 0 &&
+               stats.sent_bitrate_bps > stats.available_bitrate_bps * kOvershootRatio) {
+        // 发送持续高于带宽估计，说明队列在增长。qualityLimitationReason 不作为触发条件：
+        // BWE 爬升期间和 WebRTC 自身降级生效时它一直是 "bandwidth"，链路并不拥塞
+        why << "sending " << stats.sent_bitrate_bps / 1000 << " kbps over BWE "
+            << stats.available_bitrate_bps / 1000 << " kbps";
+    } else {
+        return false;
+    }
+    reason = why.str();
+    return true;
+}
+
+bool AdaptationController::hasHeadroom(const LinkStats& stats) const {
+    // 带宽估计未知时只看拥塞信号
+    if (stats.available_bitrate_bps <= 0 || stats.sent_bitrate_bps <= 0) {
+        return true;
+    }
+    return stats.available_bitrate_bps >= stats.sent_bitrate_bps * 3 / 2;
+}
+
+bool AdaptationController::update(const LinkStats& stats, int64_t now_ms) {
+    if (stats.rtt_ms > 0) {
+        min_rtt_ms_ = min_rtt_ms_ < 0 ? stats.rtt_ms : std::min(min_rtt_ms_, stats.rtt_ms);
+    }
+
+    std::string reason;
+    if (isCongested(stats, reason)) {
+        clean_since_ms_ = -1;
+        // 单次采样可能是抖动，连续两次才降档；降档后重新计数，给新档位一个采样周期生效
+        if (++congested_samples_ < 2 || level_ + 1 >= ladder_.size()) {
+            return false;
+        }
+        congested_samples_ = 0;
+
+        // 刚升档就拥塞：新档位带不动，加倍升档等待，避免反复试探
+        if (last_upgrade_ms_ >= 0 && now_ms - last_upgrade_ms_ < hold_ms_) {
+            hold_ms_ = std::min(hold_ms_ * 2, kMaxHoldMs);
+        }
+        last_upgrade_ms_ = -1;
+
+        size_t steps = config_.policy == "latency-first" && stats.rtt_ms > 2.0 * config_.max_rtt_ms ? 2 : 1;
+        changeLevel(std::min(level_ + steps, ladder_.size() - 1), stats, reason, now_ms);
+        return true;
+    }
+
+    congested_samples_ = 0;
+    if (clean_since_ms_ < 0) {
+        clean_since_ms_ = now_ms;
+    }
+    // 升档后稳定了一个等待周期：确认成功，等待时间逐步回落
+    if (last_upgrade_ms_ >= 0 && now_ms - last_upgrade_ms_ >= hold_ms_) {
+        hold_ms_ = std::max<int64_t>(config_.upgrade_hold_ms, hold_ms_ / 2);
+        last_upgrade_ms_ = -1;
+    }
+    // 链路干净但编码器受 CPU 限制时不升档：更高的分辨率/帧率只会让编码器更吃力
+    if (level_ == 0 || now_ms - clean_since_ms_ < hold_ms_ || !hasHeadroom(stats) ||
+        stats.quality_limitation == "cpu") {
+        return false;
+    }
+
+    std::ostringstream why;
+    why << "clean for " << (now_ms - clean_since_ms_) << " ms";
+    changeLevel(level_ - 1, stats, why.str(), now_ms);
+    last_upgrade_ms_ = now_ms;
+    clean_since_ms_ = now_ms;
+    return true;
+}
+
+void AdaptationController::changeLevel(size_t level, const LinkStats& stats,
+                                       const std::string& reason, int64_t now_ms) {
+    const size_t from = level_;
+    level_ = level;
+    const AdaptationLevel& next = ladder_[level_];
+
+    LOG_INFO("🎚️  Adaptation [" << config_.policy << "] level " << from << " → " << level_
+             << " (scale " << next.scale << ", fps x" << next.fps_factor << "): " << reason
+             << " | rtt=" << static_cast<int>(stats.rtt_ms) << "ms loss=" << stats.loss
+             << " bwe=" << stats.available_bitrate_bps / 1000 << "kbps sent="
+             << stats.sent_bitrate_bps / 1000 << "kbps limit=" << stats.quality_limitation
+             << " hold=" << hold_ms_ << "ms");
+
+    if (log_.is_open()) {
+        log_ << "{\"time_ms\":" << now_ms
+             << ",\"policy\":\"" << config_.policy << "\""
+             << ",\"from\":" << from << ",\"to\":" << level_
+             << ",\"scale\":" << next.scale << ",\"fps_factor\":" << next.fps_factor
+             << ",\"reason\":\"" << escapeJsonString(reason) << "\""
+             << ",\"rtt_ms\":" << stats.rtt_ms << ",\"loss\":" << stats.loss
+             << ",\"available_bps\":" << stats.available_bitrate_bps
+             << ",\"sent_bps\":" << stats.sent_bitrate_bps
+             << ",\"limitation\":\"" << escapeJsonString(stats.quality_limitation) << "\""
+             << ",\"hold_ms\":" << hold_ms_ << "}" << std::endl;
+    }
+}
@@ -1,21 +1,197 @@
 #include "config_parser.h"
+#include "logger.h"
+#include <algorithm>
+#include <cctype>
 #include <fstream>
 #include <iostream>
+#include <sstream>
 #include <nlohmann/json.hpp>
 
 using json = nlohmann::json;
 
+namespace {
+
+// 解析单个视频源；缺省字段保留 config 中原有的值
+void parseVideoConfig(const json& video, VideoConfig& config) {
+    if (video.contains("name")) {
+        config.name = video["name"].get<std::string>();
+    }
+    if (video.contains("source")) {
+        config.source = video["source"].get<std::string>();
+    }
+    if (video.contains("width")) {
+        config.width = video["width"].get<int>();
+    }
+    if (video.contains("height")) {
+        config.height = video["height"].get<int>();
+    }
+    if (video.contains("fps")) {
+        config.fps = video["fps"].get<int>();
+    }
+    if (video.contains("device_id")) {
+        config.device_id = video["device_id"].get<int>();
+    }
+    if (video.contains("file_path")) {
+        config.file_path = video["file_path"].get<std::string>();
+    }
+    if (video.contains("enable_depth")) {
+        config.enable_depth = video["enable_depth"].get<bool>();
+    }
+    if (video.contains("pattern")) {
+        config.pattern = video["pattern"].get<std::string>();
+    }
+    if (video.contains("pattern_format")) {
+        config.pattern_format = video["pattern_format"].get<std::string>();
+    }
+    if (video.contains("shm_name")) {
+        config.shm_name = video["shm_name"].get<std::string>();
+    }
+    if (video.contains("v4l2_format")) {
+        config.v4l2_format = video["v4l2_format"].get<std::string>();
+    }
+    if (video.contains("v4l2_buffers")) {
+        config.v4l2_buffers = video["v4l2_buffers"].get<int>();
+    }
+    if (video.contains("mjpeg_scale_width")) {
+        config.mjpeg_scale_width = video["mjpeg_scale_width"].get<int>();
+    }
+    if (video.contains("mjpeg_scale_height")) {
+        config.mjpeg_scale_height = video["mjpeg_scale_height"].get<int>();
+    }
+    if (video.contains("bitrate_priority")) {
+        config.bitrate_priority = video["bitrate_priority"].get<double>();
+    }
+    if (video.contains("timestamp_overlay")) {
+        config.timestamp_overlay = video["timestamp_overlay"].get<bool>();
+    }
+    if (video.contains("crop")) {
+        auto& crop = video["crop"];
+        if (crop.contains("x")) {
+            config.crop.x = crop["x"].get<double>();
+        }
+        if (crop.contains("y")) {
+            config.crop.y = crop["y"].get<double>();
+        }
+        if (crop.contains("width")) {
+            config.crop.width = crop["width"].get<double>();
+        }
+        if (crop.contains("height")) {
+            config.crop.height = crop["height"].get<double>();
+        }
+        if (crop.contains("output_width")) {
+            config.crop.output_width = crop["output_width"].get<int>();
+        }
+        if (crop.contains("output_height")) {
+            config.crop.output_height = crop["output_height"].get<int>();
+        }
+        if (crop.contains("transition_ms")) {
+            config.crop.transition_ms = crop["transition_ms"].get<int>();
+        }
+    }
+}
+
+void parseThreadSettings(const json& thread, ThreadSettings& settings) {
+    if (thread.contains("name")) {
+        settings.name = thread["name"].get<std::string>();
+    }
+    if (thread.contains("cpus")) {
+        settings.cpus = thread["cpus"].get<std::vector<int>>();
+    }
+    if (thread.contains("policy")) {
+        settings.policy = thread["policy"].get<std::string>();
+    }
+    if (thread.contains("priority")) {
+        settings.priority = thread["priority"].get<int>();
+    }
+}
+
+void printThreadSettings(const char* role, const ThreadSettings& settings) {
+    std::cout << "  " << role << ":";
+    if (settings.isDefault()) {
+        std::cout << " 默认" << std::endl;
+        return;
+    }
+    if (!settings.name.empty()) {
+        std::cout << " name=" << settings.name;
+    }
+    if (!settings.cpus.empty()) {
+        std::cout << " cpus=";
+        for (size_t i = 0; i < settings.cpus.size(); i++) {
+            std::cout << (i > 0 ? "," : "") << settings.cpus[i];
+        }
+    }
+    std::cout << " policy=" << settings.policy;
+    if (settings.policy != "other") {
+        std::cout << "/" << settings.priority;
+    }
+    std::cout << std::endl;
+}
+
+void printVideoConfig(const VideoConfig& video) {
+    if (!video.name.empty()) {
+        std::cout << "  轨道: " << video.name << std::endl;
+    }
+    std::cout << "  源类型: " << video.source << std::endl;
+    std::cout << "  分辨率: " << video.width << "x" << video.height << std::endl;
+    std::cout << "  帧率: " << video.fps << " fps" << std::endl;
+    if (video.source == "camera" || video.source == "v4l2") {
+        std::cout << "  设备ID: " << video.device_id << std::endl;
+    }
+    if (video.source == "v4l2") {
+        std::cout << "  V4L2 格式: " << video.v4l2_format 
+                  << "，缓冲区: " << video.v4l2_buffers << std::endl;
+    }
+    if (video.mjpeg_scale_width > 0 && video.mjpeg_scale_height > 0) {
+        std::cout << "  MJPEG 缩放解码: " << video.mjpeg_scale_width << "x"
+                  << video.mjpeg_scale_height << std::endl;
+    }
+    if (!video.file_path.empty()) {
+        std::cout << "  文件路径: " << video.file_path << std::endl;
+    }
+    if (video.source == "pattern") {
+        std::cout << "  测试图案: " << video.pattern 
+                  << " (" << video.pattern_format << ")" << std::endl;
+    }
+    if (video.source == "shm") {
+        std::cout << "  共享内存: " << video.shm_name << "（分辨率/格式由生产者决定）" << std::endl;
+    }
+    if (video.source == "realsense") {
+        std::cout << "  深度流: " << (video.enable_depth ? "启用" : "禁用") << std::endl;
+    }
+    if (video.bitrate_priority != 1.0) {
+        std::cout << "  码率权重: " << video.bitrate_priority << std::endl;
+    }
+    if (!video.timestamp_overlay) {
+        std::cout << "  时间戳叠加: 关闭" << std::endl;
+    }
+    if (!video.crop.isFullFrame()) {
+        std::cout << "  裁剪窗口: (" << video.crop.x << ", " << video.crop.y << ") "
+                  << video.crop.width << "x" << video.crop.height << std::endl;
+    }
+    if (video.crop.output_width > 0 && video.crop.output_height > 0) {
+        std::cout << "  裁剪输出: " << video.crop.output_width << "x" << video.crop.output_height << std::endl;
+    }
+}
+
+} // namespace
+
 bool ConfigParser::loadFromFile(const std::string& config_file) {
     std::ifstream file(config_file);
     if (!file.is_open()) {
-        std::cerr << "无法打开配置文件: " << config_file << std::endl;
-        std::cerr << "使用默认配置" << std::endl;
+        LOG_WARN("⚠️  无法打开配置文件: " << config_file << "，使用默认配置");
         return false;
     }
     
     try {
         json j = json::parse(file);
         
+        if (j.contains("latency_mode")) {
+            config_.latency_mode = j["latency_mode"].get<std::string>();
+        }
+        if (j.contains("hot_reload")) {
+            config_.hot_reload = j["hot_reload"].get<bool>();
+        }
+        
         // 解析 WebRTC 配置
         if (j.contains("webrtc")) {
             auto& webrtc = j["webrtc"];
@@ -38,6 +214,9 @@ bool ConfigParser::loadFromFile(const std::string& config_file) {
             if (webrtc.contains("target_id")) {
                 config_.webrtc.target_id = webrtc["target_id"].get<std::string>();
             }
+            if (webrtc.contains("control_channel")) {
+                config_.webrtc.control_channel = webrtc["control_channel"].get<bool>();
+            }
             
             // 解析 ICE servers
             if (webrtc.contains("ice_servers")) {
@@ -67,30 +246,221 @@ bool ConfigParser::loadFromFile(const std::string& config_file) {
             }
         }
         
-        // 解析 Video 配置
+        // 解析 Video 配置（单个对象，或多路视频源数组）
         if (j.contains("video")) {
             auto& video = j["video"];
             
-            if (video.contains("source")) {
-                config_.video.source = video["source"].get<std::string>();
+            if (video.is_array()) {
+                config_.extra_videos.clear();
+                for (size_t i = 0; i < video.size(); i++) {
+                    if (i == 0) {
+                        parseVideoConfig(video[i], config_.video);
+                    } else {
+                        VideoConfig extra;
+                        parseVideoConfig(video[i], extra);
+                        config_.extra_videos.push_back(extra);
+                    }
+                }
+            } else {
+                parseVideoConfig(video, config_.video);
+            }
+        }
+        
+        // 解析 Mosaic 配置
+        if (j.contains("mosaic")) {
+            auto& mosaic = j["mosaic"];
+            
+            if (mosaic.contains("enabled")) {
+                config_.mosaic.enabled = mosaic["enabled"].get<bool>();
+            }
+            if (mosaic.contains("width")) {
+                config_.mosaic.width = mosaic["width"].get<int>();
+            }
+            if (mosaic.contains("height")) {
+                config_.mosaic.height = mosaic["height"].get<int>();
+            }
+            if (mosaic.contains("fps")) {
+                config_.mosaic.fps = mosaic["fps"].get<int>();
+            }
+            if (mosaic.contains("layout")) {
+                config_.mosaic.layout = mosaic["layout"].get<std::string>();
+            }
+            if (mosaic.contains("keep_aspect")) {
+                config_.mosaic.keep_aspect = mosaic["keep_aspect"].get<bool>();
+            }
+            if (mosaic.contains("tiles")) {
+                config_.mosaic.tiles.clear();
+                for (auto& tile : mosaic["tiles"]) {
+                    config_.mosaic.tiles.push_back(MosaicTile(
+                        tile.value("x", 0), tile.value("y", 0),
+                        tile.value("width", 0), tile.value("height", 0)));
+                }
+            }
+        }
+        
+        // 解析静止画面检测配置
+        if (j.contains("static_scene")) {
+            auto& static_scene = j["static_scene"];
+            
+            if (static_scene.contains("enabled")) {
+                config_.static_scene.enabled = static_scene["enabled"].get<bool>();
+            }
+            if (static_scene.contains("threshold")) {
+                config_.static_scene.threshold = static_scene["threshold"].get<double>();
             }
-            if (video.contains("width")) {
-                config_.video.width = video["width"].get<int>();
+            if (static_scene.contains("hold_ms")) {
+                config_.static_scene.hold_ms = static_scene["hold_ms"].get<int>();
             }
-            if (video.contains("height")) {
-                config_.video.height = video["height"].get<int>();
+            if (static_scene.contains("keepalive_fps")) {
+                config_.static_scene.keepalive_fps = static_scene["keepalive_fps"].get<int>();
             }
-            if (video.contains("fps")) {
-                config_.video.fps = video["fps"].get<int>();
+        }
+        
+        // 解析传感器遥测配置
+        if (j.contains("telemetry")) {
+            auto& telemetry = j["telemetry"];
+            
+            if (telemetry.contains("enabled")) {
+                config_.telemetry.enabled = telemetry["enabled"].get<bool>();
             }
-            if (video.contains("device_id")) {
-                config_.video.device_id = video["device_id"].get<int>();
+            if (telemetry.contains("imu")) {
+                config_.telemetry.imu = telemetry["imu"].get<bool>();
             }
-            if (video.contains("file_path")) {
-                config_.video.file_path = video["file_path"].get<std::string>();
+            if (telemetry.contains("metadata")) {
+                config_.telemetry.metadata = telemetry["metadata"].get<bool>();
             }
-            if (video.contains("enable_depth")) {
-                config_.video.enable_depth = video["enable_depth"].get<bool>();
+            if (telemetry.contains("accel_fps")) {
+                config_.telemetry.accel_fps = telemetry["accel_fps"].get<int>();
+            }
+            if (telemetry.contains("gyro_fps")) {
+                config_.telemetry.gyro_fps = telemetry["gyro_fps"].get<int>();
+            }
+            if (telemetry.contains("packet_rate_hz")) {
+                config_.telemetry.packet_rate_hz = telemetry["packet_rate_hz"].get<int>();
+            }
+        }
+        
+        // 解析自适应控制配置
+        if (j.contains("adaptation")) {
+            auto& adaptation = j["adaptation"];
+            
+            if (adaptation.contains("enabled")) {
+                config_.adaptation.enabled = adaptation["enabled"].get<bool>();
+            }
+            if (adaptation.contains("policy")) {
+                config_.adaptation.policy = adaptation["policy"].get<std::string>();
+            }
+            if (adaptation.contains("interval_ms")) {
+                config_.adaptation.interval_ms = adaptation["interval_ms"].get<int>();
+            }
+            if (adaptation.contains("max_rtt_ms")) {
+                config_.adaptation.max_rtt_ms = adaptation["max_rtt_ms"].get<int>();
+            }
+            if (adaptation.contains("max_loss")) {
+                config_.adaptation.max_loss = adaptation["max_loss"].get<double>();
+            }
+            if (adaptation.contains("upgrade_hold_ms")) {
+                config_.adaptation.upgrade_hold_ms = adaptation["upgrade_hold_ms"].get<int>();
+            }
+            if (adaptation.contains("log_file")) {
+                config_.adaptation.log_file = adaptation["log_file"].get<std::string>();
+            }
+        }
+        
+        // 解析抗丢包配置
+        if (j.contains("resilience")) {
+            auto& resilience = j["resilience"];
+            
+            if (resilience.contains("codec_preferences")) {
+                config_.resilience.codec_preferences =
+                    resilience["codec_preferences"].get<std::vector<std::string>>();
+            }
+            if (resilience.contains("nack")) {
+                config_.resilience.nack = resilience["nack"].get<bool>();
+            }
+            if (resilience.contains("rtx")) {
+                config_.resilience.rtx = resilience["rtx"].get<bool>();
+            }
+            if (resilience.contains("red_ulpfec")) {
+                config_.resilience.red_ulpfec = resilience["red_ulpfec"].get<bool>();
+            }
+            if (resilience.contains("flexfec")) {
+                config_.resilience.flexfec = resilience["flexfec"].get<bool>();
+            }
+            if (resilience.contains("start_bitrate_kbps")) {
+                config_.resilience.start_bitrate_kbps = resilience["start_bitrate_kbps"].get<int>();
+            }
+            if (resilience.contains("min_bitrate_kbps")) {
+                config_.resilience.min_bitrate_kbps = resilience["min_bitrate_kbps"].get<int>();
+            }
+            if (resilience.contains("max_bitrate_kbps")) {
+                config_.resilience.max_bitrate_kbps = resilience["max_bitrate_kbps"].get<int>();
+            }
+        }
+        
+        // 解析编码器配置
+        if (j.contains("encoder")) {
+            auto& encoder = j["encoder"];
+            
+            if (encoder.contains("degradation_preference")) {
+                config_.encoder.degradation_preference = encoder["degradation_preference"].get<std::string>();
+            }
+            if (encoder.contains("playout_delay_ms")) {
+                config_.encoder.playout_delay_ms = encoder["playout_delay_ms"].get<int>();
+            }
+            if (encoder.contains("vp8")) {
+                auto& vp8 = encoder["vp8"];
+                if (vp8.contains("threads")) {
+                    config_.encoder.vp8.threads = vp8["threads"].get<int>();
+                }
+                if (vp8.contains("complexity")) {
+                    config_.encoder.vp8.complexity = vp8["complexity"].get<std::string>();
+                }
+            }
+            if (encoder.contains("h264")) {
+                auto& h264 = encoder["h264"];
+                if (h264.contains("implementation")) {
+                    config_.encoder.h264.implementation = h264["implementation"].get<std::string>();
+                }
+                if (h264.contains("threads")) {
+                    config_.encoder.h264.threads = h264["threads"].get<int>();
+                }
+                if (h264.contains("preset")) {
+                    config_.encoder.h264.preset = h264["preset"].get<std::string>();
+                }
+                if (h264.contains("slices")) {
+                    config_.encoder.h264.slices = h264["slices"].get<int>();
+                }
+                if (h264.contains("vbv_ms")) {
+                    config_.encoder.h264.vbv_ms = h264["vbv_ms"].get<int>();
+                }
+                if (h264.contains("intra_refresh")) {
+                    config_.encoder.h264.intra_refresh = h264["intra_refresh"].get<bool>();
+                }
+            }
+        }
+        
+        // 解析线程配置
+        if (j.contains("threads")) {
+            auto& threads = j["threads"];
+            
+            if (threads.contains("capture")) {
+                parseThreadSettings(threads["capture"], config_.threads.capture);
+            }
+            if (threads.contains("encoder")) {
+                parseThreadSettings(threads["encoder"], config_.threads.encoder);
+            }
+            if (threads.contains("network")) {
+                parseThreadSettings(threads["network"], config_.threads.network);
+            }
+            if (threads.contains("worker")) {
+                parseThreadSettings(threads["worker"], config_.threads.worker);
+            }
+            if (threads.contains("signaling")) {
+                parseThreadSettings(threads["signaling"], config_.threads.signaling);
+            }
+            if (threads.contains("adaptation")) {
+                parseThreadSettings(threads["adaptation"], config_.threads.adaptation);
             }
         }
         
@@ -104,18 +474,56 @@ bool ConfigParser::loadFromFile(const std::string& config_file) {
             if (logging.contains("enable_timestamp")) {
                 config_.logging.enable_timestamp = logging["enable_timestamp"].get<bool>();
             }
+            if (logging.contains("format")) {
+                config_.logging.format = logging["format"].get<std::string>();
+            }
         }
         
-        std::cout << "配置文件加载成功: " << config_file << std::endl;
+        // 解析 Tracing 配置
+        if (j.contains("tracing")) {
+            auto& tracing = j["tracing"];
+            
+            if (tracing.contains("enabled")) {
+                config_.tracing.enabled = tracing["enabled"].get<bool>();
+            }
+            if (tracing.contains("output_file")) {
+                config_.tracing.output_file = tracing["output_file"].get<std::string>();
+            }
+        }
+        
+        // 解析 Recording 配置
+        if (j.contains("recording")) {
+            auto& recording = j["recording"];
+            
+            if (recording.contains("enabled")) {
+                config_.recording.enabled = recording["enabled"].get<bool>();
+            }
+            if (recording.contains("directory")) {
+                config_.recording.directory = recording["directory"].get<std::string>();
+            }
+            if (recording.contains("prefix")) {
+                config_.recording.prefix = recording["prefix"].get<std::string>();
+            }
+            if (recording.contains("format")) {
+                config_.recording.format = recording["format"].get<std::string>();
+            }
+            if (recording.contains("segment_seconds")) {
+                config_.recording.segment_seconds = recording["segment_seconds"].get<int>();
+            }
+            if (recording.contains("max_queue_mb")) {
+                config_.recording.max_queue_mb = recording["max_queue_mb"].get<int>();
+            }
+        }
+        
+        document_ = j.dump();
+        LOG_INFO("📄 配置文件加载成功: " << config_file);
         return true;
         
     } catch (const json::parse_error& e) {
-        std::cerr << "JSON 解析错误: " << e.what() << std::endl;
-        std::cerr << "使用默认配置" << std::endl;
+        LOG_ERROR("❌ JSON 解析错误: " << e.what() << "，使用默认配置");
         return false;
     } catch (const std::exception& e) {
-        std::cerr << "解析配置文件出错: " << e.what() << std::endl;
-        std::cerr << "使用默认配置" << std::endl;
+        LOG_ERROR("❌ 解析配置文件出错: " << e.what() << "，使用默认配置");
         return false;
     }
 }
@@ -124,6 +532,8 @@ void ConfigParser::printConfig() const {
     std::cout << "\n========================================" << std::endl;
     std::cout << "当前配置:" << std::endl;
     std::cout << "========================================" << std::endl;
+    std::cout << "延迟模式: " << config_.latency_mode << std::endl;
+    std::cout << "配置热加载: " << (config_.hot_reload ? "启用" : "禁用") << std::endl;
     
     std::cout << "\n[WebRTC]" << std::endl;
     std::cout << "  服务器: " << config_.webrtc.server_ip 
@@ -142,24 +552,127 @@ void ConfigParser::printConfig() const {
             std::cout << "        Credential: " << std::string(ice.credential.length(), '*') << std::endl;
         }
     }
+    std::cout << "  控制通道: " << (config_.webrtc.control_channel ? "启用 (DataChannel \"control\")" : "禁用")
+              << std::endl;
     
     std::cout << "\n[Video]" << std::endl;
-    std::cout << "  源类型: " << config_.video.source << std::endl;
-    std::cout << "  分辨率: " << config_.video.width << "x" << config_.video.height << std::endl;
-    std::cout << "  帧率: " << config_.video.fps << " fps" << std::endl;
-    if (config_.video.source == "camera") {
-        std::cout << "  设备ID: " << config_.video.device_id << std::endl;
+    printVideoConfig(config_.video);
+    for (size_t i = 0; i < config_.extra_videos.size(); i++) {
+        std::cout << "\n[Video " << i + 2 << "]" << std::endl;
+        printVideoConfig(config_.extra_videos[i]);
     }
-    if (!config_.video.file_path.empty()) {
-        std::cout << "  文件路径: " << config_.video.file_path << std::endl;
+    
+    std::cout << "\n[Mosaic]" << std::endl;
+    std::cout << "  画面合成: " << (config_.mosaic.enabled ? "启用" : "禁用") << std::endl;
+    if (config_.mosaic.enabled) {
+        std::cout << "  画布: " << config_.mosaic.width << "x" << config_.mosaic.height
+                  << " @ " << config_.mosaic.fps << " fps" << std::endl;
+        std::cout << "  布局: " << config_.mosaic.layout
+                  << (config_.mosaic.keep_aspect ? "（保持宽高比）" : "（拉伸）") << std::endl;
+        for (size_t i = 0; i < config_.mosaic.tiles.size(); i++) {
+            const auto& tile = config_.mosaic.tiles[i];
+            std::cout << "    [" << i + 1 << "] " << tile.width << "x" << tile.height
+                      << " at (" << tile.x << ", " << tile.y << ")" << std::endl;
+        }
+    }
+    
+    std::cout << "\n[Static Scene]" << std::endl;
+    std::cout << "  静止检测: " << (config_.static_scene.enabled ? "启用" : "禁用") << std::endl;
+    if (config_.static_scene.enabled) {
+        std::cout << "  阈值: " << config_.static_scene.threshold
+                  << "，静止 " << config_.static_scene.hold_ms << " ms 后降至 "
+                  << config_.static_scene.keepalive_fps << " fps" << std::endl;
     }
-    if (config_.video.source == "realsense") {
-        std::cout << "  深度流: " << (config_.video.enable_depth ? "启用" : "禁用") << std::endl;
+    
+    std::cout << "\n[Telemetry]" << std::endl;
+    std::cout << "  传感器遥测: " << (config_.telemetry.enabled ? "启用" : "禁用") << std::endl;
+    if (config_.telemetry.enabled) {
+        if (config_.telemetry.imu) {
+            std::cout << "  IMU: accel " << config_.telemetry.accel_fps << " Hz, gyro "
+                      << config_.telemetry.gyro_fps << " Hz" << std::endl;
+        }
+        std::cout << "  帧元数据: " << (config_.telemetry.metadata ? "启用" : "禁用") << std::endl;
+        std::cout << "  打包频率: " << config_.telemetry.packet_rate_hz << " Hz" << std::endl;
     }
     
+    std::cout << "\n[Adaptation]" << std::endl;
+    std::cout << "  自适应控制: " << (config_.adaptation.enabled ? "启用" : "禁用") << std::endl;
+    if (config_.adaptation.enabled) {
+        std::cout << "  策略: " << config_.adaptation.policy
+                  << "，采样间隔 " << config_.adaptation.interval_ms << " ms" << std::endl;
+        std::cout << "  拥塞阈值: RTT > " << config_.adaptation.max_rtt_ms << " ms 或丢包 > "
+                  << config_.adaptation.max_loss * 100 << "%" << std::endl;
+        std::cout << "  升档等待: " << config_.adaptation.upgrade_hold_ms << " ms" << std::endl;
+        if (!config_.adaptation.log_file.empty()) {
+            std::cout << "  决策日志: " << config_.adaptation.log_file << std::endl;
+        }
+    }
+    
+    std::cout << "\n[Resilience]" << std::endl;
+    std::cout << "  编码格式优先级: ";
+    if (config_.resilience.codec_preferences.empty()) {
+        std::cout << "默认";
+    }
+    for (size_t i = 0; i < config_.resilience.codec_preferences.size(); i++) {
+        std::cout << (i > 0 ? " > " : "") << config_.resilience.codec_preferences[i];
+    }
+    std::cout << std::endl;
+    std::cout << "  NACK: " << (config_.resilience.nack ? "启用" : "禁用")
+              << "，RTX: " << (config_.resilience.rtx ? "启用" : "禁用")
+              << "，RED/ULPFEC: " << (config_.resilience.red_ulpfec ? "启用" : "禁用")
+              << "，FlexFEC: " << (config_.resilience.flexfec ? "启用" : "禁用") << std::endl;
+    std::cout << "  码率 (kbps): start=" << config_.resilience.start_bitrate_kbps
+              << " min=" << config_.resilience.min_bitrate_kbps
+              << " max=" << config_.resilience.max_bitrate_kbps << "（0 = 默认）" << std::endl;
+    
+    std::cout << "\n[Encoder]" << std::endl;
+    std::cout << "  降级策略: " << config_.encoder.degradation_preference << std::endl;
+    std::cout << "  播放延迟: ";
+    if (config_.encoder.playout_delay_ms >= 0) {
+        std::cout << config_.encoder.playout_delay_ms << " ms (playout-delay 扩展)" << std::endl;
+    } else {
+        std::cout << "由接收端决定" << std::endl;
+    }
+    std::cout << "  VP8: threads=" << config_.encoder.vp8.threads
+              << " complexity=" << config_.encoder.vp8.complexity << std::endl;
+    std::cout << "  H264: " << config_.encoder.h264.implementation;
+    if (config_.encoder.h264.implementation == "libx264") {
+        std::cout << " threads=" << config_.encoder.h264.threads
+                  << " preset=" << config_.encoder.h264.preset
+                  << " slices=" << config_.encoder.h264.slices
+                  << " vbv=" << (config_.encoder.h264.vbv_ms > 0
+                                     ? std::to_string(config_.encoder.h264.vbv_ms) + "ms" : "1 frame")
+                  << " intra_refresh=" << (config_.encoder.h264.intra_refresh ? "on" : "off");
+    }
+    std::cout << std::endl;
+    
+    std::cout << "\n[Threads]" << std::endl;
+    printThreadSettings("capture", config_.threads.capture);
+    printThreadSettings("encoder", config_.threads.encoder);
+    printThreadSettings("network", config_.threads.network);
+    printThreadSettings("worker", config_.threads.worker);
+    printThreadSettings("signaling", config_.threads.signaling);
+    printThreadSettings("adaptation", config_.threads.adaptation);
+    
     std::cout << "\n[Logging]" << std::endl;
     std::cout << "  级别: " << config_.logging.level << std::endl;
     std::cout << "  时间戳: " << (config_.logging.enable_timestamp ? "启用" : "禁用") << std::endl;
+    std::cout << "  格式: " << config_.logging.format << std::endl;
+    
+    std::cout << "\n[Tracing]" << std::endl;
+    std::cout << "  延迟追踪: " << (config_.tracing.enabled ? "启用" : "禁用") << std::endl;
+    if (config_.tracing.enabled) {
+        std::cout << "  输出文件: " << config_.tracing.output_file << std::endl;
+    }
+    
+    std::cout << "\n[Recording]" << std::endl;
+    std::cout << "  编码流录制: " << (config_.recording.enabled ? "启用" : "禁用") << std::endl;
+    if (config_.recording.enabled) {
+        std::cout << "  输出: " << config_.recording.directory << "/" << config_.recording.prefix
+                  << "_*." << config_.recording.format << std::endl;
+        std::cout << "  分段: " << config_.recording.segment_seconds << " 秒" << std::endl;
+        std::cout << "  队列上限: " << config_.recording.max_queue_mb << " MB" << std::endl;
+    }
     
     std::cout << "========================================\n" << std::endl;
 }
@@ -172,11 +685,14 @@ bool ConfigParser::createDefaultConfig(const std::string& config_file) {
     }
     
     file << R"({
+  "latency_mode": "normal",
+  "hot_reload": true,
   "webrtc": {
     "server": {
       "ip": "192.168.1.34",
       "port": 50061
     },
+    "control_channel": true,
     "ice_servers": [
       {
         "urls": ["stun:stun.l.google.com:19302"]
@@ -192,17 +708,115 @@ bool ConfigParser::createDefaultConfig(const std::string& config_file) {
     ]
   },
   "video": {
+    "name": "",
     "source": "realsense",
     "width": 640,
     "height": 480,
     "fps": 30,
     "device_id": 0,
     "file_path": "",
-    "enable_depth": false
+    "enable_depth": false,
+    "pattern": "bars",
+    "pattern_format": "bgr",
+    "shm_name": "/webrtc_frames",
+    "v4l2_format": "yuyv",
+    "v4l2_buffers": 4,
+    "mjpeg_scale_width": 0,
+    "mjpeg_scale_height": 0,
+    "bitrate_priority": 1.0,
+    "timestamp_overlay": true,
+    "crop": {
+      "x": 0.0,
+      "y": 0.0,
+      "width": 1.0,
+      "height": 1.0,
+      "output_width": 0,
+      "output_height": 0,
+      "transition_ms": 300
+    }
+  },
+  "mosaic": {
+    "enabled": false,
+    "width": 1280,
+    "height": 720,
+    "fps": 30,
+    "layout": "grid",
+    "keep_aspect": true,
+    "tiles": []
+  },
+  "static_scene": {
+    "enabled": false,
+    "threshold": 3.0,
+    "hold_ms": 2000,
+    "keepalive_fps": 1
+  },
+  "telemetry": {
+    "enabled": false,
+    "imu": true,
+    "metadata": true,
+    "accel_fps": 250,
+    "gyro_fps": 200,
+    "packet_rate_hz": 100
+  },
+  "adaptation": {
+    "enabled": false,
+    "policy": "maintain-framerate",
+    "interval_ms": 500,
+    "max_rtt_ms": 250,
+    "max_loss": 0.05,
+    "upgrade_hold_ms": 5000,
+    "log_file": ""
+  },
+  "resilience": {
+    "codec_preferences": [],
+    "nack": true,
+    "rtx": true,
+    "red_ulpfec": true,
+    "flexfec": false,
+    "start_bitrate_kbps": 0,
+    "min_bitrate_kbps": 0,
+    "max_bitrate_kbps": 0
+  },
+  "encoder": {
+    "degradation_preference": "balanced",
+    "playout_delay_ms": -1,
+    "vp8": {
+      "threads": 0,
+      "complexity": "normal"
+    },
+    "h264": {
+      "implementation": "openh264",
+      "threads": 0,
+      "preset": "veryfast",
+      "slices": 0,
+      "vbv_ms": 500,
+      "intra_refresh": false
+    }
+  },
+  "threads": {
+    "capture": { "cpus": [], "policy": "other", "priority": 0 },
+    "encoder": { "cpus": [], "policy": "other", "priority": 0 },
+    "network": { "cpus": [], "policy": "other", "priority": 0 },
+    "worker": { "cpus": [], "policy": "other", "priority": 0 },
+    "signaling": { "cpus": [], "policy": "other", "priority": 0 },
+    "adaptation": { "cpus": [], "policy": "other", "priority": 0 }
   },
   "logging": {
     "level": "info",
-    "enable_timestamp": true
+    "enable_timestamp": true,
+    "format": "text"
+  },
+  "tracing": {
+    "enabled": false,
+    "output_file": "latency_trace.json"
+  },
+  "recording": {
+    "enabled": false,
+    "directory": "recordings",
+    "prefix": "stream",
+    "format": "mkv",
+    "segment_seconds": 300,
+    "max_queue_mb": 32
   }
 }
 )";
@@ -211,3 +825,68 @@ bool ConfigParser::createDefaultConfig(const std::string& config_file) {
     std::cout << "默认配置文件已创建: " << config_file << std::endl;
     return true;
 }
+
+bool applyLatencyProfile(AppConfig& config) {
+    if (config.latency_mode == "normal") {
+        return true;
+    }
+    if (config.latency_mode != "ultra") {
+        LOG_ERROR("❌ 未知的延迟模式: " << config.latency_mode << "（可选 normal | ultra）");
+        return false;
+    }
+    
+    // 接收端收到即解码显示，不为平滑播放缓冲
+    config.encoder.playout_delay_ms = 0;
+    // 一帧 VBV + 帧内刷新：每帧大小接近平均值，不会因大关键帧在发送队列排队
+    config.encoder.h264.implementation = "libx264";
+    config.encoder.h264.vbv_ms = 0;
+    config.encoder.h264.intra_refresh = true;
+    // 上面的码控设置只对 libx264 生效，未指定时优先协商 H264
+    if (config.resilience.codec_preferences.empty()) {
+        config.resilience.codec_preferences = {"H264"};
+    }
+    return true;
+}
+
+std::vector<std::string> latencyProfileFields(const std::string& latency_mode) {
+    if (latency_mode != "ultra") {
+        return {};
+    }
+    // 与 applyLatencyProfile 保持一致；codec_preferences 只在为空时填充，不算覆盖
+    return {"encoder.playout_delay_ms", "encoder.h264.implementation",
+            "encoder.h264.vbv_ms", "encoder.h264.intra_refresh"};
+}
+
+std::vector<std::string> ConfigParser::changedFields(const ConfigParser& other) const {
+    json before = document_.empty() ? json::object() : json::parse(document_);
+    json after = other.document_.empty() ? json::object() : json::parse(other.document_);
+    
+    std::vector<std::string> fields;
+    for (const auto& op : json::diff(before, after)) {
+        // JSON Pointer → 点分字段名。多路视频源保留下标（"/video/1/crop/x" → "video.1.crop.x"），
+        // 第 0 路与单个对象写法同名（"video.crop.x"）；其余数组不区分下标
+        std::string field;
+        std::istringstream path(op["path"].get<std::string>());
+        std::string token;
+        while (std::getline(path, token, '/')) {
+            if (token.empty()) {
+                continue;
+            }
+            // "-" 为 json::diff 表示追加到数组末尾的下标，视频源数量变化报告为 "video"
+            if (token == "-" || std::all_of(token.begin(), token.end(), ::isdigit)) {
+                if (field == "video" && token != "0" && token != "-") {
+                    field += "." + token;
+                }
+                continue;
+            }
+            field += (field.empty() ? "" : ".") + token;
+        }
+        if (field.empty()) {
+            field = "<root>";
+        }
+        if (std::find(fields.begin(), fields.end(), field) == fields.end()) {
+            fields.push_back(field);
+        }
+    }
+    return fields;
+}
@@ -0,0 +1,93 @@
+#include "config_watcher.h"
+#include "logger.h"
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+ConfigWatcher::ConfigWatcher(const std::string& path, Callback on_change)
+    : path_(path), on_change_(std::move(on_change)), inotify_fd_(-1), should_stop_(false) {
+    size_t slash = path_.find_last_of('/');
+    if (slash == std::string::npos) {
+        directory_ = ".";
+        file_name_ = path_;
+    } else {
+        directory_ = slash == 0 ? "/" : path_.substr(0, slash);
+        file_name_ = path_.substr(slash + 1);
+    }
+}
+
+ConfigWatcher::~ConfigWatcher() {
+    stop();
+}
+
+bool ConfigWatcher::start() {
+    if (thread_.joinable()) {
+        return true;
+    }
+    inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd_ < 0) {
+        LOG_WARN("⚠️  inotify_init1 failed: " << strerror(errno));
+        return false;
+    }
+    // 原地写入（IN_CLOSE_WRITE）和写临时文件再改名（IN_MOVED_TO）两种保存方式
+    if (inotify_add_watch(inotify_fd_, directory_.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        LOG_WARN("⚠️  Cannot watch " << directory_ << ": " << strerror(errno));
+        close(inotify_fd_);
+        inotify_fd_ = -1;
+        return false;
+    }
+    should_stop_ = false;
+    thread_ = std::thread(&ConfigWatcher::watchThread, this);
+    LOG_INFO("👀 Watching " << path_ << " for changes");
+    return true;
+}
+
+void ConfigWatcher::stop() {
+    should_stop_ = true;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    if (inotify_fd_ >= 0) {
+        close(inotify_fd_);
+        inotify_fd_ = -1;
+    }
+}
+
+void ConfigWatcher::watchThread() {
+    // inotify_event 后跟变长文件名，按其对齐要求分配
+    alignas(struct inotify_event) char buffer[4096];
+    bool pending = false;
+    auto deadline = std::chrono::steady_clock::now();
+
+    while (!should_stop_) {
+        struct pollfd pfd = {inotify_fd_, POLLIN, 0};
+        int ret = poll(&pfd, 1, kPollTimeoutMs);
+        if (ret < 0 && errno != EINTR) {
+            LOG_WARN("⚠️  Config watcher poll failed: " << strerror(errno));
+            return;
+        }
+
+        if (ret > 0) {
+            ssize_t length;
+            while ((length = read(inotify_fd_, buffer, sizeof(buffer))) > 0) {
+                for (char* ptr = buffer; ptr < buffer + length;) {
+                    const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(ptr);
+                    if (event->len > 0 && file_name_ == event->name) {
+                        // 连续多次写入只在最后一次之后重新加载
+                        pending = true;
+                        deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(kDebounceMs);
+                    }
+                    ptr += sizeof(struct inotify_event) + event->len;
+                }
+            }
+        }
+
+        if (pending && std::chrono::steady_clock::now() >= deadline) {
+            pending = false;
+            on_change_();
+        }
+    }
+}
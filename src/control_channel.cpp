@@ -0,0 +1,119 @@
+#include "control_channel.h"
+#include "signaling_utils.h"
+#include "logger.h"
+#include <nlohmann/json.hpp>
+#include <sstream>
+
+using json = nlohmann::json;
+
+ControlChannel::ControlChannel(rtc::scoped_refptr<webrtc::DataChannelInterface> channel,
+                               Handler handler)
+    : channel_(channel), handler_(std::move(handler)) {
+    channel_->RegisterObserver(this);
+}
+
+ControlChannel::~ControlChannel() {
+    channel_->UnregisterObserver();
+    channel_->Close();
+}
+
+bool ControlChannel::parseCommand(const std::string& text, ControlCommand& command,
+                                  std::string& error) {
+    json j = json::parse(text, nullptr, false);
+    if (j.is_discarded() || !j.is_object()) {
+        error = "invalid JSON";
+        return false;
+    }
+    if (!j.contains("cmd") || !j["cmd"].is_string()) {
+        error = "missing \"cmd\"";
+        return false;
+    }
+
+    command = ControlCommand();
+    command.cmd = j["cmd"].get<std::string>();
+
+    try {
+        if (j.contains("track")) {
+            command.track = j["track"].get<std::string>();
+        }
+
+        if (command.cmd == "bitrate") {
+            command.max_kbps = j.value("max_kbps", 0);
+            if (command.max_kbps < 0) {
+                error = "max_kbps must be >= 0";
+                return false;
+            }
+        } else if (command.cmd == "fps") {
+            command.max_fps = j.value("max_fps", 0.0);
+            if (command.max_fps < 0) {
+                error = "max_fps must be >= 0";
+                return false;
+            }
+        } else if (command.cmd == "scale") {
+            command.scale = j.value("factor", 1.0);
+            if (command.scale < 1.0) {
+                error = "factor must be >= 1";
+                return false;
+            }
+        } else if (command.cmd == "crop") {
+            command.crop_x = j.value("x", 0.0);
+            command.crop_y = j.value("y", 0.0);
+            command.crop_width = j.value("width", 1.0);
+            command.crop_height = j.value("height", 1.0);
+            if (command.crop_x < 0 || command.crop_y < 0 ||
+                command.crop_width <= 0 || command.crop_height <= 0 ||
+                command.crop_x + command.crop_width > 1.0 + 1e-6 ||
+                command.crop_y + command.crop_height > 1.0 + 1e-6) {
+                error = "crop window must lie within [0, 1]";
+                return false;
+            }
+        } else if (command.cmd == "keyframe") {
+            // 关键帧请求作用于本连接的所有编码器，无法只针对一个轨道
+            if (!command.track.empty()) {
+                error = "keyframe applies to all tracks and does not accept \"track\"";
+                return false;
+            }
+        } else {
+            error = "unknown command: " + command.cmd;
+            return false;
+        }
+    } catch (const json::exception& e) {
+        error = e.what();
+        return false;
+    }
+    return true;
+}
+
+void ControlChannel::OnStateChange() {
+    if (channel_->state() == webrtc::DataChannelInterface::kOpen) {
+        LOG_INFO("🎮 Control channel '" << channel_->label() << "' open");
+    } else if (channel_->state() == webrtc::DataChannelInterface::kClosed) {
+        LOG_INFO("🎮 Control channel '" << channel_->label() << "' closed");
+    }
+}
+
+void ControlChannel::OnMessage(const webrtc::DataBuffer& buffer) {
+    if (buffer.binary) {
+        reply("", false, "binary messages are not supported");
+        return;
+    }
+
+    std::string text(buffer.data.data<char>(), buffer.data.size());
+    ControlCommand command;
+    std::string error;
+    bool ok = parseCommand(text, command, error) && handler_(command, error);
+
+    LOG_INFO("🎮 Control: " << text << (ok ? " ✅" : " ❌ " + error));
+    reply(command.cmd, ok, error);
+}
+
+void ControlChannel::reply(const std::string& cmd, bool ok, const std::string& error) {
+    std::ostringstream message;
+    message << "{\"type\":\"ack\",\"cmd\":\"" << escapeJsonString(cmd) << "\",\"ok\":"
+            << (ok ? "true" : "false");
+    if (!ok) {
+        message << ",\"error\":\"" << escapeJsonString(error) << "\"";
+    }
+    message << "}";
+    channel_->Send(webrtc::DataBuffer(message.str()));
+}
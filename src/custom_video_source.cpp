@@ -1,64 +1,462 @@
 #include "custom_video_source.h"
+#include "frame_overlay.h"
+#include "latency_tracer.h"
+#include "logger.h"
 #include <api/video/i420_buffer.h>
 #include <libyuv/convert.h>
-#include <rtc_base/logging.h>
+#include <libyuv/planar_functions.h>
+#include <libyuv/scale.h>
+#include <rtc_base/time_utils.h>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// 从源 I420 平面的 roi 区域缩放到 dst（尺寸相同时即拷贝）
+void scaleI420Region(const uint8_t* src_y, int stride_y,
+                     const uint8_t* src_u, int stride_u,
+                     const uint8_t* src_v, int stride_v,
+                     const cv::Rect& roi, webrtc::I420Buffer* dst) {
+    libyuv::I420Scale(src_y + roi.y * stride_y + roi.x, stride_y,
+                      src_u + (roi.y / 2) * stride_u + roi.x / 2, stride_u,
+                      src_v + (roi.y / 2) * stride_v + roi.x / 2, stride_v,
+                      roi.width, roi.height,
+                      dst->MutableDataY(), dst->StrideY(),
+                      dst->MutableDataU(), dst->StrideU(),
+                      dst->MutableDataV(), dst->StrideV(),
+                      dst->width(), dst->height(),
+                      libyuv::kFilterBox);
+}
+
+// 单源平面 → I420：打包 RGB/YUV 与灰度共用同一签名
+using ConvertToI420Fn = int (*)(const uint8_t* src, int src_stride,
+                                uint8_t* dst_y, int dst_stride_y,
+                                uint8_t* dst_u, int dst_stride_u,
+                                uint8_t* dst_v, int dst_stride_v,
+                                int width, int height);
+
+struct SinglePlaneConversion {
+    PixelFormat format;
+    int mat_type;
+    int bytes_per_pixel;
+    bool even_width;        // 两个像素共用一组色度（YUYV / UYVY）
+    ConvertToI420Fn convert;
+};
+
+// libyuv 的命名按小端字（ARGB = 内存中 B G R A），与 OpenCV 的通道顺序对照如下
+const SinglePlaneConversion kSinglePlaneConversions[] = {
+    {PixelFormat::kBGR,   CV_8UC3, 3, false, libyuv::RGB24ToI420},   // B G R
+    {PixelFormat::kRGB,   CV_8UC3, 3, false, libyuv::RAWToI420},     // R G B
+    {PixelFormat::kBGRA,  CV_8UC4, 4, false, libyuv::ARGBToI420},    // B G R A
+    {PixelFormat::kGRAY8, CV_8UC1, 1, false, libyuv::I400ToI420},
+    {PixelFormat::kYUYV,  CV_8UC2, 2, true,  libyuv::YUY2ToI420},
+    {PixelFormat::kUYVY,  CV_8UC2, 2, true,  libyuv::UYVYToI420},
+};
+
+}  // namespace
 
 CustomVideoSource::CustomVideoSource() 
-    : AdaptedVideoTrackSource(), timestamp_us_(0) {
+    : AdaptedVideoTrackSource(), buffer_pool_(false, kMaxPooledBuffers),
+      crop_pool_(false, kMaxPooledBuffers), crop_target_(0, 0, 1, 1), crop_transition_ms_(0),
+      crop_snap_(false), crop_current_(0, 0, 1, 1), crop_last_us_(0), last_frame_id_(0),
+      timestamp_overlay_(false), timestamp_us_(0), frame_counter_(0), skipped_frames_(0) {
 }
 
-void CustomVideoSource::PushFrame(const cv::Mat& frame) {
-    if (frame.empty()) {
-        return;
+void CustomVideoSource::enableStaticSceneDetection(const StaticSceneConfig& config,
+                                                   const std::string& name,
+                                                   const cv::Rect& ignore_region) {
+    scene_detector_.setConfig(config);
+    scene_detector_.setIgnoreRegion(ignore_region);
+    name_ = name;
+}
+
+void CustomVideoSource::setCropConfig(const CropConfig& config) {
+    std::lock_guard<std::mutex> lock(crop_mutex_);
+    crop_target_ = cv::Rect2d(config.x, config.y, config.width, config.height) & cv::Rect2d(0, 0, 1, 1);
+    crop_output_ = cv::Size(config.output_width & ~1, config.output_height & ~1);
+    crop_transition_ms_ = config.transition_ms;
+    crop_snap_ = true;
+}
+
+void CustomVideoSource::setCropWindow(double x, double y, double width, double height) {
+    std::lock_guard<std::mutex> lock(crop_mutex_);
+    crop_target_ = cv::Rect2d(x, y, width, height) & cv::Rect2d(0, 0, 1, 1);
+}
+
+cv::Size CustomVideoSource::cropOutputSize(int width, int height) {
+    std::lock_guard<std::mutex> lock(crop_mutex_);
+    if (crop_output_.width >= 2 && crop_output_.height >= 2) {
+        return crop_output_;
+    }
+    return cv::Size(width, height);
+}
+
+cv::Rect CustomVideoSource::updateCropRect(int width, int height, const cv::Size& output,
+                                           int64_t now_us) {
+    cv::Rect2d target;
+    int transition_ms;
+    bool snap;
+    {
+        std::lock_guard<std::mutex> lock(crop_mutex_);
+        target = crop_target_;
+        transition_ms = crop_transition_ms_;
+        snap = crop_snap_;
+        crop_snap_ = false;
     }
     
-    static int frame_counter = 0;
-    frame_counter++;
+    // 窗口按指数曲线逼近目标，约 transition_ms 后完成 95%；输出尺寸不变，编码器无需重新初始化
+    if (snap || crop_last_us_ == 0 || transition_ms <= 0) {
+        crop_current_ = target;
+    } else {
+        double elapsed_us = static_cast<double>(std::max<int64_t>(0, now_us - crop_last_us_));
+        double alpha = 1.0 - std::exp(-elapsed_us * 3.0 / (transition_ms * 1000.0));
+        crop_current_.x += (target.x - crop_current_.x) * alpha;
+        crop_current_.y += (target.y - crop_current_.y) * alpha;
+        crop_current_.width += (target.width - crop_current_.width) * alpha;
+        crop_current_.height += (target.height - crop_current_.height) * alpha;
+        double remaining = std::max({std::abs(target.x - crop_current_.x), std::abs(target.y - crop_current_.y),
+                                     std::abs(target.width - crop_current_.width),
+                                     std::abs(target.height - crop_current_.height)});
+        if (remaining < 1e-3) {
+            crop_current_ = target;
+        }
+    }
+    crop_last_us_ = now_us;
     
-    int width = frame.cols;
-    int height = frame.rows;
+    // 未裁剪且不缩放：整帧原样转换（奇数宽高不必对齐）
+    if (crop_current_ == cv::Rect2d(0, 0, 1, 1) && output == cv::Size(width, height)) {
+        return cv::Rect(0, 0, width, height);
+    }
     
-    // Create I420 buffer
-    rtc::scoped_refptr<webrtc::I420Buffer> buffer = 
-        webrtc::I420Buffer::Create(width, height);
+    // 窗口扩展到输出宽高比（超出画面时收缩），避免拉伸变形
+    const double aspect = static_cast<double>(output.width) / output.height;
+    double roi_width = crop_current_.width * width;
+    double roi_height = crop_current_.height * height;
+    if (roi_width / roi_height < aspect) {
+        roi_width = roi_height * aspect;
+    } else {
+        roi_height = roi_width / aspect;
+    }
+    if (roi_width > width) {
+        roi_width = width;
+        roi_height = roi_width / aspect;
+    }
+    if (roi_height > height) {
+        roi_height = height;
+        roi_width = roi_height * aspect;
+    }
+    
+    // I420 色度 2x2 采样，区域对齐到偶数
+    int rect_width = std::max(2, static_cast<int>(std::lround(roi_width)) & ~1);
+    int rect_height = std::max(2, static_cast<int>(std::lround(roi_height)) & ~1);
+    double center_x = (crop_current_.x + crop_current_.width / 2) * width;
+    double center_y = (crop_current_.y + crop_current_.height / 2) * height;
+    int rect_x = std::max(0, std::min(static_cast<int>(center_x - rect_width / 2.0), width - rect_width)) & ~1;
+    int rect_y = std::max(0, std::min(static_cast<int>(center_y - rect_height / 2.0), height - rect_height)) & ~1;
+    return cv::Rect(rect_x, rect_y, rect_width, rect_height);
+}
+
+rtc::scoped_refptr<webrtc::I420Buffer> CustomVideoSource::cropAndScale(
+    const cv::Mat& frame, PixelFormat format, const webrtc::I420Buffer* decoded,
+    const cv::Rect& roi, const cv::Size& output) {
+    rtc::scoped_refptr<webrtc::I420Buffer> buffer =
+        crop_pool_.CreateI420Buffer(output.width, output.height);
+    if (!buffer) {
+        LOG_EVERY_MS(LogLevel::kWarn, 5000, "⚠️  Crop buffer pool exhausted, dropping frame");
+        return nullptr;
+    }
+    
+    I420Planes planes;
+    if (decoded) {
+        // MJPEG 已解码为 I420：区域直接缩放到输出
+        scaleI420Region(decoded->DataY(), decoded->StrideY(), decoded->DataU(), decoded->StrideU(),
+                        decoded->DataV(), decoded->StrideV(), roi, buffer.get());
+    } else if (format == PixelFormat::kI420 && i420Planes(frame, &planes)) {
+        // I420 源：一次 libyuv 缩放，不经过任何中间缓冲区
+        scaleI420Region(planes.y, planes.stride_y, planes.u, planes.stride_uv, planes.v, planes.stride_uv,
+                        roi, buffer.get());
+    } else if (roi.size() == output) {
+        // 区域与输出同尺寸：只转换区域内的像素，直接写入输出
+        if (!convertRegionToI420(frame, format, roi,
+                                 buffer->MutableDataY(), buffer->StrideY(),
+                                 buffer->MutableDataU(), buffer->StrideU(),
+                                 buffer->MutableDataV(), buffer->StrideV())) {
+            return nullptr;
+        }
+    } else {
+        // 打包/RGB 格式不能边转换边缩放：只把区域转换到区域大小的暂存区（不是整帧），再缩放
+        const int chroma_width = roi.width / 2;
+        const int chroma_size = chroma_width * (roi.height / 2);
+        roi_scratch_.resize(static_cast<size_t>(roi.area()) + 2 * chroma_size);
+        uint8_t* y = roi_scratch_.data();
+        uint8_t* u = y + roi.area();
+        uint8_t* v = u + chroma_size;
+        if (!convertRegionToI420(frame, format, roi, y, roi.width, u, chroma_width, v, chroma_width)) {
+            return nullptr;
+        }
+        scaleI420Region(y, roi.width, u, chroma_width, v, chroma_width,
+                        cv::Rect(0, 0, roi.width, roi.height), buffer.get());
+    }
+    return buffer;
+}
+
+bool CustomVideoSource::checkScene(const uint8_t* y, int stride, int width, int height,
+                                   int64_t now_us) {
+    bool was_static = scene_detector_.isStatic();
+    bool deliver = scene_detector_.shouldDeliver(y, stride, width, height, now_us);
     
-    // Convert BGR to I420
+    if (!was_static && scene_detector_.isStatic()) {
+        LOG_INFO("💤 [" << name_ << "] Static scene, sending keepalive frames only");
+    } else if (was_static && !scene_detector_.isStatic()) {
+        LOG_INFO("🏃 [" << name_ << "] Motion detected, back to full frame rate ("
+                 << skipped_frames_ << " static frames skipped)");
+        skipped_frames_ = 0;
+    }
+    if (!deliver) {
+        skipped_frames_++;
+    }
+    return deliver;
+}
+
+void CustomVideoSource::setMjpegTargetResolution(int width, int height) {
+    mjpeg_decoder_.setTargetResolution(width, height);
+}
+
+void CustomVideoSource::PushFrame(const cv::Mat& frame, uint64_t frame_id) {
     if (frame.type() == CV_8UC3) {
-        // BGR to I420 conversion using libyuv
-        const int stride_bgr = frame.step;
-        const uint8_t* src_bgr = frame.data;
-        
-        libyuv::RGB24ToI420(
-            src_bgr, stride_bgr,
-            buffer->MutableDataY(), buffer->StrideY(),
-            buffer->MutableDataU(), buffer->StrideU(),
-            buffer->MutableDataV(), buffer->StrideV(),
-            width, height
-        );
+        PushFrame(frame, PixelFormat::kBGR, frame_id);
+    } else if (frame.type() == CV_8UC4) {
+        PushFrame(frame, PixelFormat::kBGRA, frame_id);
     } else if (frame.type() == CV_8UC1) {
-        // Grayscale - just copy to Y plane and set U,V to 128
-        memcpy(buffer->MutableDataY(), frame.data, width * height);
-        memset(buffer->MutableDataU(), 128, width * height / 4);
-        memset(buffer->MutableDataV(), 128, width * height / 4);
+        PushFrame(frame, PixelFormat::kGRAY8, frame_id);
+    } else if (frame.type() == CV_16UC1) {
+        PushFrame(frame, PixelFormat::kGRAY16, frame_id);
     } else {
-        RTC_LOG(LS_ERROR) << "Unsupported frame format";
-        return;
+        LOG_EVERY_MS(LogLevel::kError, 5000, "❌ Unsupported frame type: " << frame.type());
+    }
+}
+
+bool CustomVideoSource::convertToI420(const cv::Mat& frame, PixelFormat format,
+                                      webrtc::I420Buffer* buffer) {
+    return convertRegionToI420(frame, format, cv::Rect(0, 0, buffer->width(), buffer->height()),
+                               buffer->MutableDataY(), buffer->StrideY(),
+                               buffer->MutableDataU(), buffer->StrideU(),
+                               buffer->MutableDataV(), buffer->StrideV());
+}
+
+bool CustomVideoSource::i420Planes(const cv::Mat& frame, I420Planes* planes) {
+    if (frame.type() != CV_8UC1 || frame.rows % 3 != 0 || frame.step % 2 != 0) {
+        return false;
+    }
+    const int width = frame.cols;
+    const int height = frame.rows * 2 / 3;
+    if (width % 2 != 0 || height % 2 != 0) {
+        return false;
+    }
+    // U、V 平面紧随 Y 平面；每个色度行占半个 Mat 行，连续存储时即 width / 2
+    planes->y = frame.data;
+    planes->stride_y = static_cast<int>(frame.step);
+    planes->stride_uv = static_cast<int>(frame.step / 2);
+    planes->u = frame.ptr(height);
+    planes->v = planes->u + static_cast<size_t>(height / 2) * planes->stride_uv;
+    planes->width = width;
+    planes->height = height;
+    return true;
+}
+
+bool CustomVideoSource::convertRegionToI420(const cv::Mat& frame, PixelFormat format,
+                                            const cv::Rect& region,
+                                            uint8_t* dst_y, int dst_stride_y,
+                                            uint8_t* dst_u, int dst_stride_u,
+                                            uint8_t* dst_v, int dst_stride_v) {
+    const int width = region.width;
+    const int height = region.height;
+    // 奇数宽高时色度向上取整，与 I420Buffer 一致
+    const int chroma_width = (width + 1) / 2;
+    const int chroma_height = (height + 1) / 2;
+    if (width <= 0 || height <= 0 || region.x < 0 || region.y < 0 ||
+        region.x % 2 != 0 || region.y % 2 != 0 || frame.empty() ||
+        region.x + width > frame.cols || region.y + height > pixelFormatHeight(format, frame.rows)) {
+        return false;
     }
     
-    // Create VideoFrame
-    timestamp_us_ += 33333;  // ~30fps (33.333ms per frame)
+    for (const SinglePlaneConversion& conversion : kSinglePlaneConversions) {
+        if (conversion.format != format) {
+            continue;
+        }
+        if (frame.type() != conversion.mat_type || (conversion.even_width && width % 2 != 0)) {
+            return false;
+        }
+        return conversion.convert(frame.ptr(region.y) + region.x * conversion.bytes_per_pixel,
+                                  static_cast<int>(frame.step),
+                                  dst_y, dst_stride_y,
+                                  dst_u, dst_stride_u,
+                                  dst_v, dst_stride_v,
+                                  width, height) == 0;
+    }
+    
+    switch (format) {
+        case PixelFormat::kGRAY16: {
+            if (frame.type() != CV_16UC1) {
+                return false;
+            }
+            // scale 256：取高 8 位；步长以 uint16_t 为单位
+            libyuv::Convert16To8Plane(frame.ptr<uint16_t>(region.y) + region.x,
+                                      static_cast<int>(frame.step1()),
+                                      dst_y, dst_stride_y, 256, width, height);
+            libyuv::SetPlane(dst_u, dst_stride_u, chroma_width, chroma_height, 128);
+            libyuv::SetPlane(dst_v, dst_stride_v, chroma_width, chroma_height, 128);
+            return true;
+        }
+        case PixelFormat::kNV12: {
+            if (frame.type() != CV_8UC1 || frame.rows % 3 != 0 || frame.cols % 2 != 0 ||
+                (frame.rows * 2 / 3) % 2 != 0) {
+                return false;
+            }
+            // UV 平面紧随 Y 平面（frame.rows = 高度 * 3 / 2），每行 UV 交错、行宽与 Y 相同
+            const int full_height = frame.rows * 2 / 3;
+            const int step = static_cast<int>(frame.step);
+            return libyuv::NV12ToI420(
+                frame.ptr(region.y) + region.x, step,
+                frame.ptr(full_height + region.y / 2) + region.x, step,
+                dst_y, dst_stride_y,
+                dst_u, dst_stride_u,
+                dst_v, dst_stride_v,
+                width, height) == 0;
+        }
+        case PixelFormat::kI420: {
+            I420Planes planes;
+            if (!i420Planes(frame, &planes)) {
+                return false;
+            }
+            const size_t chroma_offset = static_cast<size_t>(region.y / 2) * planes.stride_uv + region.x / 2;
+            return libyuv::I420Copy(
+                planes.y + static_cast<size_t>(region.y) * planes.stride_y + region.x, planes.stride_y,
+                planes.u + chroma_offset, planes.stride_uv,
+                planes.v + chroma_offset, planes.stride_uv,
+                dst_y, dst_stride_y,
+                dst_u, dst_stride_u,
+                dst_v, dst_stride_v,
+                width, height) == 0;
+        }
+        default:
+            return false;
+    }
+}
+
+void CustomVideoSource::repeatLastFrame() {
+    std::lock_guard<std::mutex> lock(deliver_mutex_);
+    if (!last_buffer_) {
+        return;
+    }
+    // 不经过静止检测：画面静止时也要立即给出一帧
+    deliverFrameLocked(last_buffer_, last_frame_id_, rtc::TimeMicros());
+}
+
+void CustomVideoSource::deliverFrame(const rtc::scoped_refptr<webrtc::VideoFrameBuffer>& buffer,
+                                     uint64_t frame_id, int64_t capture_us) {
+    std::lock_guard<std::mutex> lock(deliver_mutex_);
+    last_buffer_ = buffer;
+    last_frame_id_ = frame_id;
+    deliverFrameLocked(buffer, frame_id, capture_us);
+}
+
+void CustomVideoSource::deliverFrameLocked(const rtc::scoped_refptr<webrtc::VideoFrameBuffer>& buffer,
+                                           uint64_t frame_id, int64_t capture_us) {
+    timestamp_us_ = std::max(capture_us, timestamp_us_ + 1);
     
     webrtc::VideoFrame video_frame = 
         webrtc::VideoFrame::Builder()
             .set_video_frame_buffer(buffer)
             .set_timestamp_us(timestamp_us_)
+            .set_id(static_cast<uint16_t>(frame_id))
             .build();
-    
-    // Push to WebRTC
     OnFrame(video_frame);
+}
+
+void CustomVideoSource::PushFrame(const cv::Mat& frame, PixelFormat format, uint64_t frame_id,
+                                  int64_t capture_time_us) {
+    if (frame.empty()) {
+        return;
+    }
+    
+    frame_counter_++;
+    
+    int width = frame.cols;
+    int height = pixelFormatHeight(format, frame.rows);
+    
+    // 使用真实采集时间（与 WebRTC 内部时钟同源），保证接收端渲染时间与实际帧率一致
+    // 源提供的内核时间戳同为 CLOCK_MONOTONIC，可以直接使用
+    int64_t capture_us = capture_time_us > 0 ? capture_time_us : rtc::TimeMicros();
+    
+    // 平面 YUV / 灰度帧的 Y 平面就在帧首，静止时连格式转换一起省掉
+    const bool has_y_plane = format == PixelFormat::kI420 || format == PixelFormat::kNV12 ||
+                             format == PixelFormat::kGRAY8;
+    if (scene_detector_.isEnabled() && has_y_plane &&
+        !checkScene(frame.data, static_cast<int>(frame.step), width, height, capture_us)) {
+        return;
+    }
     
-    // Log every 30 frames
-    if (frame_counter % 30 == 0) {
-        std::cout << "📺 Pushed " << frame_counter << " frames to WebRTC" << std::endl;
+    rtc::scoped_refptr<webrtc::I420Buffer> buffer;
+    {
+        ScopedTrace trace(TraceStage::kConvert, frame_id);
+    
+        // MJPEG 直接解码到池化的 I420 缓冲区，尺寸由 JPEG 头（及 DCT 缩放）决定
+        rtc::scoped_refptr<webrtc::I420Buffer> decoded;
+        if (format == PixelFormat::kMJPEG) {
+            decoded = mjpeg_decoder_.decode(frame.data, frame.total() * frame.elemSize(), buffer_pool_);
+            if (!decoded) {
+                return;
+            }
+            width = decoded->width();
+            height = decoded->height();
+        }
+        
+        const cv::Size output = cropOutputSize(width, height);
+        const cv::Rect roi = updateCropRect(width, height, output, capture_us);
+        if (roi != cv::Rect(0, 0, width, height) || output != cv::Size(width, height)) {
+            // 数字变焦：裁剪区域在源数据上直接缩放到输出尺寸
+            buffer = cropAndScale(frame, format, decoded.get(), roi, output);
+            if (!buffer) {
+                return;
+            }
+        } else if (decoded) {
+            buffer = decoded;
+        } else {
+            // 从缓冲池取 I420 缓冲区，避免每帧分配
+            buffer = buffer_pool_.CreateI420Buffer(width, height);
+            if (!buffer) {
+                LOG_EVERY_MS(LogLevel::kWarn, 5000, "⚠️  I420 buffer pool exhausted, dropping frame");
+                return;
+            }
+            if (!convertToI420(frame, format, buffer.get())) {
+                LOG_EVERY_MS(LogLevel::kError, 5000, "❌ Cannot convert " << pixelFormatName(format)
+                             << " frame (" << width << "x" << height << ", Mat type " << frame.type()
+                             << ", step " << static_cast<size_t>(frame.step) << ") to I420");
+                return;
+            }
+        }
+    }
+    
+    // 其他格式（RGB / 打包 YUV / GRAY16 / MJPEG）在转换后检测，静止时省去编码和发送
+    if (scene_detector_.isEnabled() && !has_y_plane &&
+        !checkScene(buffer->DataY(), buffer->StrideY(), buffer->width(), buffer->height(), capture_us)) {
+        return;
     }
+    
+    // 静止检测之后再叠加，时间戳不会让画面看起来在变化；画在输出缓冲区的 Y 平面上，MJPEG 也能叠加
+    if (timestamp_overlay_) {
+        ScopedTrace trace(TraceStage::kOverlay, frame_id);
+        cv::Mat y_plane(buffer->height(), buffer->width(), CV_8UC1, buffer->MutableDataY(),
+                        static_cast<size_t>(buffer->StrideY()));
+        drawTimestampOverlay(y_plane);
+    }
+    
+    // Push to WebRTC
+    {
+        ScopedTrace trace(TraceStage::kDeliver, frame_id);
+        deliverFrame(buffer, frame_id, capture_us);
+    }
+    
+    LOG_EVERY_MS(LogLevel::kDebug, 5000, "📺 Pushed " << frame_counter_ << " frames to WebRTC");
 }
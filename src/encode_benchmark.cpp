@@ -0,0 +1,278 @@
+#include "encode_benchmark.h"
+#include "custom_video_source.h"
+#include "latency_tracer.h"
+#include "simple_video_codec_factory.h"
+
+#include <api/video/video_bitrate_allocation.h>
+#include <api/video/video_frame.h>
+#include <api/video/video_sink_interface.h>
+#include <api/video_codecs/video_codec.h>
+#include <rtc_base/ref_counted_object.h>
+
+#include <chrono>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+namespace {
+
+int64_t processCpuUs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+// 每个阶段的墙钟时间与进程 CPU 时间（包含编码器内部工作线程）
+struct StageStats {
+    const char* name;
+    int64_t wall_us = 0;
+    int64_t cpu_us = 0;
+
+    explicit StageStats(const char* n) : name(n) {}
+};
+
+class StageTimer {
+public:
+    explicit StageTimer(StageStats& stats)
+        : stats_(stats), wall_start_(LatencyTracer::nowUs()), cpu_start_(processCpuUs()) {}
+
+    int64_t stop() {
+        int64_t wall = LatencyTracer::nowUs() - wall_start_;
+        stats_.wall_us += wall;
+        stats_.cpu_us += processCpuUs() - cpu_start_;
+        return wall;
+    }
+
+private:
+    StageStats& stats_;
+    int64_t wall_start_;
+    int64_t cpu_start_;
+};
+
+// 接住 CustomVideoSource 输出的 I420 帧
+class CaptureSink : public rtc::VideoSinkInterface<webrtc::VideoFrame> {
+public:
+    void OnFrame(const webrtc::VideoFrame& frame) override {
+        frame_ = frame;
+        has_frame_ = true;
+    }
+
+    bool take(webrtc::VideoFrame* frame) {
+        if (!has_frame_) {
+            return false;
+        }
+        *frame = frame_;
+        has_frame_ = false;
+        return true;
+    }
+
+private:
+    webrtc::VideoFrame frame_ = webrtc::VideoFrame::Builder()
+        .set_video_frame_buffer(webrtc::I420Buffer::Create(2, 2))
+        .build();
+    bool has_frame_ = false;
+};
+
+class EncodedSizeCounter : public webrtc::EncodedImageCallback {
+public:
+    Result OnEncodedImage(const webrtc::EncodedImage& encoded_image,
+                          const webrtc::CodecSpecificInfo*) override {
+        total_bytes += encoded_image.size();
+        encoded_frames++;
+        if (encoded_image._frameType == webrtc::VideoFrameType::kVideoFrameKey) {
+            key_frames++;
+        }
+        return Result(Result::OK);
+    }
+
+    void OnDroppedFrame(DropReason) override {
+        dropped_frames++;
+    }
+
+    uint64_t total_bytes = 0;
+    int encoded_frames = 0;
+    int key_frames = 0;
+    int dropped_frames = 0;
+};
+
+}  // namespace
+
+EncodeBenchmark::EncodeBenchmark(std::shared_ptr<VideoSource> video_source,
+                                 const EncodeBenchmarkOptions& options)
+    : video_source_(video_source), options_(options) {
+}
+
+bool EncodeBenchmark::run(const std::atomic<bool>& keep_running) {
+    const int fps = video_source_->getFrameRate() > 0 ? video_source_->getFrameRate() : 30;
+
+    // 通过与实时会话相同的编码器工厂创建编码器
+    webrtc::SimpleVideoEncoderFactory factory(options_.tuning);
+    webrtc::SdpVideoFormat format(options_.codec);
+    for (const auto& supported : factory.GetSupportedFormats()) {
+        if (supported.name == options_.codec) {
+            format = supported;
+            break;
+        }
+    }
+    std::unique_ptr<webrtc::VideoEncoder> encoder = factory.CreateVideoEncoder(format);
+    if (!encoder) {
+        std::cerr << "Unsupported codec for benchmark: " << options_.codec << std::endl;
+        return false;
+    }
+
+    // 第一帧决定实际分辨率（可能与请求值不同）
+    FrameLease lease;
+    if (!video_source_->acquireFrame(lease) || !lease.valid()) {
+        std::cerr << "Failed to read first frame from " << video_source_->getName() << std::endl;
+        return false;
+    }
+    const PixelFormat pixel_format = lease.format();
+    int width = lease.width();
+    int height = lease.height();
+    if (isCompressedFormat(pixel_format)) {
+        width = video_source_->getWidth();
+        height = video_source_->getHeight();
+    }
+
+    webrtc::VideoCodec codec;
+    codec.codecType = webrtc::PayloadStringToCodecType(format.name);
+    codec.width = width;
+    codec.height = height;
+    codec.startBitrate = options_.bitrate_kbps;
+    codec.maxBitrate = options_.bitrate_kbps;
+    codec.minBitrate = 30;
+    codec.maxFramerate = fps;
+    codec.qpMax = 56;
+    codec.mode = webrtc::VideoCodecMode::kRealtimeVideo;
+    if (codec.codecType == webrtc::kVideoCodecVP8) {
+        *codec.VP8() = webrtc::VideoEncoder::GetDefaultVp8Settings();
+    } else if (codec.codecType == webrtc::kVideoCodecH264) {
+        *codec.H264() = webrtc::VideoEncoder::GetDefaultH264Settings();
+    }
+
+    const int cores = static_cast<int>(std::thread::hardware_concurrency());
+    webrtc::VideoEncoder::Settings settings(
+        webrtc::VideoEncoder::Capabilities(false), cores > 0 ? cores : 1, 1200);
+
+    EncodedSizeCounter counter;
+    encoder->RegisterEncodeCompleteCallback(&counter);
+    if (encoder->InitEncode(&codec, settings) != WEBRTC_VIDEO_CODEC_OK) {
+        std::cerr << "Failed to initialize " << format.name << " encoder" << std::endl;
+        return false;
+    }
+
+    webrtc::VideoBitrateAllocation allocation;
+    allocation.SetBitrate(0, 0, options_.bitrate_kbps * 1000);
+    encoder->SetRates(webrtc::VideoEncoder::RateControlParameters(allocation, fps));
+
+    rtc::scoped_refptr<CustomVideoSource> custom_source(new rtc::RefCountedObject<CustomVideoSource>());
+    CaptureSink sink;
+    custom_source->AddOrUpdateSink(&sink, rtc::VideoSinkWants());
+    custom_source->setTimestampOverlay(true);
+
+    std::cout << "\n=== Encode Benchmark ===" << std::endl;
+    std::cout << "Source:  " << video_source_->getName() << " (" << width << "x" << height
+              << ", " << pixelFormatName(pixel_format) << ")" << std::endl;
+    std::cout << "Encoder: " << format.name << " @ " << options_.bitrate_kbps << " kbps, "
+              << fps << " fps nominal, " << settings.number_of_cores << " cores" << std::endl;
+    std::cout << "Limit:   " << options_.duration_s << " s";
+    if (options_.max_frames > 0) {
+        std::cout << " or " << options_.max_frames << " frames";
+    }
+    std::cout << "\n" << std::endl;
+
+    StageStats capture("capture");
+    StageStats convert("convert+overlay");
+    StageStats encode("encode");
+    LatencyHistogram encode_latency;
+
+    const int64_t start_us = LatencyTracer::nowUs();
+    const int64_t start_cpu_us = processCpuUs();
+    const int64_t deadline_us = start_us + static_cast<int64_t>(options_.duration_s) * 1000000;
+    int frames = 0;
+    bool have_frame = true;   // 第一帧已经读出
+
+    while (keep_running && LatencyTracer::nowUs() < deadline_us &&
+           (options_.max_frames <= 0 || frames < options_.max_frames)) {
+        if (!have_frame) {
+            StageTimer timer(capture);
+            bool ok = video_source_->acquireFrame(lease) && lease.valid();
+            timer.stop();
+            if (!ok) {
+                break;   // 文件结束或相机出错
+            }
+        }
+        have_frame = false;
+        frames++;
+
+        webrtc::VideoFrame video_frame = webrtc::VideoFrame::Builder()
+            .set_video_frame_buffer(webrtc::I420Buffer::Create(2, 2))
+            .build();
+        {
+            StageTimer timer(convert);
+            custom_source->PushFrame(lease.image(), pixel_format, frames, lease.captureTimeUs());
+            timer.stop();
+        }
+        lease.reset();
+        if (!sink.take(&video_frame)) {
+            continue;
+        }
+
+        // RTP 时间戳按名义帧率递增，码率统计以媒体时长为准
+        video_frame.set_timestamp(static_cast<uint32_t>(static_cast<int64_t>(frames) * 90000 / fps));
+        std::vector<webrtc::VideoFrameType> frame_types = {
+            frames == 1 ? webrtc::VideoFrameType::kVideoFrameKey : webrtc::VideoFrameType::kVideoFrameDelta
+        };
+        {
+            StageTimer timer(encode);
+            encoder->Encode(video_frame, &frame_types);
+            encode_latency.record(timer.stop());
+        }
+
+        if (frames % (fps * 2) == 0) {
+            std::cout << "  ... " << frames << " frames" << std::endl;
+        }
+    }
+
+    const double elapsed_s = (LatencyTracer::nowUs() - start_us) / 1e6;
+    const double total_cpu_s = (processCpuUs() - start_cpu_us) / 1e6;
+
+    custom_source->RemoveSink(&sink);
+    encoder->Release();
+
+    if (frames == 0 || counter.encoded_frames == 0) {
+        std::cerr << "No frames were encoded" << std::endl;
+        return false;
+    }
+
+    const double media_s = static_cast<double>(frames) / fps;
+    const double bitrate_kbps = counter.total_bytes * 8.0 / media_s / 1000.0;
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "\n========================================" << std::endl;
+    std::cout << "Benchmark results" << std::endl;
+    std::cout << "========================================" << std::endl;
+    std::cout << "  Frames:          " << frames << " in " << elapsed_s << " s" << std::endl;
+    std::cout << "  Sustained fps:   " << frames / elapsed_s << std::endl;
+    std::cout << "  CPU usage:       " << 100.0 * total_cpu_s / elapsed_s << "% of one core" << std::endl;
+    std::cout << "  Encoded frames:  " << counter.encoded_frames
+              << " (key " << counter.key_frames << ", dropped " << counter.dropped_frames << ")" << std::endl;
+    std::cout << "  Output bitrate:  " << bitrate_kbps << " kbps (at " << fps << " fps media time)" << std::endl;
+    std::cout << "  Avg frame size:  " << counter.total_bytes / 1024.0 / counter.encoded_frames << " KB" << std::endl;
+
+    std::cout << "\n  Per-frame cost (ms)      wall       cpu" << std::endl;
+    for (const StageStats* stage : {&capture, &convert, &encode}) {
+        std::cout << "    " << std::left << std::setw(18) << stage->name << std::right
+                  << std::setw(10) << stage->wall_us / 1000.0 / frames
+                  << std::setw(10) << stage->cpu_us / 1000.0 / frames << std::endl;
+    }
+
+    std::cout << "\n  Encode time (ms)  p50 " << encode_latency.percentile(50) / 1000.0
+              << "  p90 " << encode_latency.percentile(90) / 1000.0
+              << "  p99 " << encode_latency.percentile(99) / 1000.0
+              << "  max " << encode_latency.max() / 1000.0 << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    return true;
+}
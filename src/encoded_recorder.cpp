@@ -0,0 +1,315 @@
+#include "encoded_recorder.h"
+#include "logger.h"
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavutil/mem.h>
+}
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+
+namespace {
+
+constexpr int kRtpClockRate = 90000;
+
+// 从 Annex B 关键帧中提取 SPS/PPS，作为 H.264 extradata（muxer 会转换为 avcC）
+std::vector<uint8_t> extractH264ParameterSets(const std::vector<uint8_t>& data) {
+    std::vector<uint8_t> extradata;
+    const size_t size = data.size();
+    size_t i = 0;
+    while (i + 3 <= size) {
+        // 查找起始码 00 00 01 / 00 00 00 01
+        if (!(data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1)) {
+            i++;
+            continue;
+        }
+        size_t nal_start = i + 3;
+        size_t next = nal_start;
+        while (next + 3 <= size && !(data[next] == 0 && data[next + 1] == 0 && data[next + 2] == 1)) {
+            next++;
+        }
+        size_t nal_end = next + 3 <= size ? next : size;
+        // 去掉下一个 4 字节起始码的前导 0
+        while (nal_end > nal_start && data[nal_end - 1] == 0) {
+            nal_end--;
+        }
+        if (nal_start < nal_end) {
+            uint8_t nal_type = data[nal_start] & 0x1F;
+            if (nal_type == 7 || nal_type == 8) {   // SPS / PPS
+                static const uint8_t kStartCode[] = {0, 0, 0, 1};
+                extradata.insert(extradata.end(), kStartCode, kStartCode + 4);
+                extradata.insert(extradata.end(), data.begin() + nal_start, data.begin() + nal_end);
+            }
+        }
+        i = next;
+    }
+    return extradata;
+}
+
+std::string avErrorString(int error) {
+    char buffer[AV_ERROR_MAX_STRING_SIZE] = {0};
+    av_strerror(error, buffer, sizeof(buffer));
+    return buffer;
+}
+
+}  // namespace
+
+EncodedRecorder::EncodedRecorder(const RecordingConfig& config)
+    : config_(config),
+      max_queue_bytes_(static_cast<size_t>(std::max(config.max_queue_mb, 1)) * 1024 * 1024),
+      should_stop_(false), queued_bytes_(0), waiting_for_key_frame_(true), dropped_frames_(0),
+      format_context_(nullptr), stream_(nullptr), segment_start_ts_(0),
+      last_unwrapped_ts_(-1), last_rtp_timestamp_(0), segment_frames_(0) {
+}
+
+EncodedRecorder::~EncodedRecorder() {
+    stop();
+}
+
+bool EncodedRecorder::start() {
+    if (io_thread_.joinable()) {
+        return true;
+    }
+    if (config_.format != "mkv" && config_.format != "mp4") {
+        LOG_ERROR("Unsupported recording format: " << config_.format << " (mkv|mp4)");
+        return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(config_.directory, ec);
+    if (ec) {
+        LOG_ERROR("Failed to create recording directory " << config_.directory
+                  << ": " << ec.message());
+        return false;
+    }
+
+    should_stop_ = false;
+    waiting_for_key_frame_ = true;
+    io_thread_ = std::thread(&EncodedRecorder::ioThread, this);
+    LOG_INFO("⏺️  Recording encoded stream to " << config_.directory << "/ ("
+             << config_.format << ", " << config_.segment_seconds << " s segments)");
+    return true;
+}
+
+void EncodedRecorder::stop() {
+    if (!io_thread_.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        should_stop_ = true;
+    }
+    queue_cv_.notify_one();
+    io_thread_.join();
+
+    if (dropped_frames_ > 0) {
+        LOG_INFO("Recording stopped (" << dropped_frames_ << " frames dropped due to slow disk)");
+    } else {
+        LOG_INFO("Recording stopped");
+    }
+}
+
+bool EncodedRecorder::push(EncodedFramePacket&& packet) {
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        if (should_stop_) {
+            return false;
+        }
+        if (waiting_for_key_frame_) {
+            if (!packet.key_frame) {
+                dropped_frames_++;
+                return false;
+            }
+            waiting_for_key_frame_ = false;
+        }
+        if (queued_bytes_ + packet.data.size() > max_queue_bytes_) {
+            // 磁盘跟不上：丢弃当前帧，之后的增量帧也无法解码，一直丢到下一个关键帧
+            if (!waiting_for_key_frame_) {
+                LOG_WARN("⚠️  Recording queue full (" << queued_bytes_ / 1024
+                         << " KB), dropping until next key frame");
+            }
+            waiting_for_key_frame_ = true;
+            dropped_frames_++;
+            return false;
+        }
+        queued_bytes_ += packet.data.size();
+        queue_.push_back(std::move(packet));
+    }
+    queue_cv_.notify_one();
+    return true;
+}
+
+void EncodedRecorder::ioThread() {
+    while (true) {
+        EncodedFramePacket packet;
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex_);
+            queue_cv_.wait(lock, [this] { return should_stop_ || !queue_.empty(); });
+            if (queue_.empty()) {
+                break;   // 已停止且队列已清空
+            }
+            packet = std::move(queue_.front());
+            queue_.pop_front();
+            queued_bytes_ -= packet.data.size();
+        }
+        writePacket(packet);
+    }
+    closeSegment();
+}
+
+void EncodedRecorder::writePacket(const EncodedFramePacket& packet) {
+    // RTP 时间戳 32 位回绕，展开为 64 位
+    int64_t unwrapped;
+    if (last_unwrapped_ts_ < 0) {
+        unwrapped = packet.rtp_timestamp;
+    } else {
+        int32_t diff = static_cast<int32_t>(packet.rtp_timestamp - last_rtp_timestamp_);
+        unwrapped = last_unwrapped_ts_ + diff;
+    }
+
+    if (format_context_) {
+        const AVCodecParameters* par = stream_->codecpar;
+        bool format_changed = packet.width != par->width || packet.height != par->height ||
+                              (packet.codec == "H264") != (par->codec_id == AV_CODEC_ID_H264);
+        bool segment_due = unwrapped - segment_start_ts_ >=
+                           static_cast<int64_t>(config_.segment_seconds) * kRtpClockRate;
+        // 只在关键帧处切换文件，保证每个分段可以独立解码
+        if (packet.key_frame && (segment_due || format_changed)) {
+            closeSegment();
+        } else if (segment_frames_ > 0 && unwrapped <= last_unwrapped_ts_) {
+            return;   // 时间戳不递增，muxer 会拒绝
+        }
+    }
+
+    if (!format_context_) {
+        if (!packet.key_frame || !openSegment(packet)) {
+            return;
+        }
+        segment_start_ts_ = unwrapped;
+    }
+
+    last_rtp_timestamp_ = packet.rtp_timestamp;
+    last_unwrapped_ts_ = unwrapped;
+
+    // 不转移所有权：av_write_frame 对非引用计数的 packet 只读取数据，避免再复制一次
+    AVPacket* pkt = av_packet_alloc();
+    pkt->data = const_cast<uint8_t*>(packet.data.data());
+    pkt->size = static_cast<int>(packet.data.size());
+    pkt->pts = pkt->dts = unwrapped - segment_start_ts_;
+    pkt->stream_index = stream_->index;
+    if (packet.key_frame) {
+        pkt->flags |= AV_PKT_FLAG_KEY;
+    }
+    av_packet_rescale_ts(pkt, AVRational{1, kRtpClockRate}, stream_->time_base);
+
+    int ret = av_write_frame(format_context_, pkt);
+    av_packet_free(&pkt);
+    if (ret < 0) {
+        LOG_ERROR("❌ Failed to write " << segment_path_ << ": " << avErrorString(ret));
+        closeSegment();
+        return;
+    }
+    segment_frames_++;
+}
+
+bool EncodedRecorder::openSegment(const EncodedFramePacket& first_key_frame) {
+    AVCodecID codec_id = AV_CODEC_ID_NONE;
+    if (first_key_frame.codec == "H264") {
+        codec_id = AV_CODEC_ID_H264;
+    } else if (first_key_frame.codec == "VP8") {
+        codec_id = AV_CODEC_ID_VP8;
+    } else {
+        LOG_ERROR("Recording does not support codec " << first_key_frame.codec);
+        return false;
+    }
+
+    // VP8 只能可靠地封装进 Matroska
+    bool use_mp4 = config_.format == "mp4" && codec_id == AV_CODEC_ID_H264;
+    segment_path_ = nextSegmentPath() + (use_mp4 ? ".mp4" : ".mkv");
+
+    int ret = avformat_alloc_output_context2(&format_context_, nullptr,
+                                             use_mp4 ? "mp4" : "matroska", segment_path_.c_str());
+    if (ret < 0 || !format_context_) {
+        LOG_ERROR("❌ Failed to create muxer for " << segment_path_ << ": " << avErrorString(ret));
+        format_context_ = nullptr;
+        return false;
+    }
+
+    stream_ = avformat_new_stream(format_context_, nullptr);
+    stream_->time_base = AVRational{1, kRtpClockRate};
+    AVCodecParameters* par = stream_->codecpar;
+    par->codec_type = AVMEDIA_TYPE_VIDEO;
+    par->codec_id = codec_id;
+    par->width = first_key_frame.width;
+    par->height = first_key_frame.height;
+
+    if (codec_id == AV_CODEC_ID_H264) {
+        std::vector<uint8_t> extradata = extractH264ParameterSets(first_key_frame.data);
+        if (!extradata.empty()) {
+            par->extradata = static_cast<uint8_t*>(av_mallocz(extradata.size() + AV_INPUT_BUFFER_PADDING_SIZE));
+            memcpy(par->extradata, extradata.data(), extradata.size());
+            par->extradata_size = static_cast<int>(extradata.size());
+        }
+    }
+
+    ret = avio_open(&format_context_->pb, segment_path_.c_str(), AVIO_FLAG_WRITE);
+    if (ret < 0) {
+        LOG_ERROR("❌ Failed to open " << segment_path_ << ": " << avErrorString(ret));
+        avformat_free_context(format_context_);
+        format_context_ = nullptr;
+        stream_ = nullptr;
+        return false;
+    }
+
+    // 分片 MP4：无需结尾的 moov，进程异常退出时已写入的分片仍可播放
+    AVDictionary* options = nullptr;
+    if (use_mp4) {
+        av_dict_set(&options, "movflags", "frag_keyframe+empty_moov+default_base_moof", 0);
+    }
+    ret = avformat_write_header(format_context_, &options);
+    av_dict_free(&options);
+    if (ret < 0) {
+        LOG_ERROR("❌ Failed to write header for " << segment_path_ << ": " << avErrorString(ret));
+        avio_closep(&format_context_->pb);
+        avformat_free_context(format_context_);
+        format_context_ = nullptr;
+        stream_ = nullptr;
+        return false;
+    }
+
+    segment_frames_ = 0;
+    LOG_INFO("⏺️  Recording segment: " << segment_path_ << " (" << first_key_frame.codec << " "
+             << first_key_frame.width << "x" << first_key_frame.height << ")");
+    return true;
+}
+
+void EncodedRecorder::closeSegment() {
+    if (!format_context_) {
+        return;
+    }
+    av_write_trailer(format_context_);
+    avio_closep(&format_context_->pb);
+    avformat_free_context(format_context_);
+    format_context_ = nullptr;
+    stream_ = nullptr;
+    LOG_INFO("⏹️  Recording segment closed: " << segment_path_
+             << " (" << segment_frames_ << " frames)");
+}
+
+std::string EncodedRecorder::nextSegmentPath() const {
+    auto now = std::chrono::system_clock::now();
+    std::time_t t = std::chrono::system_clock::to_time_t(now);
+    int ms = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        now.time_since_epoch()).count() % 1000);
+    struct tm tm_buf;
+    localtime_r(&t, &tm_buf);
+    char name[64];
+    snprintf(name, sizeof(name), "_%04d%02d%02d_%02d%02d%02d_%03d",
+             tm_buf.tm_year + 1900, tm_buf.tm_mon + 1, tm_buf.tm_mday,
+             tm_buf.tm_hour, tm_buf.tm_min, tm_buf.tm_sec, ms);
+    return config_.directory + "/" + config_.prefix + name;
+}
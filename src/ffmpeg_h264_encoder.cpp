@@ -0,0 +1,303 @@
+#include "ffmpeg_h264_encoder.h"
+#include "logger.h"
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/opt.h>
+}
+
+#include <api/video/encoded_image.h>
+#include <api/video/i420_buffer.h>
+#include <api/video/video_frame.h>
+#include <modules/video_coding/include/video_codec_interface.h>
+#include <modules/video_coding/include/video_error_codes.h>
+#include <algorithm>
+#include <sstream>
+
+namespace {
+
+// RTP 视频时钟
+constexpr int kRtpClockRate = 90000;
+
+// x264 sliced threads 超过 16 后收益很小，且每个 slice 都有头部开销
+constexpr int kMaxThreads = 16;
+
+std::string avErrorString(int error) {
+    char buffer[AV_ERROR_MAX_STRING_SIZE] = {0};
+    av_strerror(error, buffer, sizeof(buffer));
+    return buffer;
+}
+
+// AVBuffer 释放时归还其持有的 WebRTC 缓冲区引用
+void releaseI420Buffer(void* opaque, uint8_t* data) {
+    static_cast<webrtc::I420BufferInterface*>(opaque)->Release();
+}
+
+}  // namespace
+
+FfmpegH264Encoder::FfmpegH264Encoder(const H264EncoderConfig& config,
+                                     webrtc::H264PacketizationMode packetization_mode)
+    : config_(config), packetization_mode_(packetization_mode), callback_(nullptr),
+      context_(nullptr), frame_(nullptr), packet_(nullptr),
+      threads_(1), slices_(1), max_payload_size_(0), target_bitrate_bps_(0),
+      last_rtp_timestamp_(0), pts_(-1) {
+}
+
+FfmpegH264Encoder::~FfmpegH264Encoder() {
+    Release();
+}
+
+bool FfmpegH264Encoder::isAvailable() {
+    return avcodec_find_encoder_by_name("libx264") != nullptr;
+}
+
+int32_t FfmpegH264Encoder::InitEncode(const webrtc::VideoCodec* codec_settings,
+                                      const webrtc::VideoEncoder::Settings& settings) {
+    if (!codec_settings || codec_settings->codecType != webrtc::kVideoCodecH264 ||
+        codec_settings->width < 2 || codec_settings->height < 2 ||
+        codec_settings->maxFramerate == 0) {
+        return WEBRTC_VIDEO_CODEC_ERR_PARAMETER;
+    }
+    Release();
+
+    codec_ = *codec_settings;
+    threads_ = std::max(1, std::min(config_.threads > 0 ? config_.threads : settings.number_of_cores,
+                                    kMaxThreads));
+    slices_ = config_.slices > 0 ? config_.slices : threads_;
+    max_payload_size_ = settings.max_payload_size;
+    target_bitrate_bps_ = codec_.startBitrate * 1000;
+
+    if (!openCodec()) {
+        Release();
+        return WEBRTC_VIDEO_CODEC_ERROR;
+    }
+
+    std::ostringstream summary;
+    summary << "🎛️  H264 encoder: libx264 (FFmpeg) " << codec_.width << "x" << codec_.height
+            << " preset=" << config_.preset << " tune=zerolatency threads=" << threads_
+            << " slices=" << slices_
+            << " vbv=" << (config_.vbv_ms > 0 ? std::to_string(config_.vbv_ms) + "ms" : "1 frame");
+    if (config_.intra_refresh) {
+        summary << " intra-refresh";
+    }
+    if (packetization_mode_ == webrtc::H264PacketizationMode::SingleNalUnit) {
+        summary << " slice-max-size=" << max_payload_size_;
+    }
+    LOG_INFO(summary.str());
+    return WEBRTC_VIDEO_CODEC_OK;
+}
+
+bool FfmpegH264Encoder::openCodec() {
+    const AVCodec* codec = avcodec_find_encoder_by_name("libx264");
+    if (!codec) {
+        LOG_ERROR("❌ libavcodec was built without libx264");
+        return false;
+    }
+
+    context_ = avcodec_alloc_context3(codec);
+    frame_ = av_frame_alloc();
+    packet_ = av_packet_alloc();
+    if (!context_ || !frame_ || !packet_) {
+        return false;
+    }
+
+    context_->width = codec_.width;
+    context_->height = codec_.height;
+    context_->pix_fmt = AV_PIX_FMT_YUV420P;
+    context_->time_base = AVRational{1, kRtpClockRate};
+    context_->framerate = AVRational{static_cast<int>(codec_.maxFramerate), 1};
+    context_->bit_rate = target_bitrate_bps_;
+    context_->rc_max_rate = target_bitrate_bps_;
+    context_->rc_buffer_size = vbvBufferSize(codec_.maxFramerate);
+    if (config_.intra_refresh) {
+        // 帧内刷新时 keyint 是一轮刷新的帧数：每秒完整刷新一次画面
+        context_->gop_size = std::max(1, static_cast<int>(codec_.maxFramerate));
+    } else {
+        context_->gop_size = codec_.H264().keyFrameInterval > 0 ? codec_.H264().keyFrameInterval : 3000;
+    }
+    context_->max_b_frames = 0;
+    // 只用 slice 线程：frame 线程每个线程会增加一帧延迟
+    context_->thread_type = FF_THREAD_SLICE;
+    context_->thread_count = threads_;
+    context_->slices = slices_;
+
+    AVDictionary* options = nullptr;
+    av_dict_set(&options, "preset", config_.preset.c_str(), 0);
+    av_dict_set(&options, "tune", "zerolatency", 0);
+    av_dict_set(&options, "profile", "baseline", 0);
+    av_dict_set(&options, "forced-idr", "1", 0);
+    if (config_.intra_refresh) {
+        // 逐列刷新代替周期 IDR；PLI / requestKeyFrame 仍然产生 IDR
+        av_dict_set(&options, "intra-refresh", "1", 0);
+    }
+    if (packetization_mode_ == webrtc::H264PacketizationMode::SingleNalUnit && max_payload_size_ > 0) {
+        // 模式 0 不能分片 NAL，每个 slice 必须装进一个 RTP 包
+        av_dict_set_int(&options, "slice-max-size", static_cast<int64_t>(max_payload_size_), 0);
+    }
+
+    int ret = avcodec_open2(context_, codec, &options);
+    av_dict_free(&options);
+    if (ret < 0) {
+        LOG_ERROR("❌ Failed to open libx264 (preset " << config_.preset << "): "
+                  << avErrorString(ret));
+        return false;
+    }
+    return true;
+}
+
+void FfmpegH264Encoder::closeCodec() {
+    avcodec_free_context(&context_);
+    av_frame_free(&frame_);
+    av_packet_free(&packet_);
+}
+
+int32_t FfmpegH264Encoder::RegisterEncodeCompleteCallback(webrtc::EncodedImageCallback* callback) {
+    callback_ = callback;
+    return WEBRTC_VIDEO_CODEC_OK;
+}
+
+int32_t FfmpegH264Encoder::Release() {
+    closeCodec();
+    pts_ = -1;
+    return WEBRTC_VIDEO_CODEC_OK;
+}
+
+int32_t FfmpegH264Encoder::Encode(const webrtc::VideoFrame& frame,
+                                  const std::vector<webrtc::VideoFrameType>* frame_types) {
+    if (!context_ || !callback_) {
+        return WEBRTC_VIDEO_CODEC_UNINITIALIZED;
+    }
+    // 码率为 0 表示暂停发送
+    if (target_bitrate_bps_ == 0) {
+        return WEBRTC_VIDEO_CODEC_OK;
+    }
+
+    rtc::scoped_refptr<webrtc::I420BufferInterface> buffer = frame.video_frame_buffer()->ToI420();
+    if (!buffer) {
+        return WEBRTC_VIDEO_CODEC_ERROR;
+    }
+
+    // 分辨率变化（源切换或 WebRTC 降分辨率）时重新打开编码器
+    if (buffer->width() != context_->width || buffer->height() != context_->height) {
+        codec_.width = static_cast<uint16_t>(buffer->width());
+        codec_.height = static_cast<uint16_t>(buffer->height());
+        closeCodec();
+        if (!openCodec()) {
+            closeCodec();
+            return WEBRTC_VIDEO_CODEC_ERROR;
+        }
+    }
+
+    bool key_frame_requested = false;
+    if (frame_types) {
+        key_frame_requested = std::any_of(frame_types->begin(), frame_types->end(),
+            [](webrtc::VideoFrameType type) { return type == webrtc::VideoFrameType::kVideoFrameKey; });
+    }
+
+    // RTP 时间戳 32 位回绕，展开成单调递增的 pts
+    if (pts_ < 0) {
+        pts_ = 0;
+    } else {
+        pts_ += static_cast<uint32_t>(frame.timestamp() - last_rtp_timestamp_);
+    }
+    last_rtp_timestamp_ = frame.timestamp();
+
+    // 各平面包装成引用计数的只读 AVBuffer（各持有一个 WebRTC 缓冲区引用）：
+    // 非引用计数的帧会被 avcodec_send_frame 整帧拷贝，这样 libx264 直接读取 WebRTC 缓冲区
+    const int chroma_height = (buffer->height() + 1) / 2;
+    const uint8_t* planes[3] = {buffer->DataY(), buffer->DataU(), buffer->DataV()};
+    const int strides[3] = {buffer->StrideY(), buffer->StrideU(), buffer->StrideV()};
+    const int rows[3] = {buffer->height(), chroma_height, chroma_height};
+    frame_->format = AV_PIX_FMT_YUV420P;
+    frame_->width = buffer->width();
+    frame_->height = buffer->height();
+    for (int i = 0; i < 3; i++) {
+        buffer->AddRef();
+        frame_->buf[i] = av_buffer_create(const_cast<uint8_t*>(planes[i]), strides[i] * rows[i],
+                                          releaseI420Buffer, buffer.get(), AV_BUFFER_FLAG_READONLY);
+        if (!frame_->buf[i]) {
+            buffer->Release();
+            av_frame_unref(frame_);
+            return WEBRTC_VIDEO_CODEC_MEMORY;
+        }
+        frame_->data[i] = const_cast<uint8_t*>(planes[i]);
+        frame_->linesize[i] = strides[i];
+    }
+    frame_->pts = pts_;
+    frame_->pict_type = key_frame_requested ? AV_PICTURE_TYPE_I : AV_PICTURE_TYPE_NONE;
+
+    int ret = avcodec_send_frame(context_, frame_);
+    // 编码器已持有自己的引用
+    av_frame_unref(frame_);
+    if (ret < 0) {
+        LOG_EVERY_MS(LogLevel::kError, 1000, "❌ libx264 send_frame failed: " << avErrorString(ret));
+        return WEBRTC_VIDEO_CODEC_ERROR;
+    }
+
+    // zerolatency + slice 线程：每输入一帧立即输出一帧
+    while ((ret = avcodec_receive_packet(context_, packet_)) == 0) {
+        webrtc::EncodedImage image;
+        image.SetEncodedData(webrtc::EncodedImageBuffer::Create(packet_->data, packet_->size));
+        image._encodedWidth = buffer->width();
+        image._encodedHeight = buffer->height();
+        image.SetTimestamp(frame.timestamp());
+        image.ntp_time_ms_ = frame.ntp_time_ms();
+        image.capture_time_ms_ = frame.render_time_ms();
+        image.rotation_ = frame.rotation();
+        image.content_type_ = codec_.mode == webrtc::VideoCodecMode::kScreensharing
+            ? webrtc::VideoContentType::SCREENSHARE : webrtc::VideoContentType::UNSPECIFIED;
+        image._frameType = (packet_->flags & AV_PKT_FLAG_KEY)
+            ? webrtc::VideoFrameType::kVideoFrameKey : webrtc::VideoFrameType::kVideoFrameDelta;
+
+        bitstream_parser_.ParseBitstream(rtc::ArrayView<const uint8_t>(packet_->data, packet_->size));
+        image.qp_ = bitstream_parser_.GetLastSliceQp().value_or(-1);
+
+        webrtc::CodecSpecificInfo info;
+        info.codecType = webrtc::kVideoCodecH264;
+        info.codecSpecific.H264.packetization_mode = packetization_mode_;
+        info.codecSpecific.H264.temporal_idx = webrtc::kNoTemporalIdx;
+        info.codecSpecific.H264.idr_frame = image._frameType == webrtc::VideoFrameType::kVideoFrameKey;
+        info.codecSpecific.H264.base_layer_sync = false;
+
+        callback_->OnEncodedImage(image, &info);
+        av_packet_unref(packet_);
+    }
+    if (ret != AVERROR(EAGAIN) && ret != AVERROR_EOF) {
+        LOG_EVERY_MS(LogLevel::kError, 1000, "❌ libx264 receive_packet failed: " << avErrorString(ret));
+        return WEBRTC_VIDEO_CODEC_ERROR;
+    }
+    return WEBRTC_VIDEO_CODEC_OK;
+}
+
+void FfmpegH264Encoder::SetRates(const RateControlParameters& parameters) {
+    target_bitrate_bps_ = parameters.bitrate.get_sum_bps();
+    if (!context_ || target_bitrate_bps_ == 0) {
+        return;
+    }
+    // libx264 在下一帧编码前检测到码率变化并调用 x264_encoder_reconfig
+    context_->bit_rate = target_bitrate_bps_;
+    context_->rc_max_rate = target_bitrate_bps_;
+    context_->rc_buffer_size = vbvBufferSize(parameters.framerate_fps > 0 ? parameters.framerate_fps
+                                                                           : codec_.maxFramerate);
+}
+
+int FfmpegH264Encoder::vbvBufferSize(double framerate) const {
+    // 默认半秒 VBV：码率波动小，关键帧不会一次冲出过大的突发
+    // vbv_ms = 0 时只有一帧：每帧都不超过平均帧大小，发送端不排队，代价是画质随内容波动
+    if (config_.vbv_ms > 0) {
+        return static_cast<int>(static_cast<int64_t>(target_bitrate_bps_) * config_.vbv_ms / 1000);
+    }
+    return static_cast<int>(target_bitrate_bps_ / std::max(1.0, framerate));
+}
+
+webrtc::VideoEncoder::EncoderInfo FfmpegH264Encoder::GetEncoderInfo() const {
+    EncoderInfo info;
+    info.supports_native_handle = false;
+    info.implementation_name = "libx264 (FFmpeg)";
+    // 与 OpenH264 相同的 QP 阈值，供质量缩放器使用
+    info.scaling_settings = VideoEncoder::ScalingSettings(24, 37);
+    info.is_hardware_accelerated = false;
+    info.supports_simulcast = false;
+    info.preferred_pixel_formats = {webrtc::VideoFrameBuffer::Type::kI420};
+    return info;
+}
@@ -0,0 +1,33 @@
+#include "frame_overlay.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+namespace {
+
+const cv::Point kTextOrigin(10, 30);
+const int kFontFace = cv::FONT_HERSHEY_SIMPLEX;
+const double kFontScale = 0.7;
+const int kThickness = 2;
+
+}  // namespace
+
+void drawTimestampOverlay(cv::Mat& frame) {
+    auto now = std::chrono::system_clock::now();
+    auto time_t_now = std::chrono::system_clock::to_time_t(now);
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        now.time_since_epoch()) % 1000;
+    
+    char timestamp[100];
+    std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", 
+                 std::localtime(&time_t_now));
+    sprintf(timestamp + strlen(timestamp), ".%03d", static_cast<int>(ms.count()));
+    
+    // 单通道帧（GRAY8 / I420、NV12 的 Y 平面）用白色；YUYV 为 (Y, U/V) 交替，
+    // 写 (255, 128) 同样得到白色；彩色帧用绿色
+    cv::Scalar color = frame.channels() == 1 ? cv::Scalar(255)
+                     : frame.channels() == 2 ? cv::Scalar(255, 128)
+                     : cv::Scalar(0, 255, 0);
+    cv::putText(frame, timestamp, kTextOrigin, kFontFace, kFontScale, color, kThickness);
+}
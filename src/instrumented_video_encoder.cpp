@@ -0,0 +1,235 @@
+#include "instrumented_video_encoder.h"
+#include "latency_tracer.h"
+#include "thread_utils.h"
+#include "logger.h"
+#include <api/video/encoded_image.h>
+#include <api/video/video_frame.h>
+#include <modules/video_coding/include/video_error_codes.h>
+#include <sstream>
+
+namespace {
+
+webrtc::VideoCodecComplexity parseComplexity(const std::string& complexity) {
+    if (complexity == "high") {
+        return webrtc::VideoCodecComplexity::kComplexityHigh;
+    } else if (complexity == "higher") {
+        return webrtc::VideoCodecComplexity::kComplexityHigher;
+    } else if (complexity == "max") {
+        return webrtc::VideoCodecComplexity::kComplexityMax;
+    } else if (complexity != "normal") {
+        LOG_WARN("⚠️  Unknown VP8 complexity '" << complexity << "', using normal");
+    }
+    return webrtc::VideoCodecComplexity::kComplexityNormal;
+}
+
+// libvpx 包装在 x86 上的 cpu-used 映射（ARM 上按分辨率另行选择）
+int vp8CpuUsed(webrtc::VideoCodecComplexity complexity) {
+    switch (complexity) {
+        case webrtc::VideoCodecComplexity::kComplexityHigh:   return -5;
+        case webrtc::VideoCodecComplexity::kComplexityHigher: return -4;
+        case webrtc::VideoCodecComplexity::kComplexityMax:    return -3;
+        default:                                               return -6;
+    }
+}
+
+}  // namespace
+
+// KeyFrameTrigger implementation
+void KeyFrameTrigger::request() {
+    requested_us_ = LatencyTracer::nowUs();
+    generation_++;
+}
+
+// InstrumentedVideoEncoder implementation
+InstrumentedVideoEncoder::InstrumentedVideoEncoder(std::unique_ptr<webrtc::VideoEncoder> encoder,
+                                                   const EncoderConfig& tuning,
+                                                   const ThreadSettings& thread_settings,
+                                                   std::shared_ptr<KeyFrameTrigger> key_frames)
+    : encoder_(std::move(encoder)), callback_(nullptr), pending_pos_(0), last_frame_id_(0),
+      tuning_(tuning), thread_settings_(thread_settings), key_frames_(std::move(key_frames)),
+      handled_key_frame_generation_(key_frames_ ? key_frames_->generation() : 0),
+      forced_key_frame_generation_(handled_key_frame_generation_.load()) {
+}
+
+void InstrumentedVideoEncoder::SetFecControllerOverride(
+    webrtc::FecControllerOverride* fec_controller_override) {
+    encoder_->SetFecControllerOverride(fec_controller_override);
+}
+
+int32_t InstrumentedVideoEncoder::InitEncode(const webrtc::VideoCodec* codec_settings,
+                                             const webrtc::VideoEncoder::Settings& settings) {
+    // 先配置当前线程，编码器在 InitEncode 中创建的工作线程会继承亲和性和调度策略
+    configureCurrentThread();
+    if (!codec_settings) {
+        return encoder_->InitEncode(codec_settings, settings);
+    }
+
+    // 在传给编码器的副本上应用调优参数
+    webrtc::VideoCodec codec = *codec_settings;
+    int number_of_cores = settings.number_of_cores;
+    if (codec.codecType == webrtc::kVideoCodecVP8) {
+        if (tuning_.vp8.threads > 0) {
+            number_of_cores = tuning_.vp8.threads;
+        }
+        codec.SetVideoEncoderComplexity(parseComplexity(tuning_.vp8.complexity));
+    } else if (codec.codecType == webrtc::kVideoCodecH264) {
+        if (tuning_.h264.threads > 0) {
+            number_of_cores = tuning_.h264.threads;
+        }
+    }
+
+    webrtc::VideoEncoder::Settings tuned(settings.capabilities, number_of_cores,
+                                         settings.max_payload_size);
+    int32_t ret = encoder_->InitEncode(&codec, tuned);
+    if (ret == WEBRTC_VIDEO_CODEC_OK) {
+        reportSettings(codec, number_of_cores);
+    }
+    return ret;
+}
+
+int32_t InstrumentedVideoEncoder::RegisterEncodeCompleteCallback(
+    webrtc::EncodedImageCallback* callback) {
+    callback_ = callback;
+    // 插入自身作为回调，以便测量编码完成和打包耗时
+    return encoder_->RegisterEncodeCompleteCallback(callback ? this : nullptr);
+}
+
+int32_t InstrumentedVideoEncoder::Release() {
+    return encoder_->Release();
+}
+
+int32_t InstrumentedVideoEncoder::Encode(const webrtc::VideoFrame& frame,
+                                         const std::vector<webrtc::VideoFrameType>* frame_types) {
+    configureCurrentThread();
+    LatencyTracer& tracer = LatencyTracer::instance();
+    if (tracer.isEnabled()) {
+        PendingFrame& pending = pending_[pending_pos_++ % kMaxPendingFrames];
+        pending.capture_time_ms = frame.render_time_ms();
+        pending.frame_id = unwrapFrameId(frame.id());
+        pending.encode_start_us = LatencyTracer::nowUs();
+    }
+    
+    uint64_t generation = key_frames_ ? key_frames_->generation() : 0;
+    if (generation != handled_key_frame_generation_.load(std::memory_order_acquire)) {
+        // 编码失败或码控丢帧时不算处理过，下一帧继续强制关键帧
+        forced_key_frame_generation_.store(generation, std::memory_order_release);
+        std::vector<webrtc::VideoFrameType> key_frame_types(
+            frame_types ? frame_types->size() : 1, webrtc::VideoFrameType::kVideoFrameKey);
+        return encoder_->Encode(frame, &key_frame_types);
+    }
+    return encoder_->Encode(frame, frame_types);
+}
+
+void InstrumentedVideoEncoder::SetRates(const RateControlParameters& parameters) {
+    encoder_->SetRates(parameters);
+}
+
+void InstrumentedVideoEncoder::OnPacketLossRateUpdate(float packet_loss_rate) {
+    encoder_->OnPacketLossRateUpdate(packet_loss_rate);
+}
+
+void InstrumentedVideoEncoder::OnRttUpdate(int64_t rtt_ms) {
+    encoder_->OnRttUpdate(rtt_ms);
+}
+
+void InstrumentedVideoEncoder::OnLossNotification(const LossNotification& loss_notification) {
+    encoder_->OnLossNotification(loss_notification);
+}
+
+webrtc::VideoEncoder::EncoderInfo InstrumentedVideoEncoder::GetEncoderInfo() const {
+    return encoder_->GetEncoderInfo();
+}
+
+webrtc::EncodedImageCallback::Result InstrumentedVideoEncoder::OnEncodedImage(
+    const webrtc::EncodedImage& encoded_image,
+    const webrtc::CodecSpecificInfo* codec_specific_info) {
+    if (tuning_.playout_delay_ms < 0) {
+        return deliver(encoded_image, codec_specific_info);
+    }
+    // 打包器把 playout_delay_ 写入 playout-delay 扩展；拷贝只增加编码数据的引用计数
+    webrtc::EncodedImage image = encoded_image;
+    image.playout_delay_ = {tuning_.playout_delay_ms, tuning_.playout_delay_ms};
+    return deliver(image, codec_specific_info);
+}
+
+webrtc::EncodedImageCallback::Result InstrumentedVideoEncoder::deliver(
+    const webrtc::EncodedImage& encoded_image,
+    const webrtc::CodecSpecificInfo* codec_specific_info) {
+    // 请求到关键帧交给打包器的耗时，观众加入后多久能看到画面的主要部分
+    if (key_frames_ && encoded_image._frameType == webrtc::VideoFrameType::kVideoFrameKey) {
+        handled_key_frame_generation_.store(forced_key_frame_generation_.load(std::memory_order_acquire),
+                                            std::memory_order_release);
+        int64_t requested_us = key_frames_->takeRequestTime();
+        if (requested_us > 0) {
+            LOG_INFO("🔑 Key frame " << encoded_image._encodedWidth << "x"
+                     << encoded_image._encodedHeight << " (" << encoded_image.size() << " bytes) "
+                     << (LatencyTracer::nowUs() - requested_us) / 1000.0 << " ms after request");
+        }
+    }
+    
+    LatencyTracer& tracer = LatencyTracer::instance();
+    if (!tracer.isEnabled()) {
+        return callback_->OnEncodedImage(encoded_image, codec_specific_info);
+    }
+
+    int64_t encoded_us = LatencyTracer::nowUs();
+    uint64_t frame_id = 0;
+    for (PendingFrame& pending : pending_) {
+        if (pending.capture_time_ms == encoded_image.capture_time_ms_) {
+            frame_id = pending.frame_id;
+            tracer.record(TraceStage::kEncode, frame_id, pending.encode_start_us, encoded_us);
+            pending.capture_time_ms = -1;
+            break;
+        }
+    }
+
+    Result result = callback_->OnEncodedImage(encoded_image, codec_specific_info);
+    tracer.record(TraceStage::kPacketize, frame_id, encoded_us, LatencyTracer::nowUs());
+    return result;
+}
+
+void InstrumentedVideoEncoder::OnDroppedFrame(DropReason reason) {
+    callback_->OnDroppedFrame(reason);
+}
+
+void InstrumentedVideoEncoder::configureCurrentThread() {
+    // 未配置时保持 WebRTC 默认（包括线程名）；编码队列线程不变时只设置一次
+    if (thread_settings_.isDefault() || configured_thread_ == std::this_thread::get_id()) {
+        return;
+    }
+    configured_thread_ = std::this_thread::get_id();
+    applyThreadSettings(thread_settings_, "");
+}
+
+void InstrumentedVideoEncoder::reportSettings(const webrtc::VideoCodec& codec,
+                                              int number_of_cores) const {
+    std::string implementation = encoder_->GetEncoderInfo().implementation_name;
+    std::ostringstream summary;
+    summary << "🎛️  Encoder in effect: " << implementation << " " << codec.width << "x"
+            << codec.height << " @ " << codec.maxFramerate << " fps, cores=" << number_of_cores;
+    if (codec.codecType == webrtc::kVideoCodecVP8) {
+        webrtc::VideoCodecComplexity complexity = codec.GetVideoEncoderComplexity();
+        // libvpx 包装按分辨率限制线程数：1080p 且 8 核以上 8 个，> 1280x960 3 个，> 640x480 2 个，其余 1 个
+        summary << ", complexity=" << tuning_.vp8.complexity
+                << " (x86 cpu-used " << vp8CpuUsed(complexity) << ")"
+                << ", threads chosen by libvpx from cores and resolution";
+    } else if (codec.codecType == webrtc::kVideoCodecH264 &&
+               implementation.find("OpenH264") != std::string::npos) {
+        summary << ", OpenH264 in WebRTC is single-threaded with one slice"
+                << " (h264.threads/preset/slices need implementation=libx264)";
+    }
+    summary << ", degradation=" << tuning_.degradation_preference;
+    LOG_INFO(summary.str());
+}
+
+uint64_t InstrumentedVideoEncoder::unwrapFrameId(uint16_t id) {
+    // VideoFrame::id() 只有 16 位，这里还原为采集线程使用的 64 位帧号
+    uint64_t candidate = (last_frame_id_ & ~uint64_t(0xFFFF)) | id;
+    if (candidate + 0x8000 < last_frame_id_) {
+        candidate += 0x10000;
+    } else if (candidate > last_frame_id_ + 0x8000 && candidate >= 0x10000) {
+        candidate -= 0x10000;
+    }
+    last_frame_id_ = candidate;
+    return candidate;
+}
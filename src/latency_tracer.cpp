@@ -0,0 +1,215 @@
+#include "latency_tracer.h"
+#include "logger.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+uint32_t currentThreadId() {
+    thread_local uint32_t tid = static_cast<uint32_t>(syscall(SYS_gettid));
+    return tid;
+}
+
+int highestBit(uint64_t value) {
+    return 63 - __builtin_clzll(value);
+}
+
+}  // namespace
+
+const char* traceStageName(TraceStage stage) {
+    switch (stage) {
+        case TraceStage::kCapture:   return "capture";
+        case TraceStage::kOverlay:   return "overlay";
+        case TraceStage::kConvert:   return "convert";
+        case TraceStage::kDeliver:   return "deliver";
+        case TraceStage::kEncode:    return "encode";
+        case TraceStage::kPacketize: return "packetize";
+        default:                     return "unknown";
+    }
+}
+
+// LatencyHistogram implementation
+LatencyHistogram::LatencyHistogram() : count_(0), max_(0) {
+    for (auto& bucket : buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+int LatencyHistogram::bucketIndex(int64_t value) {
+    if (value < kSubBuckets) {
+        return value < 0 ? 0 : static_cast<int>(value);
+    }
+    int exponent = highestBit(static_cast<uint64_t>(value));
+    if (exponent > kMaxExponent) {
+        return kNumBuckets - 1;
+    }
+    int mantissa = static_cast<int>((value >> (exponent - kSubBucketBits)) & (kSubBuckets - 1));
+    return (exponent - kSubBucketBits + 1) * kSubBuckets + mantissa;
+}
+
+int64_t LatencyHistogram::bucketLowerBound(int index) {
+    if (index < kSubBuckets) {
+        return index;
+    }
+    int exponent = index / kSubBuckets + kSubBucketBits - 1;
+    int mantissa = index % kSubBuckets;
+    return static_cast<int64_t>(kSubBuckets + mantissa) << (exponent - kSubBucketBits);
+}
+
+void LatencyHistogram::record(int64_t value_us) {
+    buckets_[bucketIndex(value_us)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+
+    int64_t current_max = max_.load(std::memory_order_relaxed);
+    while (value_us > current_max &&
+           !max_.compare_exchange_weak(current_max, value_us, std::memory_order_relaxed)) {
+    }
+}
+
+void LatencyHistogram::reset() {
+    for (auto& bucket : buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
+
+int64_t LatencyHistogram::percentile(double p) const {
+    uint64_t total = count();
+    if (total == 0) {
+        return 0;
+    }
+
+    uint64_t target = static_cast<uint64_t>(p / 100.0 * total + 0.5);
+    target = std::max<uint64_t>(1, std::min(target, total));
+
+    uint64_t seen = 0;
+    for (int i = 0; i < kNumBuckets; i++) {
+        seen += buckets_[i].load(std::memory_order_relaxed);
+        if (seen >= target) {
+            return std::min(bucketLowerBound(i), max());
+        }
+    }
+    return max();
+}
+
+// LatencyTracer implementation
+LatencyTracer& LatencyTracer::instance() {
+    static LatencyTracer tracer;
+    return tracer;
+}
+
+LatencyTracer::LatencyTracer() : enabled_(false), write_pos_(0) {
+}
+
+int64_t LatencyTracer::nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void LatencyTracer::record(TraceStage stage, uint64_t frame_id, int64_t begin_us, int64_t end_us) {
+    if (!isEnabled()) {
+        return;
+    }
+
+    histograms_[static_cast<size_t>(stage)].record(end_us - begin_us);
+
+    // 多生产者写入：先占位，再以序号发布（读者据此判断槽位是否完整）
+    uint64_t pos = write_pos_.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = ring_[pos & (kRingSize - 1)];
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.frame_id.store(frame_id, std::memory_order_relaxed);
+    slot.begin_us.store(begin_us, std::memory_order_relaxed);
+    slot.end_us.store(end_us, std::memory_order_relaxed);
+    slot.thread_id.store(currentThreadId(), std::memory_order_relaxed);
+    slot.stage.store(static_cast<uint8_t>(stage), std::memory_order_relaxed);
+    slot.sequence.store(pos + 1, std::memory_order_release);
+}
+
+void LatencyTracer::resetHistograms() {
+    for (auto& histogram : histograms_) {
+        histogram.reset();
+    }
+}
+
+void LatencyTracer::printSummary(std::ostream& os) const {
+    os << "⏱️  Stage latency (us):" << std::endl;
+    os << "  " << std::left << std::setw(11) << "stage"
+       << std::right << std::setw(10) << "count"
+       << std::setw(10) << "p50"
+       << std::setw(10) << "p99"
+       << std::setw(10) << "max" << std::endl;
+
+    for (size_t i = 0; i < histograms_.size(); i++) {
+        const LatencyHistogram& h = histograms_[i];
+        os << "  " << std::left << std::setw(11) << traceStageName(static_cast<TraceStage>(i))
+           << std::right << std::setw(10) << h.count()
+           << std::setw(10) << h.percentile(50)
+           << std::setw(10) << h.percentile(99)
+           << std::setw(10) << h.max() << std::endl;
+    }
+}
+
+bool LatencyTracer::dumpChromeTrace(const std::string& path) const {
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        LOG_ERROR("Failed to open trace file: " << path);
+        return false;
+    }
+
+    struct Event {
+        uint64_t frame_id;
+        int64_t begin_us;
+        int64_t end_us;
+        uint32_t thread_id;
+        uint8_t stage;
+    };
+
+    // 快照环形缓冲区；正在被覆盖的槽位（序号前后不一致）直接跳过
+    uint64_t end = write_pos_.load(std::memory_order_acquire);
+    uint64_t begin = end > kRingSize ? end - kRingSize : 0;
+
+    std::vector<Event> events;
+    events.reserve(static_cast<size_t>(end - begin));
+    for (uint64_t pos = begin; pos < end; pos++) {
+        const Slot& slot = ring_[pos & (kRingSize - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != pos + 1) {
+            continue;
+        }
+        Event e;
+        e.frame_id = slot.frame_id.load(std::memory_order_relaxed);
+        e.begin_us = slot.begin_us.load(std::memory_order_relaxed);
+        e.end_us = slot.end_us.load(std::memory_order_relaxed);
+        e.thread_id = slot.thread_id.load(std::memory_order_relaxed);
+        e.stage = slot.stage.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != pos + 1) {
+            continue;
+        }
+        events.push_back(e);
+    }
+
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << getpid()
+         << ",\"args\":{\"name\":\"webrtc_streamer\"}}";
+    for (const Event& e : events) {
+        file << ",\n{\"name\":\"" << traceStageName(static_cast<TraceStage>(e.stage)) << "\""
+             << ",\"cat\":\"pipeline\",\"ph\":\"X\""
+             << ",\"ts\":" << e.begin_us
+             << ",\"dur\":" << (e.end_us - e.begin_us)
+             << ",\"pid\":" << getpid()
+             << ",\"tid\":" << e.thread_id
+             << ",\"args\":{\"frame\":" << e.frame_id << "}}";
+    }
+    file << "\n]}\n";
+
+    LOG_INFO("📝 Wrote " << events.size() << " trace events to " << path);
+    return true;
+}
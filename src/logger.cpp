@@ -0,0 +1,235 @@
+#include "logger.h"
+#include "signaling_utils.h"
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+uint32_t currentThreadId() {
+    thread_local uint32_t tid = static_cast<uint32_t>(syscall(SYS_gettid));
+    return tid;
+}
+
+int64_t wallTimeUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+int64_t steadyTimeUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// "2026-01-31 12:34:56.789"（本地时间）
+void appendTimestamp(int64_t wall_time_us, std::string& out) {
+    time_t seconds = static_cast<time_t>(wall_time_us / 1000000);
+    struct tm local;
+    localtime_r(&seconds, &local);
+    char buffer[32];
+    size_t length = strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &local);
+    snprintf(buffer + length, sizeof(buffer) - length, ".%03d",
+             static_cast<int>(wall_time_us / 1000 % 1000));
+    out += buffer;
+}
+
+}  // namespace
+
+bool parseLogLevel(const std::string& name, LogLevel& level) {
+    static const struct {
+        const char* name;
+        LogLevel level;
+    } kLevels[] = {
+        {"trace", LogLevel::kTrace}, {"debug", LogLevel::kDebug}, {"info", LogLevel::kInfo},
+        {"warn", LogLevel::kWarn}, {"warning", LogLevel::kWarn}, {"error", LogLevel::kError},
+        {"off", LogLevel::kOff},
+    };
+    for (const auto& entry : kLevels) {
+        if (name == entry.name) {
+            level = entry.level;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* logLevelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::kTrace: return "trace";
+        case LogLevel::kDebug: return "debug";
+        case LogLevel::kInfo:  return "info";
+        case LogLevel::kWarn:  return "warn";
+        case LogLevel::kError: return "error";
+        default:               return "off";
+    }
+}
+
+// Logger implementation
+Logger& Logger::instance() {
+    static Logger logger;
+    return logger;
+}
+
+Logger::Logger()
+    : enqueue_pos_(0), written_pos_(0), dropped_(0), level_(LogLevel::kInfo),
+      timestamps_(true), json_(false), should_stop_(false) {
+    for (size_t i = 0; i < kRingSize; i++) {
+        ring_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    writer_ = std::thread(&Logger::writerThread, this);
+}
+
+Logger::~Logger() {
+    // 写线程退出前会写完队列中剩余的消息
+    should_stop_ = true;
+    if (writer_.joinable()) {
+        writer_.join();
+    }
+}
+
+bool Logger::configure(const LogConfig& config) {
+    bool ok = true;
+    LogLevel level;
+    if (parseLogLevel(config.level, level)) {
+        level_.store(level, std::memory_order_relaxed);
+    } else {
+        LOG_WARN("⚠️  Unknown log level '" << config.level << "', keeping "
+                 << logLevelName(level_.load(std::memory_order_relaxed)));
+        ok = false;
+    }
+    if (config.format == "json" || config.format == "text") {
+        json_.store(config.format == "json", std::memory_order_relaxed);
+    } else {
+        LOG_WARN("⚠️  Unknown log format '" << config.format << "', keeping "
+                 << (json_.load(std::memory_order_relaxed) ? "json" : "text"));
+        ok = false;
+    }
+    timestamps_.store(config.enable_timestamp, std::memory_order_relaxed);
+    return ok;
+}
+
+void Logger::write(LogLevel level, std::string message) {
+    // 有界 MPSC 环形队列：CAS 抢占一个位置，写满时丢弃而不是阻塞调用线程
+    uint64_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    Slot* slot;
+    for (;;) {
+        slot = &ring_[pos & (kRingSize - 1)];
+        int64_t diff = static_cast<int64_t>(slot->sequence.load(std::memory_order_acquire) - pos);
+        if (diff == 0) {
+            if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        } else {
+            pos = enqueue_pos_.load(std::memory_order_relaxed);
+        }
+    }
+    slot->level = level;
+    slot->wall_time_us = wallTimeUs();
+    slot->thread_id = currentThreadId();
+    slot->message = std::move(message);
+    slot->sequence.store(pos + 1, std::memory_order_release);
+}
+
+void Logger::flush() {
+    const uint64_t target = enqueue_pos_.load(std::memory_order_acquire);
+    while (written_pos_.load(std::memory_order_acquire) < target) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+void Logger::format(const Slot& slot, std::string& out) const {
+    if (json_.load(std::memory_order_relaxed)) {
+        out += "{\"ts_us\":";
+        out += std::to_string(slot.wall_time_us);
+        out += ",\"level\":\"";
+        out += logLevelName(slot.level);
+        out += "\",\"tid\":";
+        out += std::to_string(slot.thread_id);
+        out += ",\"msg\":\"";
+        out += escapeJsonString(slot.message);
+        out += "\"}\n";
+        return;
+    }
+    if (timestamps_.load(std::memory_order_relaxed)) {
+        out += '[';
+        appendTimestamp(slot.wall_time_us, out);
+        out += "] ";
+    }
+    out += slot.message;
+    out += '\n';
+}
+
+void Logger::writerThread() {
+    uint64_t read_pos = 0;
+    uint64_t reported_dropped = 0;
+    std::string out;
+    std::string err;
+
+    for (;;) {
+        // 先取停止标志再读队列：置位之前入队的消息都会被写出
+        const bool stopping = should_stop_.load(std::memory_order_acquire);
+        while (true) {
+            Slot& slot = ring_[read_pos & (kRingSize - 1)];
+            if (slot.sequence.load(std::memory_order_acquire) != read_pos + 1) {
+                break;
+            }
+            format(slot, slot.level >= LogLevel::kWarn ? err : out);
+            slot.message.clear();
+            slot.sequence.store(read_pos + kRingSize, std::memory_order_release);
+            read_pos++;
+        }
+        const uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+        if (dropped != reported_dropped) {
+            err += "⚠️  " + std::to_string(dropped - reported_dropped) + " log messages dropped (queue full)\n";
+            reported_dropped = dropped;
+        }
+
+        if (!out.empty()) {
+            fwrite(out.data(), 1, out.size(), stdout);
+            fflush(stdout);
+            out.clear();
+        }
+        if (!err.empty()) {
+            fwrite(err.data(), 1, err.size(), stderr);
+            fflush(stderr);
+            err.clear();
+        }
+        written_pos_.store(read_pos, std::memory_order_release);
+
+        if (stopping) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(kIdleWaitMs));
+    }
+}
+
+// LogStream implementation
+LogStream::LogStream() : stream_([]() -> std::ostringstream& {
+    thread_local std::ostringstream stream;
+    return stream;
+}()) {
+    // 上一条消息可能改过格式（std::fixed、setprecision 等）
+    stream_.str(std::string());
+    stream_.clear();
+    stream_.flags(std::ios_base::dec | std::ios_base::skipws);
+    stream_.precision(6);
+    stream_.fill(' ');
+}
+
+// LogRateLimiter implementation
+bool LogRateLimiter::allow(uint64_t& suppressed) {
+    const int64_t now_us = steadyTimeUs();
+    int64_t next_us = next_us_.load(std::memory_order_relaxed);
+    if (now_us < next_us ||
+        !next_us_.compare_exchange_strong(next_us, now_us + interval_us_, std::memory_order_relaxed)) {
+        suppressed_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    suppressed = suppressed_.exchange(0, std::memory_order_relaxed);
+    return true;
+}
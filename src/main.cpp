@@ -1,56 +1,298 @@
+#include <algorithm>
 #include <iostream>
 #include <memory>
 #include <csignal>
 #include <atomic>
+#include <cstdio>
+#include <vector>
 #include "video_source.h"
 #ifdef ENABLE_REALSENSE
 #include "realsense_source.h"
 #endif
 #include "opencv_source.h"
+#include "test_pattern_source.h"
+#include "shared_memory_source.h"
+#include "v4l2_source.h"
+#include "mosaic_source.h"
 #include "webrtc_client.h"
 #include "config_parser.h"
+#include "config_watcher.h"
+#include "latency_tracer.h"
+#include "logger.h"
+#include "encode_benchmark.h"
 
 std::atomic<bool> g_running(true);
+std::atomic<bool> g_dump_trace(false);
 
 void signalHandler(int signal) {
     std::cout << "\nReceived signal " << signal << ", shutting down..." << std::endl;
     g_running = false;
 }
 
+void traceSignalHandler(int) {
+    g_dump_trace = true;
+}
+
+void dumpLatencyTrace(const TracingConfig& tracing) {
+    // 摘要直接写 stdout，先让排队的日志写完，避免交错
+    Logger::instance().flush();
+    LatencyTracer& tracer = LatencyTracer::instance();
+    tracer.printSummary(std::cout);
+    tracer.dumpChromeTrace(tracing.output_file);
+}
+
 void printUsage(const char* program_name) {
     std::cout << "Usage: " << program_name << " [options]" << std::endl;
     std::cout << "\nOptions:" << std::endl;
     std::cout << "  --config <file>       配置文件路径 (default: config/config.json)" << std::endl;
     std::cout << "  --create-config       创建默认配置文件并退出" << std::endl;
-    std::cout << "  --source <type>       视频源类型: realsense|camera|file|rtsp" << std::endl;
-    std::cout << "  --device <id>         相机设备 ID (for camera source)" << std::endl;
+    std::cout << "  --source <type>       视频源类型: realsense|camera|v4l2|file|rtsp|pattern|shm" << std::endl;
+    std::cout << "  --device <id>         相机设备 ID (for camera/v4l2 source)" << std::endl;
+    std::cout << "  --v4l2-format <f>     V4L2 像素格式: yuyv|uyvy|nv12|grey|y16|mjpeg (for v4l2 source)" << std::endl;
+    std::cout << "  --v4l2-buffers <n>    V4L2 mmap 缓冲区数量 (default: 4)" << std::endl;
+    std::cout << "  --mjpeg-scale <WxH>   MJPEG 以 DCT 缩放解码到不小于 WxH 的分辨率" << std::endl;
     std::cout << "  --file <path>         视频文件路径或 RTSP URL" << std::endl;
     std::cout << "  --width <width>       视频宽度" << std::endl;
     std::cout << "  --height <height>     视频高度" << std::endl;
     std::cout << "  --fps <fps>           帧率" << std::endl;
     std::cout << "  --depth               启用深度流 (RealSense)" << std::endl;
+    std::cout << "  --pattern <name>      测试图案: bars|box|noise|static (for pattern source)" << std::endl;
+    std::cout << "  --pattern-format <f>  测试图案输出格式: bgr|i420" << std::endl;
+    std::cout << "  --shm <name>          共享内存帧环名称或路径 (for shm source)" << std::endl;
+    std::cout << "  --mosaic <layout>     将所有视频源合成一路画面: grid|pip|custom" << std::endl;
+    std::cout << "  --crop <x,y,w,h>      数字变焦：编码前裁剪的归一化窗口 (0-1)" << std::endl;
+    std::cout << "  --crop-output <WxH>   裁剪后的输出分辨率 (default: 与源相同)" << std::endl;
+    std::cout << "  --static-scene        画面静止时降低发送帧率（运动时立即恢复）" << std::endl;
+    std::cout << "  --adapt <policy>      按 RTT/丢包自适应: maintain-framerate|maintain-resolution|latency-first" << std::endl;
+    std::cout << "  --latency-mode <m>    延迟模式: normal|ultra（ultra 以平滑度换取最低延迟）" << std::endl;
+    std::cout << "  --encoder-threads <n> 编码线程数 (VP8 与 H.264 共用, default: 全部 CPU)" << std::endl;
+    std::cout << "  --h264-encoder <e>    H.264 编码器: openh264|libx264" << std::endl;
     std::cout << "  --server <ip>         服务器 IP 地址" << std::endl;
     std::cout << "  --port <port>         服务器端口" << std::endl;
+    std::cout << "  --trace               启用各阶段延迟追踪 (kill -USR1 导出 Chrome trace)" << std::endl;
+    std::cout << "  --log-level <l>       日志级别: trace|debug|info|warn|error|off" << std::endl;
+    std::cout << "  --record <dir>        录制已编码的视频流到目录 (分段 MKV/MP4，不二次编码)" << std::endl;
+    std::cout << "  --bench               离线编码基准：采集→叠加→转换→编码，无信令/网络" << std::endl;
+    std::cout << "  --bench-duration <s>  基准运行时长，秒 (default: 10)" << std::endl;
+    std::cout << "  --bench-frames <n>    基准最大帧数 (default: 不限)" << std::endl;
+    std::cout << "  --codec <name>        基准使用的编码器: VP8|H264 (default: VP8)" << std::endl;
+    std::cout << "  --bitrate <kbps>      基准目标码率 (default: 2000)" << std::endl;
     std::cout << "  --help                显示帮助信息" << std::endl;
     std::cout << "\n说明:" << std::endl;
     std::cout << "  - 命令行参数会覆盖配置文件中的设置" << std::endl;
     std::cout << "  - STUN/TURN 服务器配置请编辑 config/config.json 文件" << std::endl;
+    std::cout << "  - 运行中修改配置文件会自动热加载（hot_reload），无法在线生效的项会提示重启" << std::endl;
     std::cout << "\nExamples:" << std::endl;
     std::cout << "  " << program_name << " --config my_config.json" << std::endl;
     std::cout << "  " << program_name << " --create-config" << std::endl;
     std::cout << "  " << program_name << " --source camera --device 0" << std::endl;
     std::cout << "  " << program_name << " --source rtsp --file rtsp://example.com/stream" << std::endl;
+    std::cout << "  " << program_name << " --source pattern --pattern noise --width 3840 --height 2160 --fps 60" << std::endl;
+    std::cout << "  " << program_name << " --bench --source pattern --width 1920 --height 1080 --codec H264" << std::endl;
+    std::cout << "  " << program_name << " --bench --source pattern --width 3840 --height 2160 --codec H264 --h264-encoder libx264 --encoder-threads 8" << std::endl;
+}
+
+std::shared_ptr<VideoSource> createVideoSource(const VideoConfig& video) {
+    if (video.source == "realsense") {
+#ifdef ENABLE_REALSENSE
+        LOG_INFO("Using Intel RealSense camera");
+        return std::make_shared<RealSenseSource>(video.width, video.height, video.fps, video.enable_depth);
+#else
+        LOG_ERROR("Error: RealSense support not compiled. Rebuild with -DENABLE_REALSENSE=ON");
+        return nullptr;
+#endif
+    } else if (video.source == "camera") {
+        LOG_INFO("Using USB/OpenCV camera");
+        return std::make_shared<OpenCVSource>(video.device_id, video.width, video.height, video.fps);
+    } else if (video.source == "v4l2") {
+        std::string device = "/dev/video" + std::to_string(video.device_id);
+        LOG_INFO("Using V4L2 device: " << device << " (" << video.v4l2_format << ")");
+        return std::make_shared<V4L2Source>(device, video.width, video.height, video.fps,
+                                            video.v4l2_format, video.v4l2_buffers);
+    } else if (video.source == "file" || video.source == "rtsp") {
+        if (video.file_path.empty()) {
+            LOG_ERROR("Error: --file parameter required for file/rtsp source");
+            return nullptr;
+        }
+        LOG_INFO("Using video file/stream: " << video.file_path);
+        return std::make_shared<OpenCVSource>(video.file_path, video.fps);
+    } else if (video.source == "pattern") {
+        PixelFormat format = video.pattern_format == "i420" ? PixelFormat::kI420 : PixelFormat::kBGR;
+        LOG_INFO("Using synthetic test pattern: " << video.pattern);
+        return std::make_shared<TestPatternSource>(video.pattern, format, video.width, video.height, video.fps);
+    } else if (video.source == "shm") {
+        LOG_INFO("Using shared memory frame ring: " << video.shm_name);
+        return std::make_shared<SharedMemorySource>(video.shm_name);
+    }
+    LOG_ERROR("Unknown source type: " << video.source);
+    return nullptr;
+}
+
+void releaseVideoSources(const std::vector<std::shared_ptr<VideoSource>>& video_sources) {
+    for (const auto& video_source : video_sources) {
+        video_source->release();
+    }
+}
+
+// Parse command line arguments (second pass - override config)
+// 热加载时对重新读取的配置再执行一次，命令行设置始终优先
+bool applyCommandLine(int argc, char* argv[], AppConfig& config,
+                      bool& bench_mode, EncodeBenchmarkOptions& bench_options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        
+        if (arg == "--config") {
+            i++; // Skip, already processed
+        } else if (arg == "--source" && i + 1 < argc) {
+            config.video.source = argv[++i];
+        } else if (arg == "--device" && i + 1 < argc) {
+            config.video.device_id = std::stoi(argv[++i]);
+        } else if (arg == "--v4l2-format" && i + 1 < argc) {
+            config.video.v4l2_format = argv[++i];
+        } else if (arg == "--v4l2-buffers" && i + 1 < argc) {
+            config.video.v4l2_buffers = std::stoi(argv[++i]);
+        } else if (arg == "--mjpeg-scale" && i + 1 < argc) {
+            std::string size = argv[++i];
+            size_t x = size.find('x');
+            if (x == std::string::npos) {
+                std::cerr << "Invalid --mjpeg-scale value: " << size << " (expected WxH)" << std::endl;
+                return false;
+            }
+            config.video.mjpeg_scale_width = std::stoi(size.substr(0, x));
+            config.video.mjpeg_scale_height = std::stoi(size.substr(x + 1));
+        } else if (arg == "--file" && i + 1 < argc) {
+            config.video.file_path = argv[++i];
+        } else if (arg == "--width" && i + 1 < argc) {
+            config.video.width = std::stoi(argv[++i]);
+        } else if (arg == "--height" && i + 1 < argc) {
+            config.video.height = std::stoi(argv[++i]);
+        } else if (arg == "--fps" && i + 1 < argc) {
+            config.video.fps = std::stoi(argv[++i]);
+        } else if (arg == "--depth") {
+            config.video.enable_depth = true;
+        } else if (arg == "--pattern" && i + 1 < argc) {
+            config.video.pattern = argv[++i];
+        } else if (arg == "--pattern-format" && i + 1 < argc) {
+            config.video.pattern_format = argv[++i];
+        } else if (arg == "--shm" && i + 1 < argc) {
+            config.video.shm_name = argv[++i];
+        } else if (arg == "--mosaic" && i + 1 < argc) {
+            config.mosaic.enabled = true;
+            config.mosaic.layout = argv[++i];
+        } else if (arg == "--crop" && i + 1 < argc) {
+            std::string window = argv[++i];
+            CropConfig& crop = config.video.crop;
+            if (std::sscanf(window.c_str(), "%lf,%lf,%lf,%lf",
+                            &crop.x, &crop.y, &crop.width, &crop.height) != 4) {
+                std::cerr << "Invalid --crop value: " << window << " (expected x,y,w,h)" << std::endl;
+                return false;
+            }
+        } else if (arg == "--crop-output" && i + 1 < argc) {
+            std::string size = argv[++i];
+            size_t x = size.find('x');
+            if (x == std::string::npos) {
+                std::cerr << "Invalid --crop-output value: " << size << " (expected WxH)" << std::endl;
+                return false;
+            }
+            config.video.crop.output_width = std::stoi(size.substr(0, x));
+            config.video.crop.output_height = std::stoi(size.substr(x + 1));
+        } else if (arg == "--static-scene") {
+            config.static_scene.enabled = true;
+        } else if (arg == "--adapt" && i + 1 < argc) {
+            config.adaptation.enabled = true;
+            config.adaptation.policy = argv[++i];
+        } else if (arg == "--latency-mode" && i + 1 < argc) {
+            config.latency_mode = argv[++i];
+        } else if (arg == "--encoder-threads" && i + 1 < argc) {
+            config.encoder.vp8.threads = std::stoi(argv[++i]);
+            config.encoder.h264.threads = config.encoder.vp8.threads;
+        } else if (arg == "--h264-encoder" && i + 1 < argc) {
+            config.encoder.h264.implementation = argv[++i];
+        } else if (arg == "--server" && i + 1 < argc) {
+            config.webrtc.server_ip = argv[++i];
+        } else if (arg == "--port" && i + 1 < argc) {
+            config.webrtc.server_port = std::stoi(argv[++i]);
+        } else if (arg == "--trace") {
+            config.tracing.enabled = true;
+        } else if (arg == "--log-level" && i + 1 < argc) {
+            config.logging.level = argv[++i];
+        } else if (arg == "--record" && i + 1 < argc) {
+            config.recording.enabled = true;
+            config.recording.directory = argv[++i];
+        } else if (arg == "--bench") {
+            bench_mode = true;
+        } else if (arg == "--bench-duration" && i + 1 < argc) {
+            bench_options.duration_s = std::stoi(argv[++i]);
+        } else if (arg == "--bench-frames" && i + 1 < argc) {
+            bench_options.max_frames = std::stoi(argv[++i]);
+        } else if (arg == "--codec" && i + 1 < argc) {
+            bench_options.codec = argv[++i];
+        } else if (arg == "--bitrate" && i + 1 < argc) {
+            bench_options.bitrate_kbps = std::stoi(argv[++i]);
+        } else if (arg != "--help" && arg != "--create-config") {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            printUsage(argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+// 命令行参数覆盖的配置文件字段（与 changedFields 的命名一致），热加载时这些字段的修改不会生效。
+// 视频参数只覆盖主视频，数组中其余视频源的字段带下标（"video.1.fps"），不受影响
+std::vector<std::string> commandLineFields(int argc, char* argv[]) {
+    static const std::vector<std::pair<std::string, std::vector<std::string>>> kFlagFields = {
+        {"--source", {"video.source"}},
+        {"--device", {"video.device_id"}},
+        {"--v4l2-format", {"video.v4l2_format"}},
+        {"--v4l2-buffers", {"video.v4l2_buffers"}},
+        {"--mjpeg-scale", {"video.mjpeg_scale_width", "video.mjpeg_scale_height"}},
+        {"--file", {"video.file_path"}},
+        {"--width", {"video.width"}},
+        {"--height", {"video.height"}},
+        {"--fps", {"video.fps"}},
+        {"--depth", {"video.enable_depth"}},
+        {"--pattern", {"video.pattern"}},
+        {"--pattern-format", {"video.pattern_format"}},
+        {"--shm", {"video.shm_name"}},
+        {"--mosaic", {"mosaic.enabled", "mosaic.layout"}},
+        {"--crop", {"video.crop.x", "video.crop.y", "video.crop.width", "video.crop.height"}},
+        {"--crop-output", {"video.crop.output_width", "video.crop.output_height"}},
+        {"--static-scene", {"static_scene.enabled"}},
+        {"--adapt", {"adaptation.enabled", "adaptation.policy"}},
+        {"--latency-mode", {"latency_mode"}},
+        {"--encoder-threads", {"encoder.vp8.threads", "encoder.h264.threads"}},
+        {"--h264-encoder", {"encoder.h264.implementation"}},
+        {"--server", {"webrtc.server.ip"}},
+        {"--port", {"webrtc.server.port"}},
+        {"--trace", {"tracing.enabled"}},
+        {"--log-level", {"logging.level"}},
+        {"--record", {"recording.enabled", "recording.directory"}},
+    };
+    
+    std::vector<std::string> fields;
+    for (int i = 1; i < argc; i++) {
+        for (const auto& flag : kFlagFields) {
+            if (flag.first == argv[i]) {
+                fields.insert(fields.end(), flag.second.begin(), flag.second.end());
+            }
+        }
+    }
+    return fields;
 }
 
 int main(int argc, char* argv[]) {
     // Setup signal handler
     signal(SIGINT, signalHandler);
     signal(SIGTERM, signalHandler);
+    signal(SIGUSR1, traceSignalHandler);
 
     // Configuration
     ConfigParser config_parser;
     std::string config_file = "config/config.json";
     bool use_config_file = true;
+    bool bench_mode = false;
+    EncodeBenchmarkOptions bench_options;
     
     // Parse command line arguments (first pass - check for config file and create-config)
     for (int i = 1; i < argc; i++) {
@@ -76,116 +318,167 @@ int main(int argc, char* argv[]) {
     }
     
     // Load configuration from file
-    config_parser.loadFromFile(config_file);
+    bool config_loaded = config_parser.loadFromFile(config_file);
     AppConfig& config = config_parser.getConfig();
     
-    // Parse command line arguments (second pass - override config)
-    for (int i = 1; i < argc; i++) {
-        std::string arg = argv[i];
-        
-        if (arg == "--config") {
-            i++; // Skip, already processed
-        } else if (arg == "--source" && i + 1 < argc) {
-            config.video.source = argv[++i];
-        } else if (arg == "--device" && i + 1 < argc) {
-            config.video.device_id = std::stoi(argv[++i]);
-        } else if (arg == "--file" && i + 1 < argc) {
-            config.video.file_path = argv[++i];
-        } else if (arg == "--width" && i + 1 < argc) {
-            config.video.width = std::stoi(argv[++i]);
-        } else if (arg == "--height" && i + 1 < argc) {
-            config.video.height = std::stoi(argv[++i]);
-        } else if (arg == "--fps" && i + 1 < argc) {
-            config.video.fps = std::stoi(argv[++i]);
-        } else if (arg == "--depth") {
-            config.video.enable_depth = true;
-        } else if (arg == "--server" && i + 1 < argc) {
-            config.webrtc.server_ip = argv[++i];
-        } else if (arg == "--port" && i + 1 < argc) {
-            config.webrtc.server_port = std::stoi(argv[++i]);
-        } else if (arg != "--help" && arg != "--create-config") {
-            std::cerr << "Unknown argument: " << arg << std::endl;
-            printUsage(argv[0]);
-            return 1;
-        }
+    if (!applyCommandLine(argc, argv, config, bench_mode, bench_options)) {
+        return 1;
     }
     
+    // 展开延迟模式（在配置文件和命令行之后，覆盖其中相关的设置）
+    if (!applyLatencyProfile(config)) {
+        return 1;
+    }
+    
+    Logger::instance().configure(config.logging);
+    
     // Print current configuration
+    Logger::instance().flush();
     config_parser.printConfig();
+    bench_options.tuning = config.encoder;
     
-    // Extract config values for easier access
-    std::string source_type = config.video.source;
-    int device_id = config.video.device_id;
-    std::string file_path = config.video.file_path;
-    int width = config.video.width;
-    int height = config.video.height;
-    int fps = config.video.fps;
-    bool enable_depth = config.video.enable_depth;
-    std::string server_ip = config.webrtc.server_ip;
-    int server_port = config.webrtc.server_port;
-
-    // Create video source based on type
-    std::shared_ptr<VideoSource> video_source;
+    LatencyTracer::instance().setEnabled(config.tracing.enabled);
     
-    if (source_type == "realsense") {
-#ifdef ENABLE_REALSENSE
-        std::cout << "Using Intel RealSense camera" << std::endl;
-        video_source = std::make_shared<RealSenseSource>(width, height, fps, enable_depth);
-#else
-        std::cerr << "Error: RealSense support not compiled. Rebuild with -DENABLE_REALSENSE=ON" << std::endl;
-        return 1;
-#endif
-    } else if (source_type == "camera") {
-        std::cout << "Using USB/OpenCV camera" << std::endl;
-        video_source = std::make_shared<OpenCVSource>(device_id, width, height, fps);
-    } else if (source_type == "file" || source_type == "rtsp") {
-        if (file_path.empty()) {
-            std::cerr << "Error: --file parameter required for file/rtsp source" << std::endl;
+    // Create video sources: config.video plus any extra entries of a "video" array
+    std::vector<std::shared_ptr<VideoSource>> video_sources;
+    std::vector<VideoConfig> video_configs = {config.video};
+    video_configs.insert(video_configs.end(), config.extra_videos.begin(), config.extra_videos.end());
+    
+    for (const auto& video_config : video_configs) {
+        std::shared_ptr<VideoSource> video_source = createVideoSource(video_config);
+        if (!video_source) {
+            Logger::instance().flush();
+            printUsage(argv[0]);
+            releaseVideoSources(video_sources);
             return 1;
         }
-        std::cout << "Using video file/stream: " << file_path << std::endl;
-        video_source = std::make_shared<OpenCVSource>(file_path, fps);
-    } else {
-        std::cerr << "Unknown source type: " << source_type << std::endl;
-        printUsage(argv[0]);
-        return 1;
+        
+        // 采集队列深度 1：只取最新帧
+        if (config.latency_mode == "ultra" && !video_source->setLatestFrameOnly(true)) {
+            LOG_WARN("⚠️  " << video_config.source << " source cannot drop queued frames");
+        }
+        
+        // Initialize video source
+        if (!video_source->initialize()) {
+            LOG_ERROR("Failed to initialize video source: " << video_config.source);
+            releaseVideoSources(video_sources);
+            return 1;
+        }
+        video_sources.push_back(video_source);
     }
+    
+    // Mosaic: composite all sources into one canvas, sent as a single track
+    if (config.mosaic.enabled) {
+        auto mosaic = std::make_shared<MosaicSource>(video_sources, config.mosaic);
+        if (!mosaic->initialize()) {
+            LOG_ERROR("Failed to initialize mosaic");
+            mosaic->release();
+            return 1;
+        }
+        video_sources = {mosaic};
+    }
+    std::shared_ptr<VideoSource> video_source = video_sources.front();
 
-    // Initialize video source
-    if (!video_source->initialize()) {
-        std::cerr << "Failed to initialize video source" << std::endl;
-        return 1;
+    // Headless encode benchmark: no signaling, no network (primary source only)
+    if (bench_mode) {
+        EncodeBenchmark benchmark(video_source, bench_options);
+        bool ok = benchmark.run(g_running);
+        releaseVideoSources(video_sources);
+        if (config.tracing.enabled) {
+            dumpLatencyTrace(config.tracing);
+        }
+        return ok ? 0 : 1;
     }
 
     // Create WebRTC client
-    auto webrtc_client = std::make_unique<WebRTCClient>(video_source, config.webrtc);
+    auto webrtc_client = std::make_unique<WebRTCClient>(video_sources, config);
     
     if (!webrtc_client->initialize()) {
-        std::cerr << "Failed to initialize WebRTC client" << std::endl;
-        video_source->release();
+        LOG_ERROR("Failed to initialize WebRTC client");
+        releaseVideoSources(video_sources);
         return 1;
     }
 
     // Start streaming
     if (!webrtc_client->start()) {
-        std::cerr << "Failed to start streaming" << std::endl;
-        video_source->release();
+        LOG_ERROR("Failed to start streaming");
+        releaseVideoSources(video_sources);
         return 1;
     }
 
-    std::cout << "\n=== Streaming Started ===" << std::endl;
-    std::cout << "Press Ctrl+C to stop...\n" << std::endl;
+    // 配置热加载：与上次加载的文件比较，能在线生效的直接应用，其余提示需要重启
+    std::unique_ptr<ConfigWatcher> config_watcher;
+    if (config.hot_reload && config_loaded) {
+        ConfigParser loaded_config = config_parser;
+        config_watcher = std::make_unique<ConfigWatcher>(config_file, [&, loaded_config]() mutable {
+            ConfigParser reloaded;
+            if (!reloaded.loadFromFile(config_file)) {
+                LOG_WARN("⚠️  Config reload failed, keeping current settings");
+                return;
+            }
+            AppConfig& next = reloaded.getConfig();
+            bool reload_bench_mode = false;
+            EncodeBenchmarkOptions reload_bench_options;
+            if (!applyCommandLine(argc, argv, next, reload_bench_mode, reload_bench_options) ||
+                !applyLatencyProfile(next)) {
+                LOG_WARN("⚠️  Config reload failed, keeping current settings");
+                return;
+            }
+            
+            // 只报告实际生效的修改：命令行和两次都启用的延迟模式覆盖的字段在文件里改了也不变
+            std::vector<std::string> pinned = commandLineFields(argc, argv);
+            if (loaded_config.getConfig().latency_mode == next.latency_mode) {
+                std::vector<std::string> profile = latencyProfileFields(next.latency_mode);
+                pinned.insert(pinned.end(), profile.begin(), profile.end());
+            }
+            std::vector<std::string> changed = loaded_config.changedFields(reloaded);
+            changed.erase(std::remove_if(changed.begin(), changed.end(), [&](const std::string& field) {
+                return std::find(pinned.begin(), pinned.end(), field) != pinned.end();
+            }), changed.end());
+            if (changed.empty()) {
+                loaded_config = reloaded;
+                return;
+            }
+            
+            std::vector<std::string> restart = webrtc_client->applyConfig(next, changed);
+            for (const auto& field : changed) {
+                if (std::find(restart.begin(), restart.end(), field) == restart.end()) {
+                    LOG_INFO("🔄 Applied " << field);
+                }
+            }
+            for (const auto& field : restart) {
+                LOG_WARN("⚠️  " << field << " changed, restart required to apply");
+            }
+            loaded_config = reloaded;
+        });
+        if (!config_watcher->start()) {
+            config_watcher.reset();
+        }
+    }
+
+    LOG_INFO("=== Streaming Started ===");
+    LOG_INFO("Press Ctrl+C to stop...");
 
     // Main loop
     while (g_running && webrtc_client->isStreaming()) {
         std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        
+        if (g_dump_trace.exchange(false)) {
+            dumpLatencyTrace(config.tracing);
+        }
     }
 
     // Cleanup
-    std::cout << "\nCleaning up..." << std::endl;
+    LOG_INFO("Cleaning up...");
+    config_watcher.reset();
     webrtc_client->stop();
-    video_source->release();
+    releaseVideoSources(video_sources);
+    
+    if (config.tracing.enabled) {
+        dumpLatencyTrace(config.tracing);
+    }
 
-    std::cout << "Shutdown complete." << std::endl;
+    LOG_INFO("Shutdown complete.");
+    Logger::instance().flush();
     return 0;
 }
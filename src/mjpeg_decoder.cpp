@@ -0,0 +1,144 @@
+#include "mjpeg_decoder.h"
+#include "logger.h"
+#include <libyuv/convert.h>
+#include <opencv2/opencv.hpp>
+#include <cstring>
+
+#ifdef ENABLE_TURBOJPEG
+#include <turbojpeg.h>
+#endif
+
+MjpegDecoder::MjpegDecoder()
+    : handle_(nullptr), target_width_(0), target_height_(0) {
+#ifdef ENABLE_TURBOJPEG
+    handle_ = tjInitDecompress();
+    if (!handle_) {
+        LOG_ERROR("❌ tjInitDecompress failed: " << tjGetErrorStr());
+    }
+#endif
+}
+
+MjpegDecoder::~MjpegDecoder() {
+#ifdef ENABLE_TURBOJPEG
+    if (handle_) {
+        tjDestroy(static_cast<tjhandle>(handle_));
+    }
+#endif
+}
+
+void MjpegDecoder::setTargetResolution(int width, int height) {
+    target_width_ = width > 0 ? width : 0;
+    target_height_ = height > 0 ? height : 0;
+}
+
+rtc::scoped_refptr<webrtc::I420Buffer> MjpegDecoder::decode(const uint8_t* data, size_t size,
+                                                            webrtc::VideoFrameBufferPool& pool) {
+#ifdef ENABLE_TURBOJPEG
+    if (handle_) {
+        tjhandle tj = static_cast<tjhandle>(handle_);
+        int width = 0;
+        int height = 0;
+        int subsamp = 0;
+        int colorspace = 0;
+        if (tjDecompressHeader3(tj, data, size, &width, &height, &subsamp, &colorspace) != 0) {
+            LOG_EVERY_MS(LogLevel::kWarn, 1000, "⚠️  Invalid MJPEG frame: " << tjGetErrorStr2(tj));
+            return nullptr;
+        }
+
+        // 选择不小于目标分辨率的最小 DCT 缩放比例（不放大）
+        int scaled_width = width;
+        int scaled_height = height;
+        if (target_width_ > 0 && target_height_ > 0) {
+            int num_factors = 0;
+            tjscalingfactor* factors = tjGetScalingFactors(&num_factors);
+            for (int i = 0; i < num_factors; i++) {
+                if (factors[i].num > factors[i].denom) {
+                    continue;
+                }
+                int w = TJSCALED(width, factors[i]);
+                int h = TJSCALED(height, factors[i]);
+                if (w >= target_width_ && h >= target_height_ && w * h < scaled_width * scaled_height) {
+                    scaled_width = w;
+                    scaled_height = h;
+                }
+            }
+        }
+
+        if (subsamp == TJSAMP_420 || subsamp == TJSAMP_422 || subsamp == TJSAMP_444 ||
+            subsamp == TJSAMP_GRAY) {
+            rtc::scoped_refptr<webrtc::I420Buffer> buffer = pool.CreateI420Buffer(scaled_width, scaled_height);
+            if (!buffer) {
+                return nullptr;
+            }
+
+            const int flags = TJFLAG_FASTDCT;
+            int ret = 0;
+            if (subsamp == TJSAMP_420) {
+                // 4:2:0 直接解码到 I420 平面
+                unsigned char* planes[3] = {
+                    buffer->MutableDataY(), buffer->MutableDataU(), buffer->MutableDataV()
+                };
+                int strides[3] = {buffer->StrideY(), buffer->StrideU(), buffer->StrideV()};
+                ret = tjDecompressToYUVPlanes(tj, data, size, planes, scaled_width, strides,
+                                              scaled_height, flags);
+            } else if (subsamp == TJSAMP_GRAY) {
+                unsigned char* planes[3] = {buffer->MutableDataY(), nullptr, nullptr};
+                int strides[3] = {buffer->StrideY(), 0, 0};
+                ret = tjDecompressToYUVPlanes(tj, data, size, planes, scaled_width, strides,
+                                              scaled_height, flags);
+                memset(buffer->MutableDataU(), 128, buffer->StrideU() * buffer->ChromaHeight());
+                memset(buffer->MutableDataV(), 128, buffer->StrideV() * buffer->ChromaHeight());
+            } else {
+                // 4:2:2 / 4:4:4：Y 直接写入，色度解码到中间平面后由 libyuv 下采样
+                const int chroma_width = tjPlaneWidth(1, scaled_width, subsamp);
+                const int chroma_height = tjPlaneHeight(1, scaled_height, subsamp);
+                chroma_.resize(static_cast<size_t>(chroma_width) * chroma_height * 2);
+                uint8_t* u = chroma_.data();
+                uint8_t* v = u + static_cast<size_t>(chroma_width) * chroma_height;
+                unsigned char* planes[3] = {buffer->MutableDataY(), u, v};
+                int strides[3] = {buffer->StrideY(), chroma_width, chroma_width};
+                ret = tjDecompressToYUVPlanes(tj, data, size, planes, scaled_width, strides,
+                                              scaled_height, flags);
+                if (ret == 0 && subsamp == TJSAMP_422) {
+                    libyuv::I422ToI420(buffer->DataY(), buffer->StrideY(), u, chroma_width, v, chroma_width,
+                                       buffer->MutableDataY(), buffer->StrideY(),
+                                       buffer->MutableDataU(), buffer->StrideU(),
+                                       buffer->MutableDataV(), buffer->StrideV(),
+                                       scaled_width, scaled_height);
+                } else if (ret == 0) {
+                    libyuv::I444ToI420(buffer->DataY(), buffer->StrideY(), u, chroma_width, v, chroma_width,
+                                       buffer->MutableDataY(), buffer->StrideY(),
+                                       buffer->MutableDataU(), buffer->StrideU(),
+                                       buffer->MutableDataV(), buffer->StrideV(),
+                                       scaled_width, scaled_height);
+                }
+            }
+
+            // 截断的 JPEG 会产生警告但仍有可用图像，只有致命错误才丢帧
+            if (ret != 0 && tjGetErrorCode(tj) == TJERR_FATAL) {
+                LOG_EVERY_MS(LogLevel::kWarn, 1000, "⚠️  MJPEG decode failed: " << tjGetErrorStr2(tj));
+                return nullptr;
+            }
+            return buffer;
+        }
+        // 其它采样格式（4:4:0、4:1:1）走下面的通用路径
+    }
+#endif
+
+    cv::Mat bgr = cv::imdecode(cv::Mat(1, static_cast<int>(size), CV_8UC1, const_cast<uint8_t*>(data)),
+                               cv::IMREAD_COLOR);
+    if (bgr.empty()) {
+        LOG_EVERY_MS(LogLevel::kWarn, 1000, "⚠️  Failed to decode MJPEG frame (" << size << " bytes)");
+        return nullptr;
+    }
+    rtc::scoped_refptr<webrtc::I420Buffer> buffer = pool.CreateI420Buffer(bgr.cols, bgr.rows);
+    if (!buffer) {
+        return nullptr;
+    }
+    libyuv::RGB24ToI420(bgr.data, static_cast<int>(bgr.step),
+                        buffer->MutableDataY(), buffer->StrideY(),
+                        buffer->MutableDataU(), buffer->StrideU(),
+                        buffer->MutableDataV(), buffer->StrideV(),
+                        bgr.cols, bgr.rows);
+    return buffer;
+}
@@ -0,0 +1,291 @@
+#include "mosaic_source.h"
+#include "custom_video_source.h"
+#include "logger.h"
+#include <libyuv/planar_functions.h>
+#include <libyuv/scale.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// 每路缓冲：解码/转换 1 帧 + 缩放结果（最新 1 帧 + 正在生成 1 帧）
+constexpr size_t kSourceBuffers = 2;
+constexpr size_t kScaledBuffers = 3;
+
+// 画中画小窗与画布边缘的间距
+constexpr int kPipMargin = 16;
+
+// I420 色度平面按 2x2 采样，区域必须对齐到偶数
+inline int even(int value) {
+    return value & ~1;
+}
+
+cv::Rect evenRect(int x, int y, int width, int height) {
+    return cv::Rect(even(x), even(y), even(width), even(height));
+}
+
+} // namespace
+
+MosaicSource::MosaicSource(std::vector<std::shared_ptr<VideoSource>> inputs, const MosaicConfig& config)
+    : inputs_(std::move(inputs)), config_(config),
+      width_(even(config.width)), height_(even(config.height)),
+      fps_(config.fps > 0 ? config.fps : 30),
+      is_initialized_(false), should_stop_(false) {
+}
+
+MosaicSource::~MosaicSource() {
+    release();
+}
+
+std::vector<cv::Rect> MosaicSource::computeLayout(const MosaicConfig& config, size_t count) {
+    std::vector<cv::Rect> rects;
+    const int width = even(config.width);
+    const int height = even(config.height);
+    if (count == 0 || width <= 0 || height <= 0) {
+        return rects;
+    }
+
+    if (config.layout == "grid") {
+        const int cols = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(count))));
+        const int rows = (static_cast<int>(count) + cols - 1) / cols;
+        const int tile_width = width / cols;
+        const int tile_height = height / rows;
+        for (size_t i = 0; i < count; i++) {
+            int col = static_cast<int>(i) % cols;
+            int row = static_cast<int>(i) / cols;
+            rects.push_back(evenRect(col * tile_width, row * tile_height, tile_width, tile_height));
+        }
+    } else if (config.layout == "pip") {
+        rects.push_back(cv::Rect(0, 0, width, height));
+        const int inset_width = even(width / 4);
+        const int inset_height = even(height / 4);
+        for (size_t i = 1; i < count; i++) {
+            int x = width - static_cast<int>(i) * (inset_width + kPipMargin);
+            if (x < 0) {
+                return {};
+            }
+            rects.push_back(evenRect(x, height - inset_height - kPipMargin, inset_width, inset_height));
+        }
+    } else if (config.layout == "custom") {
+        if (config.tiles.size() < count) {
+            return {};
+        }
+        const cv::Rect canvas(0, 0, width, height);
+        for (size_t i = 0; i < count; i++) {
+            const MosaicTile& tile = config.tiles[i];
+            cv::Rect rect = evenRect(tile.x, tile.y, tile.width, tile.height) & canvas;
+            if (rect.width < 2 || rect.height < 2) {
+                return {};
+            }
+            rects.push_back(evenRect(rect.x, rect.y, rect.width, rect.height));
+        }
+    }
+    return rects;
+}
+
+bool MosaicSource::initialize() {
+    if (is_initialized_) {
+        return true;
+    }
+
+    std::vector<cv::Rect> rects = computeLayout(config_, inputs_.size());
+    if (rects.empty()) {
+        LOG_ERROR("Invalid mosaic layout '" << config_.layout << "' for " << inputs_.size()
+                  << " sources on a " << width_ << "x" << height_ << " canvas");
+        return false;
+    }
+
+    // 黑色背景：Y = 16，U = V = 128
+    canvas_.create(height_ * 3 / 2, width_, CV_8UC1);
+    memset(canvas_.data, 16, static_cast<size_t>(width_) * height_);
+    memset(canvas_.data + static_cast<size_t>(width_) * height_, 128,
+           static_cast<size_t>(width_) * height_ / 2);
+
+    should_stop_ = false;
+    for (size_t i = 0; i < inputs_.size(); i++) {
+        auto tile = std::make_unique<Tile>();
+        tile->source = inputs_[i];
+        tile->rect = rects[i];
+        tile->source_pool = std::make_unique<webrtc::VideoFrameBufferPool>(false, kSourceBuffers);
+        tile->scaled_pool = std::make_unique<webrtc::VideoFrameBufferPool>(false, kScaledBuffers);
+        // MJPEG 直接以接近小窗尺寸的 DCT 缩放解码
+        tile->mjpeg_decoder.setTargetResolution(tile->rect.width, tile->rect.height);
+        tiles_.push_back(std::move(tile));
+    }
+    for (auto& tile : tiles_) {
+        tile->thread = std::thread(&MosaicSource::captureThread, this, tile.get());
+    }
+
+    is_initialized_ = true;
+    LOG_INFO("✅ Mosaic: " << inputs_.size() << " sources → " << width_ << "x" << height_
+             << " @ " << fps_ << " fps (" << config_.layout << ")");
+    return true;
+}
+
+void MosaicSource::captureThread(Tile* tile) {
+    VideoSource* source = tile->source.get();
+    int fps = source->getFrameRate() > 0 ? source->getFrameRate() : 30;
+    auto frame_duration = std::chrono::microseconds(1000000 / fps);
+    auto next_frame_time = std::chrono::steady_clock::now();
+
+    FrameLease lease;
+    while (!should_stop_) {
+        if (source->acquireFrame(lease) && lease.valid()) {
+            scaleToTile(tile, lease.image(), lease.format());
+            lease.reset();
+        }
+
+        if (source->isSelfPaced()) {
+            continue;
+        }
+        next_frame_time += frame_duration;
+        std::this_thread::sleep_until(next_frame_time);
+    }
+}
+
+bool MosaicSource::scaleToTile(Tile* tile, const cv::Mat& frame, PixelFormat format) {
+    int src_width = frame.cols;
+    int src_height = pixelFormatHeight(format, frame.rows);
+    const uint8_t* src_y = nullptr;
+    const uint8_t* src_u = nullptr;
+    const uint8_t* src_v = nullptr;
+    int stride_y = 0;
+    int stride_uv = 0;
+
+    CustomVideoSource::I420Planes planes;
+    rtc::scoped_refptr<webrtc::I420Buffer> source_buffer;
+    if (format == PixelFormat::kMJPEG) {
+        source_buffer = tile->mjpeg_decoder.decode(frame.data, frame.total() * frame.elemSize(),
+                                                   *tile->source_pool);
+    } else if (format == PixelFormat::kI420 && CustomVideoSource::i420Planes(frame, &planes)) {
+        // 已经是 I420：直接从 Mat 的平面缩放，省去一次拷贝
+        src_y = planes.y;
+        src_u = planes.u;
+        src_v = planes.v;
+        stride_y = planes.stride_y;
+        stride_uv = planes.stride_uv;
+    } else {
+        source_buffer = tile->source_pool->CreateI420Buffer(src_width, src_height);
+        if (source_buffer && !CustomVideoSource::convertToI420(frame, format, source_buffer.get())) {
+            source_buffer = nullptr;
+        }
+    }
+    if (source_buffer) {
+        src_y = source_buffer->DataY();
+        src_u = source_buffer->DataU();
+        src_v = source_buffer->DataV();
+        stride_y = source_buffer->StrideY();
+        stride_uv = source_buffer->StrideU();
+        src_width = source_buffer->width();
+        src_height = source_buffer->height();
+    }
+    if (!src_y || src_width <= 0 || src_height <= 0) {
+        return false;
+    }
+
+    cv::Rect placement = tile->rect;
+    if (config_.keep_aspect) {
+        double scale = std::min(static_cast<double>(tile->rect.width) / src_width,
+                                static_cast<double>(tile->rect.height) / src_height);
+        int width = std::max(2, even(static_cast<int>(src_width * scale)));
+        int height = std::max(2, even(static_cast<int>(src_height * scale)));
+        placement = cv::Rect(tile->rect.x + even((tile->rect.width - width) / 2),
+                             tile->rect.y + even((tile->rect.height - height) / 2),
+                             width, height);
+    }
+
+    rtc::scoped_refptr<webrtc::I420Buffer> scaled =
+        tile->scaled_pool->CreateI420Buffer(placement.width, placement.height);
+    if (!scaled) {
+        return false;
+    }
+    libyuv::I420Scale(src_y, stride_y, src_u, stride_uv, src_v, stride_uv,
+                      src_width, src_height,
+                      scaled->MutableDataY(), scaled->StrideY(),
+                      scaled->MutableDataU(), scaled->StrideU(),
+                      scaled->MutableDataV(), scaled->StrideV(),
+                      placement.width, placement.height,
+                      libyuv::kFilterBox);
+
+    std::lock_guard<std::mutex> lock(tile->mutex);
+    tile->latest = scaled;
+    tile->placement = placement;
+    tile->dirty = true;
+    return true;
+}
+
+void MosaicSource::blitTile(Tile* tile) {
+    const int chroma_stride = width_ / 2;
+    uint8_t* y = canvas_.data;
+    uint8_t* u = y + static_cast<size_t>(width_) * height_;
+    uint8_t* v = u + static_cast<size_t>(chroma_stride) * (height_ / 2);
+
+    // 保持宽高比时源图不一定填满小窗，先清成黑边
+    const cv::Rect& rect = tile->rect;
+    if (tile->placement != rect) {
+        libyuv::SetPlane(y + rect.y * width_ + rect.x, width_, rect.width, rect.height, 16);
+        libyuv::SetPlane(u + (rect.y / 2) * chroma_stride + rect.x / 2, chroma_stride,
+                         rect.width / 2, rect.height / 2, 128);
+        libyuv::SetPlane(v + (rect.y / 2) * chroma_stride + rect.x / 2, chroma_stride,
+                         rect.width / 2, rect.height / 2, 128);
+    }
+
+    const cv::Rect& p = tile->placement;
+    const webrtc::I420Buffer* buffer = tile->latest.get();
+    libyuv::I420Copy(buffer->DataY(), buffer->StrideY(),
+                     buffer->DataU(), buffer->StrideU(),
+                     buffer->DataV(), buffer->StrideV(),
+                     y + p.y * width_ + p.x, width_,
+                     u + (p.y / 2) * chroma_stride + p.x / 2, chroma_stride,
+                     v + (p.y / 2) * chroma_stride + p.x / 2, chroma_stride,
+                     p.width, p.height);
+}
+
+bool MosaicSource::getFrame(cv::Mat& frame) {
+    if (!is_initialized_) {
+        return false;
+    }
+
+    // 只重绘有新帧的小窗，以及叠在已重绘区域之上的小窗（画中画）
+    std::vector<cv::Rect> redrawn;
+    for (auto& tile : tiles_) {
+        std::lock_guard<std::mutex> lock(tile->mutex);
+        if (!tile->latest) {
+            continue;
+        }
+        bool covered = std::any_of(redrawn.begin(), redrawn.end(), [&](const cv::Rect& rect) {
+            return (rect & tile->rect).area() > 0;
+        });
+        if (tile->dirty || covered) {
+            blitTile(tile.get());
+            tile->dirty = false;
+            redrawn.push_back(tile->rect);
+        }
+    }
+
+    // 调用方会在输出帧上叠加时间戳，必须拷贝而不是共享画布
+    canvas_.copyTo(frame);
+    return true;
+}
+
+void MosaicSource::release() {
+    should_stop_ = true;
+    for (auto& tile : tiles_) {
+        if (tile->thread.joinable()) {
+            tile->thread.join();
+        }
+    }
+    tiles_.clear();
+
+    for (auto& input : inputs_) {
+        input->release();
+    }
+    inputs_.clear();
+    is_initialized_ = false;
+}
+
+std::string MosaicSource::getName() const {
+    return "Mosaic (" + std::to_string(inputs_.size()) + " sources, " + config_.layout + ")";
+}
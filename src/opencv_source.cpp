@@ -1,14 +1,23 @@
 #include "opencv_source.h"
-#include <iostream>
+#include "logger.h"
 
 OpenCVSource::OpenCVSource(int device_id, int width, int height, int fps)
     : device_id_(device_id), width_(width), height_(height), fps_(fps),
-      is_camera_(true), is_initialized_(false) {
+      is_camera_(true), is_initialized_(false), latest_frame_only_(false) {
 }
 
 OpenCVSource::OpenCVSource(const std::string& source_path, int fps)
     : device_id_(-1), source_path_(source_path), fps_(fps),
-      is_camera_(false), is_initialized_(false), width_(0), height_(0) {
+      is_camera_(false), is_initialized_(false), latest_frame_only_(false), width_(0), height_(0) {
+}
+
+bool OpenCVSource::setLatestFrameOnly(bool enable) {
+    // 文件/RTSP 按帧率回放，没有积压可跳过
+    if (!is_camera_) {
+        return false;
+    }
+    latest_frame_only_ = enable;
+    return true;
 }
 
 OpenCVSource::~OpenCVSource() {
@@ -21,7 +30,7 @@ bool OpenCVSource::initialize() {
             // Open camera device
             capture_.open(device_id_);
             if (!capture_.isOpened()) {
-                std::cerr << "Failed to open camera device " << device_id_ << std::endl;
+                LOG_ERROR("Failed to open camera device " << device_id_);
                 return false;
             }
             
@@ -29,18 +38,21 @@ bool OpenCVSource::initialize() {
             capture_.set(cv::CAP_PROP_FRAME_WIDTH, width_);
             capture_.set(cv::CAP_PROP_FRAME_HEIGHT, height_);
             capture_.set(cv::CAP_PROP_FPS, fps_);
+            if (latest_frame_only_ && !capture_.set(cv::CAP_PROP_BUFFERSIZE, 1)) {
+                LOG_WARN("⚠️  Camera " << device_id_ << " backend ignores CAP_PROP_BUFFERSIZE");
+            }
             
             // Get actual properties (may differ from requested)
             width_ = static_cast<int>(capture_.get(cv::CAP_PROP_FRAME_WIDTH));
             height_ = static_cast<int>(capture_.get(cv::CAP_PROP_FRAME_HEIGHT));
             fps_ = static_cast<int>(capture_.get(cv::CAP_PROP_FPS));
             
-            std::cout << "Camera " << device_id_ << " opened successfully" << std::endl;
+            LOG_INFO("Camera " << device_id_ << " opened successfully");
         } else {
             // Open video file or stream
             capture_.open(source_path_);
             if (!capture_.isOpened()) {
-                std::cerr << "Failed to open video source: " << source_path_ << std::endl;
+                LOG_ERROR("Failed to open video source: " << source_path_);
                 return false;
             }
             
@@ -51,44 +63,67 @@ bool OpenCVSource::initialize() {
                 fps_ = static_cast<int>(capture_.get(cv::CAP_PROP_FPS));
             }
             
-            std::cout << "Video source opened successfully: " << source_path_ << std::endl;
+            LOG_INFO("Video source opened successfully: " << source_path_);
         }
         
-        std::cout << "Resolution: " << width_ << "x" << height_ << " @ " << fps_ << " fps" << std::endl;
+        LOG_INFO("Resolution: " << width_ << "x" << height_ << " @ " << fps_ << " fps");
         
         is_initialized_ = true;
         return true;
     } catch (const std::exception& e) {
-        std::cerr << "Exception in OpenCVSource::initialize: " << e.what() << std::endl;
+        LOG_ERROR("Exception in OpenCVSource::initialize: " << e.what());
         is_initialized_ = false;
         return false;
     }
 }
 
-bool OpenCVSource::getFrame(cv::Mat& frame) {
+bool OpenCVSource::acquireFrame(FrameLease& lease) {
+    lease.reset();
     if (!is_initialized_ || !capture_.isOpened()) {
         return false;
     }
 
+    int slot = -1;
+    for (int i = 0; i < kFramePoolSize; i++) {
+        bool expected = false;
+        if (frame_leased_[i].compare_exchange_strong(expected, true)) {
+            slot = i;
+            break;
+        }
+    }
+    if (slot < 0) {
+        LOG_EVERY_MS(LogLevel::kWarn, 1000, "⚠️  All " << kFramePoolSize << " OpenCV frame buffers are leased");
+        return false;
+    }
+
     std::lock_guard<std::mutex> lock(frame_mutex_);
-    
-    if (!capture_.read(frame)) {
-        std::cerr << "Failed to read frame" << std::endl;
+    cv::Mat& buffer = frame_pool_[slot];
+    if (!capture_.read(buffer)) {
+        frame_leased_[slot] = false;
+        LOG_EVERY_MS(LogLevel::kError, 1000, "Failed to read frame");
         return false;
     }
-    
-    if (frame.empty()) {
+
+    if (buffer.empty()) {
+        frame_leased_[slot] = false;
         return false;
     }
-    
+
+    lend(lease, buffer, PixelFormat::kBGR, 0, slot);
     return true;
 }
 
+void OpenCVSource::releaseFrame(int buffer_index) {
+    if (buffer_index >= 0 && buffer_index < kFramePoolSize) {
+        frame_leased_[buffer_index].store(false, std::memory_order_release);
+    }
+}
+
 void OpenCVSource::release() {
     if (is_initialized_ && capture_.isOpened()) {
         capture_.release();
         is_initialized_ = false;
-        std::cout << "Video source released" << std::endl;
+        LOG_INFO("Video source released");
     }
 }
 
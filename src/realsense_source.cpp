@@ -1,11 +1,31 @@
 #ifdef ENABLE_REALSENSE
 
 #include "realsense_source.h"
-#include <iostream>
+#include "latency_tracer.h"
+#include "logger.h"
+#include <cmath>
+
+namespace {
+
+// 设备不提供该元数据时返回 -1
+int64_t readMetadata(const rs2::frame& frame, rs2_frame_metadata_value key) {
+    if (!frame || !frame.supports_frame_metadata(key)) {
+        return -1;
+    }
+    return frame.get_frame_metadata(key);
+}
+
+}  // namespace
 
 RealSenseSource::RealSenseSource(int width, int height, int fps, bool enable_depth)
     : width_(width), height_(height), fps_(fps), enable_depth_(enable_depth),
-      is_initialized_(false) {
+      is_initialized_(false), imu_started_(false), latest_frame_only_(false),
+      last_capture_time_us_(0) {
+}
+
+bool RealSenseSource::setLatestFrameOnly(bool enable) {
+    latest_frame_only_ = enable;
+    return true;
 }
 
 RealSenseSource::~RealSenseSource() {
@@ -23,7 +43,20 @@ bool RealSenseSource::initialize() {
         }
 
         // Start the pipeline
-        pipe_.start(cfg_);
+        rs2::pipeline_profile profile = pipe_.start(cfg_);
+        rs2::device device = profile.get_device();
+        serial_ = device.get_info(RS2_CAMERA_INFO_SERIAL_NUMBER);
+        
+        // 全局时间域：设备时间戳换算到主机时钟，视频与 IMU 可比
+        for (rs2::sensor& sensor : device.query_sensors()) {
+            if (sensor.supports(RS2_OPTION_GLOBAL_TIME_ENABLED)) {
+                sensor.set_option(RS2_OPTION_GLOBAL_TIME_ENABLED, 1.f);
+            }
+            // 传感器内部帧队列只留一帧，来不及处理的旧帧在设备侧丢弃
+            if (latest_frame_only_ && sensor.supports(RS2_OPTION_FRAMES_QUEUE_SIZE)) {
+                sensor.set_option(RS2_OPTION_FRAMES_QUEUE_SIZE, 1.f);
+            }
+        }
         
         // Wait for first frames to stabilize
         for (int i = 0; i < 30; i++) {
@@ -31,84 +64,200 @@ bool RealSenseSource::initialize() {
         }
         
         is_initialized_ = true;
-        std::cout << "RealSense camera initialized successfully" << std::endl;
-        std::cout << "Resolution: " << width_ << "x" << height_ << " @ " << fps_ << " fps" << std::endl;
+        LOG_INFO("RealSense camera initialized successfully");
+        LOG_INFO("Resolution: " << width_ << "x" << height_ << " @ " << fps_ << " fps");
         
         return true;
     } catch (const rs2::error& e) {
-        std::cerr << "RealSense error: " << e.what() << std::endl;
+        LOG_ERROR("RealSense error: " << e.what());
         is_initialized_ = false;
         return false;
     } catch (const std::exception& e) {
-        std::cerr << "Exception: " << e.what() << std::endl;
+        LOG_ERROR("Exception: " << e.what());
         is_initialized_ = false;
         return false;
     }
 }
 
-bool RealSenseSource::getFrame(cv::Mat& frame) {
+bool RealSenseSource::acquireFrame(FrameLease& lease) {
+    lease.reset();
     if (!is_initialized_) {
         return false;
     }
 
     try {
         rs2::frameset frames = pipe_.wait_for_frames();
-        rs2::frame color_frame = frames.get_color_frame();
+        if (latest_frame_only_) {
+            // pipeline 自身也有队列，已有更新的帧时丢弃旧帧
+            rs2::frameset newer;
+            while (pipe_.poll_for_frames(&newer)) {
+                frames = newer;
+            }
+        }
+        rs2::video_frame color_frame = frames.get_color_frame();
         
         if (!color_frame) {
             return false;
         }
-
-        // Create OpenCV Mat from RealSense frame
-        const int w = color_frame.as<rs2::video_frame>().get_width();
-        const int h = color_frame.as<rs2::video_frame>().get_height();
-        
-        cv::Mat temp(cv::Size(w, h), CV_8UC3, (void*)color_frame.get_data(), cv::Mat::AUTO_STEP);
         
-        std::lock_guard<std::mutex> lock(frame_mutex_);
-        frame = temp.clone();
-        last_color_frame_ = frame.clone();
-        
-        // Handle depth if enabled
+        const int64_t device_us = std::llround(color_frame.get_timestamp() * 1000.0);
+        last_capture_time_us_ = clock_.toMonotonicUs(device_us, LatencyTracer::nowUs());
+        if (telemetry_ && telemetry_->config().metadata) {
+            publishMetadata(color_frame, enable_depth_ ? frames.get_depth_frame() : rs2::frame(),
+                            last_capture_time_us_);
+        }
+
+        // 深度帧只保留引用，getDepthFrame() 被调用时才着色和拷贝
         if (enable_depth_) {
             rs2::frame depth = frames.get_depth_frame();
             if (depth) {
-                rs2::frame colored_depth = color_map_.colorize(depth);
-                cv::Mat depth_mat(cv::Size(w, h), CV_8UC3, 
-                                (void*)colored_depth.get_data(), cv::Mat::AUTO_STEP);
-                last_depth_frame_ = depth_mat.clone();
+                std::lock_guard<std::mutex> lock(frame_mutex_);
+                last_depth_frame_ = depth;
             }
         }
-        
+
+        int slot = -1;
+        for (int i = 0; i < kFramePoolSize; i++) {
+            bool expected = false;
+            if (frame_leased_[i].compare_exchange_strong(expected, true)) {
+                slot = i;
+                break;
+            }
+        }
+        if (slot < 0) {
+            LOG_EVERY_MS(LogLevel::kWarn, 1000, "⚠️  All " << kFramePoolSize << " RealSense frames are leased");
+            return false;
+        }
+
+        // 持有 rs2::frame 引用，Mat 直接指向 librealsense 的帧缓冲区，不拷贝。
+        // 缓冲区可能与其他帧消费者共享，只通过 FrameLease::image() 的 const 接口读取
+        leased_frames_[slot] = color_frame;
+        cv::Mat image(color_frame.get_height(), color_frame.get_width(), CV_8UC3,
+                      const_cast<void*>(color_frame.get_data()),
+                      static_cast<size_t>(color_frame.get_stride_in_bytes()));
+        lend(lease, image, PixelFormat::kBGR, last_capture_time_us_, slot);
         return true;
     } catch (const rs2::error& e) {
-        std::cerr << "RealSense error in getFrame: " << e.what() << std::endl;
+        LOG_EVERY_MS(LogLevel::kError, 1000, "RealSense error in acquireFrame: " << e.what());
         return false;
     }
 }
 
+void RealSenseSource::releaseFrame(int buffer_index) {
+    if (buffer_index >= 0 && buffer_index < kFramePoolSize) {
+        // 放掉引用，帧回到 librealsense 的帧池
+        leased_frames_[buffer_index] = rs2::frame();
+        frame_leased_[buffer_index].store(false, std::memory_order_release);
+    }
+}
+
 bool RealSenseSource::getDepthFrame(cv::Mat& depth_frame) {
     if (!is_initialized_ || !enable_depth_) {
         return false;
     }
     
     std::lock_guard<std::mutex> lock(frame_mutex_);
-    if (last_depth_frame_.empty()) {
+    if (!last_depth_frame_) {
         return false;
     }
     
-    depth_frame = last_depth_frame_.clone();
+    try {
+        rs2::video_frame colored_depth = color_map_.colorize(last_depth_frame_);
+        cv::Mat depth_mat(colored_depth.get_height(), colored_depth.get_width(), CV_8UC3,
+                          const_cast<void*>(colored_depth.get_data()),
+                          static_cast<size_t>(colored_depth.get_stride_in_bytes()));
+        depth_frame = depth_mat.clone();
+    } catch (const rs2::error& e) {
+        LOG_ERROR("RealSense error in getDepthFrame: " << e.what());
+        return false;
+    }
     return true;
 }
 
+bool RealSenseSource::attachTelemetry(std::shared_ptr<SensorTelemetry> telemetry) {
+    if (!is_initialized_) {
+        return false;
+    }
+    stopImu();
+    telemetry_ = telemetry;
+    if (telemetry && telemetry->config().imu && !startImu(telemetry)) {
+        LOG_WARN("⚠️  RealSense IMU unavailable, sending frame metadata only");
+    }
+    return telemetry != nullptr;
+}
+
+bool RealSenseSource::startImu(std::shared_ptr<SensorTelemetry> telemetry) {
+    try {
+        // 运动模块单独一条 pipeline，回调在 librealsense 线程中直接入批，不经过采集循环
+        rs2::config imu_cfg;
+        imu_cfg.enable_device(serial_);
+        imu_cfg.enable_stream(RS2_STREAM_ACCEL, RS2_FORMAT_MOTION_XYZ32F, telemetry->config().accel_fps);
+        imu_cfg.enable_stream(RS2_STREAM_GYRO, RS2_FORMAT_MOTION_XYZ32F, telemetry->config().gyro_fps);
+        
+        imu_pipe_.start(imu_cfg, [this, telemetry](const rs2::frame& frame) {
+            rs2::motion_frame motion = frame.as<rs2::motion_frame>();
+            if (!motion) {
+                return;
+            }
+            const int64_t device_us = std::llround(motion.get_timestamp() * 1000.0);
+            rs2_vector data = motion.get_motion_data();
+            
+            ImuSample sample;
+            sample.timestamp_us = clock_.toMonotonicUs(device_us, LatencyTracer::nowUs());
+            sample.type = motion.get_profile().stream_type() == RS2_STREAM_GYRO
+                ? ImuSample::kGyro : ImuSample::kAccel;
+            sample.x = data.x;
+            sample.y = data.y;
+            sample.z = data.z;
+            telemetry->addImu(sample);
+        });
+        imu_started_ = true;
+        LOG_INFO("RealSense IMU started (accel " << telemetry->config().accel_fps
+                 << " Hz, gyro " << telemetry->config().gyro_fps << " Hz)");
+        return true;
+    } catch (const rs2::error& e) {
+        LOG_ERROR("RealSense IMU error: " << e.what());
+        return false;
+    }
+}
+
+void RealSenseSource::stopImu() {
+    if (!imu_started_) {
+        return;
+    }
+    try {
+        imu_pipe_.stop();
+    } catch (const rs2::error& e) {
+        LOG_ERROR("Error stopping RealSense IMU: " << e.what());
+    }
+    imu_started_ = false;
+}
+
+void RealSenseSource::publishMetadata(const rs2::frame& color, const rs2::frame& depth,
+                                      int64_t capture_us) {
+    FrameMetadataSample sample;
+    sample.timestamp_us = capture_us;
+    sample.frame_number = static_cast<uint32_t>(color.get_frame_number());
+    sample.exposure_us = static_cast<int32_t>(readMetadata(color, RS2_FRAME_METADATA_ACTUAL_EXPOSURE));
+    sample.gain = static_cast<int32_t>(readMetadata(color, RS2_FRAME_METADATA_GAIN_LEVEL));
+    // 激光（投射器）功率只在深度帧上报告
+    sample.laser_power = static_cast<int32_t>(readMetadata(depth, RS2_FRAME_METADATA_FRAME_LASER_POWER));
+    sample.sensor_timestamp_us = readMetadata(color, RS2_FRAME_METADATA_SENSOR_TIMESTAMP);
+    telemetry_->addFrameMetadata(sample);
+}
+
 void RealSenseSource::release() {
+    stopImu();
+    telemetry_.reset();
     if (is_initialized_) {
         try {
             pipe_.stop();
             is_initialized_ = false;
-            std::cout << "RealSense camera released" << std::endl;
+            std::lock_guard<std::mutex> lock(frame_mutex_);
+            last_depth_frame_ = rs2::frame();
+            LOG_INFO("RealSense camera released");
         } catch (const std::exception& e) {
-            std::cerr << "Error releasing RealSense: " << e.what() << std::endl;
+            LOG_ERROR("Error releasing RealSense: " << e.what());
         }
     }
 }
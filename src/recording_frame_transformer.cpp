@@ -0,0 +1,63 @@
+#include "recording_frame_transformer.h"
+
+RecordingFrameTransformer::RecordingFrameTransformer(std::shared_ptr<EncodedRecorder> recorder,
+                                                     const std::string& codec)
+    : recorder_(recorder), codec_(codec) {
+}
+
+void RecordingFrameTransformer::setCodec(const std::string& codec) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    codec_ = codec;
+}
+
+void RecordingFrameTransformer::Transform(std::unique_ptr<webrtc::TransformableFrameInterface> frame) {
+    rtc::scoped_refptr<webrtc::TransformedFrameCallback> callback;
+    std::string codec;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = sink_callbacks_.find(frame->GetSsrc());
+        callback = it != sink_callbacks_.end() ? it->second : callback_;
+        codec = codec_;
+    }
+
+    // 发送端 transformer 只会收到视频帧
+    auto* video_frame = static_cast<webrtc::TransformableVideoFrameInterface*>(frame.get());
+    rtc::ArrayView<const uint8_t> data = frame->GetData();
+    const webrtc::VideoFrameMetadata metadata = video_frame->GetMetadata();
+
+    EncodedFramePacket packet;
+    packet.data.assign(data.begin(), data.end());
+    packet.rtp_timestamp = frame->GetTimestamp();
+    packet.key_frame = video_frame->IsKeyFrame();
+    packet.width = metadata.GetWidth();
+    packet.height = metadata.GetHeight();
+    packet.codec = codec;
+    recorder_->push(std::move(packet));
+
+    // 原样交还给打包器
+    if (callback) {
+        callback->OnTransformedFrame(std::move(frame));
+    }
+}
+
+void RecordingFrameTransformer::RegisterTransformedFrameCallback(
+    rtc::scoped_refptr<webrtc::TransformedFrameCallback> callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    callback_ = callback;
+}
+
+void RecordingFrameTransformer::RegisterTransformedFrameSinkCallback(
+    rtc::scoped_refptr<webrtc::TransformedFrameCallback> callback, uint32_t ssrc) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sink_callbacks_[ssrc] = callback;
+}
+
+void RecordingFrameTransformer::UnregisterTransformedFrameCallback() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    callback_ = nullptr;
+}
+
+void RecordingFrameTransformer::UnregisterTransformedFrameSinkCallback(uint32_t ssrc) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sink_callbacks_.erase(ssrc);
+}
@@ -0,0 +1,164 @@
+#include "sensor_telemetry.h"
+#include "logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace {
+
+// 按主机字节序写入（x86 / ARM 均为小端）
+template <typename T>
+void append(std::vector<uint8_t>& out, T value) {
+    uint8_t bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+}  // namespace
+
+int64_t SensorClockMapper::toMonotonicUs(int64_t device_us, int64_t arrival_us) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const int64_t offset = arrival_us - device_us;
+    if (!valid_ || offset < offset_us_) {
+        offset_us_ = offset;
+        valid_ = true;
+    } else {
+        // 下包络每秒最多上移 100 µs，跟随设备时钟漂移
+        offset_us_ = std::min(offset, offset_us_ + (arrival_us - last_arrival_us_) / 10000);
+    }
+    last_arrival_us_ = arrival_us;
+    return device_us + offset_us_;
+}
+
+SensorTelemetry::SensorTelemetry(const TelemetryConfig& config)
+    : config_(config), should_stop_(false), sent_packets_(0), sequence_(0) {
+}
+
+SensorTelemetry::~SensorTelemetry() {
+    stop();
+}
+
+bool SensorTelemetry::start(Sender sender) {
+    if (sender_thread_.joinable()) {
+        return true;
+    }
+    sender_ = std::move(sender);
+    should_stop_ = false;
+    sender_thread_ = std::thread(&SensorTelemetry::senderThread, this);
+    LOG_INFO("📡 Sensor telemetry started (" << config_.packet_rate_hz << " packets/s)");
+    return true;
+}
+
+void SensorTelemetry::stop() {
+    if (!sender_thread_.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        should_stop_ = true;
+    }
+    cv_.notify_one();
+    sender_thread_.join();
+    LOG_INFO("Sensor telemetry stopped (" << sent_packets_ << " packets sent)");
+}
+
+void SensorTelemetry::addImu(const ImuSample& sample) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (pending_imu_.size() >= kMaxPendingSamples) {
+        pending_imu_.erase(pending_imu_.begin(), pending_imu_.begin() + kMaxPendingSamples / 2);
+    }
+    pending_imu_.push_back(sample);
+}
+
+void SensorTelemetry::addFrameMetadata(const FrameMetadataSample& sample) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (pending_metadata_.size() >= kMaxPendingSamples) {
+        pending_metadata_.erase(pending_metadata_.begin(),
+                                pending_metadata_.begin() + kMaxPendingSamples / 2);
+    }
+    pending_metadata_.push_back(sample);
+}
+
+std::vector<std::vector<uint8_t>> SensorTelemetry::pack(
+    const std::vector<ImuSample>& imu, const std::vector<FrameMetadataSample>& metadata,
+    uint16_t& sequence) {
+    std::vector<std::vector<uint8_t>> packets;
+    size_t imu_index = 0;
+    size_t metadata_index = 0;
+
+    while (imu_index < imu.size() || metadata_index < metadata.size()) {
+        // 先决定本包装多少条，再写头部
+        size_t budget = kMaxPacketBytes - kHeaderBytes;
+        size_t imu_count = std::min(imu.size() - imu_index, budget / kImuRecordBytes);
+        budget -= imu_count * kImuRecordBytes;
+        size_t metadata_count = std::min(metadata.size() - metadata_index, budget / kMetadataRecordBytes);
+
+        const int64_t base_us = imu_count > 0 ? imu[imu_index].timestamp_us
+                                              : metadata[metadata_index].timestamp_us;
+
+        std::vector<uint8_t> packet;
+        packet.reserve(kHeaderBytes + imu_count * kImuRecordBytes +
+                       metadata_count * kMetadataRecordBytes);
+        append<uint8_t>(packet, 'T');
+        append<uint8_t>(packet, 1);
+        append<uint16_t>(packet, sequence++);
+        append<int64_t>(packet, base_us);
+        append<uint16_t>(packet, static_cast<uint16_t>(imu_count));
+        append<uint16_t>(packet, static_cast<uint16_t>(metadata_count));
+
+        for (size_t i = 0; i < imu_count; i++) {
+            const ImuSample& sample = imu[imu_index++];
+            append<int32_t>(packet, static_cast<int32_t>(sample.timestamp_us - base_us));
+            append<uint8_t>(packet, sample.type);
+            append<float>(packet, sample.x);
+            append<float>(packet, sample.y);
+            append<float>(packet, sample.z);
+        }
+        for (size_t i = 0; i < metadata_count; i++) {
+            const FrameMetadataSample& sample = metadata[metadata_index++];
+            append<int32_t>(packet, static_cast<int32_t>(sample.timestamp_us - base_us));
+            append<uint32_t>(packet, sample.frame_number);
+            append<int32_t>(packet, sample.exposure_us);
+            append<int32_t>(packet, sample.gain);
+            append<int32_t>(packet, sample.laser_power);
+            append<int64_t>(packet, sample.sensor_timestamp_us);
+        }
+        packets.push_back(std::move(packet));
+    }
+    return packets;
+}
+
+void SensorTelemetry::senderThread() {
+    const auto period = std::chrono::microseconds(1000000 / std::max(1, config_.packet_rate_hz));
+    auto next_send = std::chrono::steady_clock::now() + period;
+    std::vector<ImuSample> imu;
+    std::vector<FrameMetadataSample> metadata;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (cv_.wait_until(lock, next_send, [this] { return should_stop_; })) {
+                break;
+            }
+            // 交换而不是拷贝，生产者持锁时间只有一次 push_back
+            imu.swap(pending_imu_);
+            metadata.swap(pending_metadata_);
+        }
+        next_send += period;
+        // 落后超过一个周期（如系统挂起）时不补发，重新对齐
+        auto now = std::chrono::steady_clock::now();
+        if (next_send < now) {
+            next_send = now + period;
+        }
+
+        if (imu.empty() && metadata.empty()) {
+            continue;
+        }
+        for (const auto& packet : pack(imu, metadata, sequence_)) {
+            sender_(packet.data(), packet.size());
+            sent_packets_++;
+        }
+        imu.clear();
+        metadata.clear();
+    }
+}
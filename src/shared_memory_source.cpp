@@ -0,0 +1,233 @@
+#include "shared_memory_source.h"
+#include "logger.h"
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+
+namespace {
+
+constexpr int kMaxClaimAttempts = 4;
+
+template <typename T>
+T atomicLoad(const T* ptr) {
+    return __atomic_load_n(ptr, __ATOMIC_SEQ_CST);
+}
+
+template <typename T>
+void atomicStore(T* ptr, T value) {
+    __atomic_store_n(ptr, value, __ATOMIC_SEQ_CST);
+}
+
+}  // namespace
+
+SharedMemorySource::SharedMemorySource(const std::string& name, int timeout_ms)
+    : name_(name), timeout_ms_(timeout_ms), fd_(-1), base_(nullptr), mapped_size_(0),
+      ring_(nullptr), width_(0), height_(0), fps_(30), stride_(0),
+      format_(PixelFormat::kBGR), last_counter_(0),
+      last_capture_time_us_(0), skipped_frames_(0) {
+}
+
+SharedMemorySource::~SharedMemorySource() {
+    release();
+}
+
+bool SharedMemorySource::initialize() {
+    // "/name" 使用 shm_open，其它路径（/dev/shm/x、/proc/<pid>/fd/<n> 形式的 memfd）直接 open
+    bool is_shm_name = !name_.empty() && name_[0] == '/' && name_.find('/', 1) == std::string::npos;
+    fd_ = is_shm_name ? shm_open(name_.c_str(), O_RDWR, 0) : open(name_.c_str(), O_RDWR);
+    if (fd_ < 0) {
+        LOG_ERROR("Failed to open shared memory " << name_ << ": " << strerror(errno));
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd_, &st) < 0 || static_cast<size_t>(st.st_size) < sizeof(ShmRingHeader)) {
+        LOG_ERROR("Shared memory " << name_ << " is too small for a ring header");
+        release();
+        return false;
+    }
+    mapped_size_ = static_cast<size_t>(st.st_size);
+
+    // 需要可写：reader_slot 由消费者写入，叠加层也直接绘制在已占用的槽位上
+    base_ = mmap(nullptr, mapped_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (base_ == MAP_FAILED) {
+        LOG_ERROR("Failed to map shared memory " << name_ << ": " << strerror(errno));
+        base_ = nullptr;
+        release();
+        return false;
+    }
+    ShmRingHeader* ring = static_cast<ShmRingHeader*>(base_);
+
+    if (ring->magic != kShmFrameMagic || ring->version != kShmFrameVersion) {
+        LOG_ERROR("Shared memory " << name_ << " is not a frame ring (magic/version mismatch)");
+        release();
+        return false;
+    }
+
+    size_t bytes_per_pixel = 1;
+    switch (ring->pixel_format) {
+        case kShmPixelBGR:   format_ = PixelFormat::kBGR;   bytes_per_pixel = 3; break;
+        case kShmPixelGRAY8: format_ = PixelFormat::kGRAY8; break;
+        case kShmPixelI420:  format_ = PixelFormat::kI420;  break;
+        default:
+            LOG_ERROR("Unsupported shared memory pixel format " << ring->pixel_format);
+            release();
+            return false;
+    }
+
+    width_ = static_cast<int>(ring->width);
+    height_ = static_cast<int>(ring->height);
+    stride_ = ring->stride;
+    size_t frame_bytes = format_ == PixelFormat::kI420
+        ? stride_ * height_ * 3 / 2
+        : stride_ * height_;
+
+    bool layout_ok =
+        width_ > 0 && height_ > 0 &&
+        ring->slot_count >= 2 && ring->slot_count <= kShmMaxSlots &&
+        ring->header_size >= sizeof(ShmRingHeader) && ring->header_size % 64 == 0 &&
+        ring->slot_size % 64 == 0 && frame_bytes <= ring->slot_size - kShmSlotDataOffset &&
+        ring->header_size + ring->slot_count * ring->slot_size <= mapped_size_ &&
+        stride_ >= width_ * bytes_per_pixel &&
+        (format_ == PixelFormat::kBGR || stride_ == static_cast<size_t>(width_)) &&
+        (format_ != PixelFormat::kI420 || (width_ % 2 == 0 && height_ % 2 == 0));
+    if (!layout_ok) {
+        LOG_ERROR("Invalid shared memory ring layout in " << name_ << " ("
+                  << width_ << "x" << height_ << ", stride " << stride_ << ", "
+                  << ring->slot_count << " slots of " << ring->slot_size << " bytes)");
+        release();
+        return false;
+    }
+
+    if (ring->fps > 0) {
+        fps_ = static_cast<int>(ring->fps);
+    }
+
+    uint32_t other_reader = atomicLoad(&ring->reader_pid);
+    if (other_reader != 0 && other_reader != static_cast<uint32_t>(getpid()) &&
+        kill(static_cast<pid_t>(other_reader), 0) == 0) {
+        LOG_WARN("⚠️  Shared memory " << name_ << " already has a reader (pid "
+                 << other_reader << "), only one consumer is supported");
+    }
+    atomicStore(&ring->reader_slot, -1);
+    atomicStore(&ring->reader_pid, static_cast<uint32_t>(getpid()));
+
+    // 已有帧时第一次 getFrame 立即返回最新帧
+    uint32_t counter = atomicLoad(&ring->frame_counter);
+    last_counter_ = atomicLoad(&ring->latest_slot) >= 0 ? counter - 1 : counter;
+    skipped_frames_ = 0;
+    ring_ = ring;
+
+    LOG_INFO("Shared memory source initialized: " << name_ << " " << width_ << "x" << height_
+             << " " << pixelFormatName(format_) << ", " << ring->slot_count << " slots, producer pid "
+             << ring->producer_pid);
+    return true;
+}
+
+bool SharedMemorySource::waitForFrame() {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms_);
+    while (true) {
+        uint32_t counter = atomicLoad(&ring_->frame_counter);
+        if (counter != last_counter_) {
+            return true;
+        }
+
+        auto remaining = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            deadline - std::chrono::steady_clock::now()).count();
+        if (remaining <= 0) {
+            return false;
+        }
+        struct timespec timeout;
+        timeout.tv_sec = remaining / 1000000000;
+        timeout.tv_nsec = remaining % 1000000000;
+        // 跨进程 futex，不能使用 FUTEX_PRIVATE_FLAG
+        syscall(SYS_futex, &ring_->frame_counter, FUTEX_WAIT, counter, &timeout, nullptr, 0);
+    }
+}
+
+bool SharedMemorySource::getFrame(cv::Mat& frame) {
+    if (!ring_) {
+        return false;
+    }
+
+    // 上一帧已交给 CustomVideoSource 转换完毕，归还槽位
+    releaseSlot();
+
+    for (int attempt = 0; attempt < kMaxClaimAttempts; attempt++) {
+        if (!waitForFrame()) {
+            return false;
+        }
+
+        uint32_t counter = atomicLoad(&ring_->frame_counter);
+        int32_t index = atomicLoad(&ring_->latest_slot);
+        if (index < 0 || static_cast<uint32_t>(index) >= ring_->slot_count) {
+            return false;
+        }
+
+        // 先占用再检查序号：生产者写入前会检查 reader_slot，两者之一必然看到对方
+        atomicStore(&ring_->reader_slot, index);
+        ShmSlotHeader* slot = shmSlotHeader(base_, ring_, static_cast<uint32_t>(index));
+        uint64_t sequence = atomicLoad(&slot->sequence);
+        if (sequence == 0 || (sequence & 1) != 0) {
+            // latest_slot 已被替换且该槽位正在重写，重新读取最新槽位
+            atomicStore(&ring_->reader_slot, -1);
+            continue;
+        }
+
+        skipped_frames_ += counter - last_counter_ - 1;
+        last_counter_ = counter;
+        last_capture_time_us_ = slot->timestamp_us;
+
+        uint8_t* data = shmSlotData(base_, ring_, static_cast<uint32_t>(index));
+        switch (format_) {
+            case PixelFormat::kBGR:
+                frame = cv::Mat(height_, width_, CV_8UC3, data, stride_);
+                break;
+            case PixelFormat::kGRAY8:
+                frame = cv::Mat(height_, width_, CV_8UC1, data, stride_);
+                break;
+            case PixelFormat::kI420:
+                frame = cv::Mat(height_ * 3 / 2, width_, CV_8UC1, data);
+                break;
+            default:
+                return false;
+        }
+        return true;
+    }
+    return false;
+}
+
+void SharedMemorySource::releaseSlot() {
+    if (ring_) {
+        atomicStore(&ring_->reader_slot, -1);
+    }
+}
+
+void SharedMemorySource::release() {
+    if (ring_) {
+        releaseSlot();
+        atomicStore(&ring_->reader_pid, 0u);
+        ring_ = nullptr;
+        if (skipped_frames_ > 0) {
+            LOG_INFO("Shared memory source skipped " << skipped_frames_ << " frames");
+        }
+        LOG_INFO("Shared memory source released");
+    }
+    if (base_) {
+        munmap(base_, mapped_size_);
+        base_ = nullptr;
+    }
+    if (fd_ >= 0) {
+        close(fd_);
+        fd_ = -1;
+    }
+}
+
+std::string SharedMemorySource::getName() const {
+    return "Shared Memory: " + name_;
+}
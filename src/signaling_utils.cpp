@@ -0,0 +1,174 @@
+#include "signaling_utils.h"
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+// Helper to escape JSON strings
+std::string escapeJsonString(const std::string& input) {
+    std::ostringstream ss;
+    for (char c : input) {
+        switch (c) {
+            case '"': ss << "\\\""; break;
+            case '\\': ss << "\\\\"; break;
+            case '\b': ss << "\\b"; break;
+            case '\f': ss << "\\f"; break;
+            case '\n': ss << "\\n"; break;
+            case '\r': ss << "\\r"; break;
+            case '\t': ss << "\\t"; break;
+            default:
+                if ('\x00' <= c && c <= '\x1f') {
+                    ss << "\\u" << std::hex << std::setw(4) << std::setfill('0') << (int)c;
+                } else {
+                    ss << c;
+                }
+        }
+    }
+    return ss.str();
+}
+
+// WebSocket helper functions
+std::string encodeWebSocketFrame(const std::string& message) {
+    std::string frame;
+    size_t length = message.length();
+    
+    frame.push_back(0x81);  // FIN bit + text frame
+    
+    if (length <= 125) {
+        frame.push_back(static_cast<char>(length | 0x80));  // Masked
+    } else if (length <= 65535) {
+        frame.push_back(126 | 0x80);
+        frame.push_back((length >> 8) & 0xFF);
+        frame.push_back(length & 0xFF);
+    }
+    
+    // Masking key (simplified - should be random)
+    char mask[4] = {0x12, 0x34, 0x56, 0x78};
+    frame.append(mask, 4);
+    
+    // Apply mask to payload
+    for (size_t i = 0; i < length; i++) {
+        frame.push_back(message[i] ^ mask[i % 4]);
+    }
+    
+    return frame;
+}
+
+std::string decodeWebSocketFrame(const char* data, size_t len) {
+    if (len < 2) return "";
+    
+    // 检查 opcode（第一个字节的低 4 位）
+    unsigned char opcode = data[0] & 0x0F;
+    
+    // 0x8 = close, 0x9 = ping, 0xA = pong
+    if (opcode == 0x8) {
+        // Close frame
+        return "";
+    } else if (opcode == 0x9 || opcode == 0xA) {
+        // Ping/Pong frame - 自动回复 pong（如果是 ping）
+        if (opcode == 0x9) {
+            // 这是 ping，应该回复 pong（在接收消息的地方处理）
+        }
+        return "";  // 不返回 ping/pong 内容
+    }
+    
+    // 检查是否有 mask（第二个字节的最高位）
+    bool is_masked = (data[1] & 0x80) != 0;
+    size_t payload_len = data[1] & 0x7F;
+    size_t pos = 2;
+    
+    // 处理扩展 payload 长度
+    if (payload_len == 126) {
+        if (len < 4) return "";
+        payload_len = (static_cast<unsigned char>(data[2]) << 8) | 
+                      static_cast<unsigned char>(data[3]);
+        pos = 4;
+    } else if (payload_len == 127) {
+        if (len < 10) return "";
+        // 64-bit 长度（通常不需要，但为了完整性）
+        payload_len = 0;
+        for (int i = 0; i < 8; i++) {
+            payload_len = (payload_len << 8) | static_cast<unsigned char>(data[2 + i]);
+        }
+        pos = 10;
+    }
+    
+    // 处理 mask key
+    char mask[4] = {0};
+    if (is_masked) {
+        if (len < pos + 4) return "";
+        memcpy(mask, data + pos, 4);
+        pos += 4;
+    }
+    
+    // 检查是否有足够的数据
+    if (len < pos + payload_len) return "";
+    
+    // 解码 payload
+    std::string payload;
+    payload.reserve(payload_len);
+    
+    if (is_masked) {
+        for (size_t i = 0; i < payload_len; i++) {
+            payload.push_back(data[pos + i] ^ mask[i % 4]);
+        }
+    } else {
+        // 服务器发送的消息通常不 mask
+        payload.assign(data + pos, payload_len);
+    }
+    
+    return payload;
+}
+
+int forceSendOnlyDirection(std::string& sdp) {
+    int changes = 0;
+    
+    // 查找并替换 a=sendrecv 或 a=recvonly 为 a=sendonly
+    size_t pos = 0;
+    while ((pos = sdp.find("a=sendrecv", pos)) != std::string::npos) {
+        sdp.replace(pos, 10, "a=sendonly");
+        changes++;
+        pos += 10;
+    }
+    
+    pos = 0;
+    while ((pos = sdp.find("a=recvonly", pos)) != std::string::npos) {
+        sdp.replace(pos, 10, "a=sendonly");
+        changes++;
+        pos += 10;
+    }
+    
+    // 如果没有任何方向属性，添加 sendonly
+    if (changes == 0 && sdp.find("a=sendonly") == std::string::npos) {
+        // 在第一个 m= 行之后添加 a=sendonly
+        size_t m_line = sdp.find("m=video");
+        if (m_line != std::string::npos) {
+            size_t next_line = sdp.find("\r\n", m_line);
+            if (next_line != std::string::npos) {
+                sdp.insert(next_line + 2, "a=sendonly\r\n");
+                changes++;
+            }
+        }
+    }
+    
+    return changes;
+}
+
+int removeNackFeedback(std::string& sdp) {
+    int removed = 0;
+    size_t pos = 0;
+    while ((pos = sdp.find("a=rtcp-fb:", pos)) != std::string::npos) {
+        size_t end = sdp.find("\r\n", pos);
+        size_t line_end = end == std::string::npos ? sdp.size() : end + 2;
+        std::string line = sdp.substr(pos, (end == std::string::npos ? sdp.size() : end) - pos);
+        
+        // a=rtcp-fb:96 nack（不带参数），"nack pli" 保留
+        size_t space = line.find(' ');
+        if (space != std::string::npos && line.compare(space + 1, std::string::npos, "nack") == 0) {
+            sdp.erase(pos, line_end - pos);
+            removed++;
+        } else {
+            pos = line_end;
+        }
+    }
+    return removed;
+}
@@ -0,0 +1,73 @@
+#include "static_scene_detector.h"
+#include <algorithm>
+
+StaticSceneDetector::StaticSceneDetector(const StaticSceneConfig& config)
+    : config_(config), last_motion_us_(0), last_delivered_us_(0), static_(false) {
+}
+
+void StaticSceneDetector::setConfig(const StaticSceneConfig& config) {
+    config_ = config;
+    reference_.release();
+    static_ = false;
+}
+
+bool StaticSceneDetector::shouldDeliver(const uint8_t* y, int stride, int width, int height,
+                                        int64_t now_us) {
+    if (!config_.enabled || !y || width <= 0 || height <= 0) {
+        return true;
+    }
+
+    // 整数倍区域缩小，cv::resize 走 INTER_AREA 的整数倍快速路径
+    const int factor = std::max(1, width / kAnalysisWidth);
+    const int analysis_width = std::max(1, width / factor);
+    const int analysis_height = std::max(1, height / factor);
+    cv::Mat plane(height, width, CV_8UC1, const_cast<uint8_t*>(y), static_cast<size_t>(stride));
+    cv::resize(plane(cv::Rect(0, 0, analysis_width * factor, analysis_height * factor)), current_,
+               cv::Size(analysis_width, analysis_height), 0, 0, cv::INTER_AREA);
+
+    bool deliver = true;
+    if (hasMotion(factor)) {
+        last_motion_us_ = now_us;
+        static_ = false;
+    } else if (now_us - last_motion_us_ >= static_cast<int64_t>(config_.hold_ms) * 1000) {
+        static_ = true;
+        int64_t keepalive_us = 1000000 / std::max(1, config_.keepalive_fps);
+        deliver = now_us - last_delivered_us_ >= keepalive_us;
+    }
+
+    if (deliver) {
+        std::swap(reference_, current_);
+        last_delivered_us_ = now_us;
+    }
+    return deliver;
+}
+
+bool StaticSceneDetector::hasMotion(int factor) {
+    // 首帧或分辨率变化
+    if (reference_.size() != current_.size()) {
+        return true;
+    }
+
+    cv::Rect ignore;
+    if (ignore_region_.area() > 0) {
+        ignore = cv::Rect(ignore_region_.x / factor, ignore_region_.y / factor,
+                          (ignore_region_.width + factor - 1) / factor + 1,
+                          (ignore_region_.height + factor - 1) / factor + 1);
+    }
+
+    for (int by = 0; by < current_.rows; by += kBlockSize) {
+        for (int bx = 0; bx < current_.cols; bx += kBlockSize) {
+            cv::Rect block(bx, by, std::min(kBlockSize, current_.cols - bx),
+                           std::min(kBlockSize, current_.rows - by));
+            if ((block & ignore).area() > 0) {
+                continue;
+            }
+            // NORM_L1 对 8 位数据即 SAD，OpenCV 内部用 SIMD（psadbw / NEON）实现
+            double sad = cv::norm(current_(block), reference_(block), cv::NORM_L1);
+            if (sad > config_.threshold * block.area()) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
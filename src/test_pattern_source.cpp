@@ -0,0 +1,197 @@
+#include "test_pattern_source.h"
+#include "logger.h"
+#include <cstring>
+
+namespace {
+
+constexpr int kMaxWidth = 3840;
+constexpr int kMaxHeight = 2160;
+constexpr int kMaxFps = 120;
+constexpr size_t kNoiseSlack = 1 << 16;   // 噪声缓冲尾部，每帧在其中错位读取
+
+// 75% SMPTE 彩条 (BGR)
+const cv::Vec3b kBarColors[] = {
+    {191, 191, 191}, {0, 191, 191}, {191, 191, 0}, {0, 191, 0},
+    {191, 0, 191}, {0, 0, 191}, {191, 0, 0}, {16, 16, 16}
+};
+constexpr int kNumBars = sizeof(kBarColors) / sizeof(kBarColors[0]);
+
+}  // namespace
+
+TestPatternSource::TestPatternSource(const std::string& pattern, PixelFormat format,
+                                     int width, int height, int fps)
+    : pattern_name_(pattern), pattern_(Pattern::kBars), format_(format),
+      width_(width), height_(height), fps_(fps),
+      is_initialized_(false), frame_index_(0) {
+}
+
+TestPatternSource::~TestPatternSource() {
+    release();
+}
+
+bool TestPatternSource::initialize() {
+    if (width_ <= 0 || height_ <= 0 || width_ > kMaxWidth || height_ > kMaxHeight ||
+        width_ % 2 != 0 || height_ % 2 != 0) {
+        LOG_ERROR("Invalid test pattern resolution " << width_ << "x" << height_
+                  << " (even sizes up to " << kMaxWidth << "x" << kMaxHeight << ")");
+        return false;
+    }
+    if (fps_ <= 0 || fps_ > kMaxFps) {
+        LOG_ERROR("Invalid test pattern frame rate " << fps_ << " (1-" << kMaxFps << ")");
+        return false;
+    }
+    if (format_ != PixelFormat::kBGR && format_ != PixelFormat::kI420) {
+        LOG_ERROR("Test pattern only supports BGR and I420 output");
+        return false;
+    }
+
+    if (pattern_name_ == "bars") {
+        pattern_ = Pattern::kBars;
+    } else if (pattern_name_ == "box") {
+        pattern_ = Pattern::kBox;
+    } else if (pattern_name_ == "noise") {
+        pattern_ = Pattern::kNoise;
+    } else if (pattern_name_ == "static") {
+        pattern_ = Pattern::kStatic;
+    } else {
+        LOG_ERROR("Unknown test pattern: " << pattern_name_
+                  << " (bars|box|noise|static)");
+        return false;
+    }
+
+    const bool i420 = format_ == PixelFormat::kI420;
+    output_.create(i420 ? height_ * 3 / 2 : height_, width_, i420 ? CV_8UC1 : CV_8UC3);
+
+    if (pattern_ == Pattern::kNoise) {
+        noise_.resize(output_.total() * output_.elemSize() + kNoiseSlack);
+        cv::Mat noise_view(1, static_cast<int>(noise_.size()), CV_8UC1, noise_.data());
+        cv::randu(noise_view, cv::Scalar(0), cv::Scalar(256));
+    } else {
+        // bars 需要两倍宽度以便滚动；其余图案只需一帧
+        int canvas_width = pattern_ == Pattern::kBars ? width_ * 2 : width_;
+        cv::Mat bgr(height_, canvas_width, CV_8UC3);
+        renderBars(bgr, width_);
+        if (i420) {
+            cv::cvtColor(bgr, canvas_, cv::COLOR_BGR2YUV_I420);
+        } else {
+            canvas_ = bgr;
+        }
+    }
+
+    frame_index_ = 0;
+    is_initialized_ = true;
+    LOG_INFO("Test pattern '" << pattern_name_ << "' initialized: " << width_ << "x" << height_
+             << " @ " << fps_ << " fps (" << pixelFormatName(format_) << ")");
+    return true;
+}
+
+void TestPatternSource::renderBars(cv::Mat& bgr, int period) const {
+    // 上 3/4 为彩条，下 1/4 为亮度渐变，给编码器一些纹理
+    const int bars_height = height_ * 3 / 4;
+    for (int x = 0; x < bgr.cols; x++) {
+        int pos = x % period;
+        const cv::Vec3b& color = kBarColors[pos * kNumBars / period];
+        uint8_t ramp = static_cast<uint8_t>(pos * 255 / period);
+        bgr(cv::Rect(x, 0, 1, bars_height)).setTo(cv::Scalar(color[0], color[1], color[2]));
+        bgr(cv::Rect(x, bars_height, 1, height_ - bars_height)).setTo(cv::Scalar(ramp, ramp, ramp));
+    }
+}
+
+bool TestPatternSource::getFrame(cv::Mat& frame) {
+    if (!is_initialized_) {
+        return false;
+    }
+
+    switch (pattern_) {
+        case Pattern::kBars:
+            copyShifted(static_cast<int>((frame_index_ * 8) % width_));
+            break;
+        case Pattern::kBox:
+            canvas_.copyTo(output_);
+            drawBox(frame_index_);
+            break;
+        case Pattern::kNoise:
+            copyNoise(frame_index_);
+            break;
+        case Pattern::kStatic:
+            canvas_.copyTo(output_);
+            break;
+    }
+
+    frame_index_++;
+
+    // 返回内部缓冲区的浅拷贝；下一次 getFrame 会覆盖其内容
+    frame = output_;
+    return true;
+}
+
+void TestPatternSource::copyShifted(int offset) {
+    if (format_ == PixelFormat::kBGR) {
+        canvas_(cv::Rect(offset, 0, width_, height_)).copyTo(output_);
+        return;
+    }
+
+    // I420：画布宽度为 2w，逐平面按行拷贝窗口
+    const int canvas_width = width_ * 2;
+    for (int y = 0; y < height_; y++) {
+        memcpy(output_.data + y * width_, canvas_.data + y * canvas_width + offset, width_);
+    }
+
+    const int chroma_width = width_ / 2;
+    const int chroma_height = height_ / 2;
+    const uint8_t* src_u = canvas_.data + canvas_width * height_;
+    const uint8_t* src_v = src_u + (canvas_width / 2) * chroma_height;
+    uint8_t* dst_u = output_.data + width_ * height_;
+    uint8_t* dst_v = dst_u + chroma_width * chroma_height;
+    for (int y = 0; y < chroma_height; y++) {
+        memcpy(dst_u + y * chroma_width, src_u + y * width_ + offset / 2, chroma_width);
+        memcpy(dst_v + y * chroma_width, src_v + y * width_ + offset / 2, chroma_width);
+    }
+}
+
+void TestPatternSource::copyNoise(uint64_t frame_index) {
+    size_t offset = static_cast<size_t>((frame_index * 7919) % kNoiseSlack);
+    memcpy(output_.data, noise_.data() + offset, output_.total() * output_.elemSize());
+}
+
+void TestPatternSource::drawBox(uint64_t frame_index) {
+    const int box = (std::min(width_, height_) / 4) & ~1;
+    const int range_x = width_ - box;
+    const int range_y = height_ - box;
+    // 水平匀速移动，垂直往返
+    int x = static_cast<int>((frame_index * 6) % range_x) & ~1;
+    int phase = static_cast<int>((frame_index * 4) % (2 * range_y));
+    int y = (phase < range_y ? phase : 2 * range_y - phase) & ~1;
+
+    if (format_ == PixelFormat::kBGR) {
+        output_(cv::Rect(x, y, box, box)).setTo(cv::Scalar(255, 255, 255));
+        return;
+    }
+
+    // I420：白色 (Y=235, U=V=128)
+    for (int row = y; row < y + box; row++) {
+        memset(output_.data + row * width_ + x, 235, box);
+    }
+    const int chroma_width = width_ / 2;
+    uint8_t* dst_u = output_.data + width_ * height_;
+    uint8_t* dst_v = dst_u + chroma_width * (height_ / 2);
+    for (int row = y / 2; row < (y + box) / 2; row++) {
+        memset(dst_u + row * chroma_width + x / 2, 128, box / 2);
+        memset(dst_v + row * chroma_width + x / 2, 128, box / 2);
+    }
+}
+
+void TestPatternSource::release() {
+    if (is_initialized_) {
+        is_initialized_ = false;
+        canvas_.release();
+        output_.release();
+        noise_.clear();
+        noise_.shrink_to_fit();
+        LOG_INFO("Test pattern released");
+    }
+}
+
+std::string TestPatternSource::getName() const {
+    return "Test Pattern: " + pattern_name_;
+}
@@ -0,0 +1,59 @@
+#include "thread_utils.h"
+#include "logger.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
+
+bool applyThreadSettings(const ThreadSettings& settings, const std::string& default_name) {
+    bool ok = true;
+    pthread_t self = pthread_self();
+
+    // Linux 线程名最长 15 字符（不含结尾 0）
+    std::string name = (settings.name.empty() ? default_name : settings.name).substr(0, 15);
+    if (!name.empty()) {
+        pthread_setname_np(self, name.c_str());
+    }
+
+    if (!settings.cpus.empty()) {
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        for (int cpu : settings.cpus) {
+            if (cpu >= 0 && cpu < CPU_SETSIZE) {
+                CPU_SET(cpu, &cpuset);
+            }
+        }
+        int ret = pthread_setaffinity_np(self, sizeof(cpuset), &cpuset);
+        if (ret != 0) {
+            LOG_WARN("⚠️  [" << name << "] Failed to set CPU affinity: " << strerror(ret));
+            ok = false;
+        }
+    }
+
+    if (settings.policy != "other") {
+        int policy = SCHED_OTHER;
+        if (settings.policy == "fifo") {
+            policy = SCHED_FIFO;
+        } else if (settings.policy == "rr") {
+            policy = SCHED_RR;
+        } else {
+            LOG_WARN("⚠️  [" << name << "] Unknown scheduling policy: " << settings.policy);
+            return false;
+        }
+
+        sched_param param;
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = std::max(sched_get_priority_min(policy),
+                                        std::min(settings.priority, sched_get_priority_max(policy)));
+        int ret = pthread_setschedparam(self, policy, &param);
+        if (ret != 0) {
+            LOG_WARN("⚠️  [" << name << "] Failed to set " << settings.policy << " priority "
+                     << param.sched_priority << ": " << strerror(ret)
+                     << (ret == EPERM ? " (需要 CAP_SYS_NICE 或 rtprio 限额)" : ""));
+            ok = false;
+        }
+    }
+
+    return ok;
+}
@@ -0,0 +1,391 @@
+#include "v4l2_source.h"
+#include "logger.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/videodev2.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr int kMinBuffers = 2;
+constexpr int kMaxBuffers = 32;
+constexpr int kPollTimeoutMs = 1000;
+
+std::string fourccToString(uint32_t fourcc) {
+    std::string s(4, ' ');
+    for (int i = 0; i < 4; i++) {
+        s[i] = static_cast<char>((fourcc >> (8 * i)) & 0xFF);
+    }
+    return s;
+}
+
+}  // namespace
+
+V4L2Source::V4L2Source(const std::string& device, int width, int height, int fps,
+                       const std::string& format, int buffer_count)
+    : device_(device), format_name_(format), width_(width), height_(height), fps_(fps),
+      buffer_count_(buffer_count), format_(PixelFormat::kYUYV), fourcc_(0), bytes_per_line_(0),
+      fd_(-1), streaming_(false), monotonic_timestamps_(false),
+      last_capture_time_us_(0), last_sequence_(0), dropped_frames_(0),
+      latest_frame_only_(false), skipped_frames_(0) {
+}
+
+V4L2Source::~V4L2Source() {
+    release();
+}
+
+int V4L2Source::xioctl(unsigned long request, void* arg) const {
+    int ret;
+    do {
+        ret = ioctl(fd_, request, arg);
+    } while (ret == -1 && errno == EINTR);
+    return ret;
+}
+
+bool V4L2Source::initialize() {
+    if (format_name_ == "yuyv") {
+        format_ = PixelFormat::kYUYV;
+        fourcc_ = V4L2_PIX_FMT_YUYV;
+    } else if (format_name_ == "uyvy") {
+        format_ = PixelFormat::kUYVY;
+        fourcc_ = V4L2_PIX_FMT_UYVY;
+    } else if (format_name_ == "grey") {
+        format_ = PixelFormat::kGRAY8;
+        fourcc_ = V4L2_PIX_FMT_GREY;
+    } else if (format_name_ == "y16") {
+        format_ = PixelFormat::kGRAY16;
+        fourcc_ = V4L2_PIX_FMT_Y16;
+    } else if (format_name_ == "nv12") {
+        format_ = PixelFormat::kNV12;
+        fourcc_ = V4L2_PIX_FMT_NV12;
+    } else if (format_name_ == "mjpeg") {
+        format_ = PixelFormat::kMJPEG;
+        fourcc_ = V4L2_PIX_FMT_MJPEG;
+    } else {
+        LOG_ERROR("Unknown V4L2 pixel format: " << format_name_ << " (yuyv|uyvy|nv12|grey|y16|mjpeg)");
+        return false;
+    }
+    if (buffer_count_ < kMinBuffers || buffer_count_ > kMaxBuffers) {
+        LOG_ERROR("Invalid V4L2 buffer count " << buffer_count_
+                  << " (" << kMinBuffers << "-" << kMaxBuffers << ")");
+        return false;
+    }
+
+    fd_ = open(device_.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (fd_ < 0) {
+        LOG_ERROR("Failed to open " << device_ << ": " << strerror(errno));
+        return false;
+    }
+
+    struct v4l2_capability cap;
+    memset(&cap, 0, sizeof(cap));
+    if (xioctl(VIDIOC_QUERYCAP, &cap) < 0) {
+        LOG_ERROR(device_ << " is not a V4L2 device: " << strerror(errno));
+        release();
+        return false;
+    }
+    uint32_t caps = (cap.capabilities & V4L2_CAP_DEVICE_CAPS) ? cap.device_caps : cap.capabilities;
+    if (!(caps & V4L2_CAP_VIDEO_CAPTURE) || !(caps & V4L2_CAP_STREAMING)) {
+        LOG_ERROR(device_ << " does not support single-planar capture with streaming I/O");
+        release();
+        return false;
+    }
+
+    if (!setFormat() || !setFrameRate() || !setupBuffers()) {
+        release();
+        return false;
+    }
+
+    enum v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if (xioctl(VIDIOC_STREAMON, &type) < 0) {
+        LOG_ERROR("VIDIOC_STREAMON failed on " << device_ << ": " << strerror(errno));
+        release();
+        return false;
+    }
+    streaming_ = true;
+
+    LOG_INFO("V4L2 device " << device_ << " (" << reinterpret_cast<const char*>(cap.card) << ") opened: "
+             << width_ << "x" << height_ << " @ " << fps_ << " fps, " << pixelFormatName(format_)
+             << ", " << buffers_.size() << " mmap buffers"
+             << (getDmabufFd(0) >= 0 ? ", DMABUF export" : ""));
+    return true;
+}
+
+bool V4L2Source::setFormat() {
+    struct v4l2_format fmt;
+    memset(&fmt, 0, sizeof(fmt));
+    fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    fmt.fmt.pix.width = width_;
+    fmt.fmt.pix.height = height_;
+    fmt.fmt.pix.pixelformat = fourcc_;
+    fmt.fmt.pix.field = V4L2_FIELD_NONE;
+
+    if (xioctl(VIDIOC_S_FMT, &fmt) < 0) {
+        LOG_ERROR("VIDIOC_S_FMT failed: " << strerror(errno));
+        return false;
+    }
+    // 驱动可能替换为其支持的格式/分辨率
+    if (fmt.fmt.pix.pixelformat != fourcc_) {
+        LOG_ERROR(device_ << " does not support " << fourccToString(fourcc_)
+                  << " (driver chose " << fourccToString(fmt.fmt.pix.pixelformat) << ")");
+        return false;
+    }
+    if (static_cast<int>(fmt.fmt.pix.width) != width_ || static_cast<int>(fmt.fmt.pix.height) != height_) {
+        LOG_WARN("⚠️  " << device_ << " adjusted resolution to "
+                 << fmt.fmt.pix.width << "x" << fmt.fmt.pix.height);
+    }
+    width_ = static_cast<int>(fmt.fmt.pix.width);
+    height_ = static_cast<int>(fmt.fmt.pix.height);
+    bytes_per_line_ = fmt.fmt.pix.bytesperline;
+    if (bytes_per_line_ == 0 && format_ != PixelFormat::kMJPEG) {
+        const bool two_bytes = format_ == PixelFormat::kYUYV || format_ == PixelFormat::kUYVY ||
+                               format_ == PixelFormat::kGRAY16;
+        bytes_per_line_ = two_bytes ? width_ * 2 : width_;
+    }
+    return true;
+}
+
+bool V4L2Source::setFrameRate() {
+    struct v4l2_streamparm parm;
+    memset(&parm, 0, sizeof(parm));
+    parm.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if (xioctl(VIDIOC_G_PARM, &parm) < 0 || !(parm.parm.capture.capability & V4L2_CAP_TIMEPERFRAME)) {
+        LOG_WARN("⚠️  " << device_ << " does not support setting the frame rate");
+        return true;
+    }
+
+    parm.parm.capture.timeperframe.numerator = 1;
+    parm.parm.capture.timeperframe.denominator = fps_;
+    if (xioctl(VIDIOC_S_PARM, &parm) < 0) {
+        LOG_ERROR("VIDIOC_S_PARM failed: " << strerror(errno));
+        return false;
+    }
+    const struct v4l2_fract& tpf = parm.parm.capture.timeperframe;
+    if (tpf.numerator > 0) {
+        fps_ = static_cast<int>(tpf.denominator / tpf.numerator);
+    }
+    return true;
+}
+
+bool V4L2Source::setupBuffers() {
+    struct v4l2_requestbuffers req;
+    memset(&req, 0, sizeof(req));
+    req.count = buffer_count_;
+    req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    req.memory = V4L2_MEMORY_MMAP;
+    if (xioctl(VIDIOC_REQBUFS, &req) < 0) {
+        LOG_ERROR("VIDIOC_REQBUFS failed: " << strerror(errno));
+        return false;
+    }
+    if (req.count < static_cast<uint32_t>(kMinBuffers)) {
+        LOG_ERROR("Insufficient V4L2 buffers on " << device_ << ": " << req.count);
+        return false;
+    }
+
+    buffers_.resize(req.count);
+    for (uint32_t i = 0; i < req.count; i++) {
+        struct v4l2_buffer buf;
+        memset(&buf, 0, sizeof(buf));
+        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.index = i;
+        if (xioctl(VIDIOC_QUERYBUF, &buf) < 0) {
+            LOG_ERROR("VIDIOC_QUERYBUF failed: " << strerror(errno));
+            return false;
+        }
+
+        buffers_[i].length = buf.length;
+        buffers_[i].start = mmap(nullptr, buf.length, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, buf.m.offset);
+        if (buffers_[i].start == MAP_FAILED) {
+            buffers_[i].start = nullptr;
+            LOG_ERROR("Failed to mmap V4L2 buffer " << i << ": " << strerror(errno));
+            return false;
+        }
+
+        // 导出 DMABUF，便于后续交给硬件编码器/GPU 零拷贝使用；不支持时忽略
+        struct v4l2_exportbuffer exp;
+        memset(&exp, 0, sizeof(exp));
+        exp.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        exp.index = i;
+        exp.flags = O_RDONLY | O_CLOEXEC;
+        if (xioctl(VIDIOC_EXPBUF, &exp) == 0) {
+            buffers_[i].dmabuf_fd = exp.fd;
+        }
+
+        if (xioctl(VIDIOC_QBUF, &buf) < 0) {
+            LOG_ERROR("VIDIOC_QBUF failed: " << strerror(errno));
+            return false;
+        }
+    }
+    return true;
+}
+
+bool V4L2Source::queueBuffer(uint32_t index) {
+    struct v4l2_buffer buf;
+    memset(&buf, 0, sizeof(buf));
+    buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buf.memory = V4L2_MEMORY_MMAP;
+    buf.index = index;
+    if (xioctl(VIDIOC_QBUF, &buf) < 0) {
+        LOG_ERROR("VIDIOC_QBUF failed: " << strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+void V4L2Source::releaseFrame(int buffer_index) {
+    // 帧已转换完毕，把缓冲区还给驱动；停止采集后 STREAMOFF 已收回全部缓冲区
+    if (streaming_ && buffer_index >= 0) {
+        queueBuffer(static_cast<uint32_t>(buffer_index));
+    }
+}
+
+bool V4L2Source::setLatestFrameOnly(bool enable) {
+    latest_frame_only_ = enable;
+    return true;
+}
+
+void V4L2Source::updateSequence(uint32_t sequence) {
+    // 驱动序号不连续说明内核侧丢帧（队列中缓冲区不足或处理太慢）
+    if (last_sequence_ != 0 && sequence > last_sequence_ + 1) {
+        dropped_frames_ += sequence - last_sequence_ - 1;
+    }
+    last_sequence_ = sequence;
+}
+
+bool V4L2Source::acquireFrame(FrameLease& lease) {
+    if (!streaming_) {
+        return false;
+    }
+
+    // 调用方手里的上一帧先还给驱动
+    lease.reset();
+
+    struct pollfd pfd = {fd_, POLLIN, 0};
+    int ret;
+    do {
+        ret = poll(&pfd, 1, kPollTimeoutMs);
+    } while (ret < 0 && errno == EINTR);
+    if (ret <= 0) {
+        if (ret == 0) {
+            LOG_EVERY_MS(LogLevel::kWarn, 1000, "⚠️  V4L2 capture timeout on " << device_);
+        }
+        return false;
+    }
+
+    struct v4l2_buffer buf;
+    memset(&buf, 0, sizeof(buf));
+    buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buf.memory = V4L2_MEMORY_MMAP;
+    if (xioctl(VIDIOC_DQBUF, &buf) < 0) {
+        if (errno != EAGAIN) {
+            LOG_EVERY_MS(LogLevel::kError, 1000, "VIDIOC_DQBUF failed: " << strerror(errno));
+        }
+        return false;
+    }
+    updateSequence(buf.sequence);
+
+    // 只取最新帧：处理上一帧期间已就绪的旧帧直接归还驱动，不排队送去编码
+    while (latest_frame_only_) {
+        struct v4l2_buffer newer;
+        memset(&newer, 0, sizeof(newer));
+        newer.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        newer.memory = V4L2_MEMORY_MMAP;
+        if (xioctl(VIDIOC_DQBUF, &newer) < 0) {
+            break;
+        }
+        queueBuffer(buf.index);
+        buf = newer;
+        updateSequence(buf.sequence);
+        skipped_frames_++;
+    }
+
+    if ((buf.flags & V4L2_BUF_FLAG_ERROR) || buf.bytesused == 0) {
+        queueBuffer(buf.index);
+        return false;
+    }
+
+    monotonic_timestamps_ =
+        (buf.flags & V4L2_BUF_FLAG_TIMESTAMP_MASK) == V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC;
+    last_capture_time_us_ = monotonic_timestamps_
+        ? static_cast<int64_t>(buf.timestamp.tv_sec) * 1000000 + buf.timestamp.tv_usec
+        : 0;
+
+    // 租约直接指向 mmap 缓冲区，归还时再 QBUF，无拷贝也无分配
+    void* data = buffers_[buf.index].start;
+    cv::Mat image;
+    switch (format_) {
+        case PixelFormat::kYUYV:
+        case PixelFormat::kUYVY:
+            image = cv::Mat(height_, width_, CV_8UC2, data, bytes_per_line_);
+            break;
+        case PixelFormat::kGRAY8:
+            image = cv::Mat(height_, width_, CV_8UC1, data, bytes_per_line_);
+            break;
+        case PixelFormat::kGRAY16:
+            image = cv::Mat(height_, width_, CV_16UC1, data, bytes_per_line_);
+            break;
+        case PixelFormat::kNV12:
+            image = cv::Mat(height_ * 3 / 2, width_, CV_8UC1, data, bytes_per_line_);
+            break;
+        case PixelFormat::kMJPEG:
+            image = cv::Mat(1, static_cast<int>(buf.bytesused), CV_8UC1, data);
+            break;
+        default:
+            queueBuffer(buf.index);
+            return false;
+    }
+    lend(lease, image, format_, last_capture_time_us_, static_cast<int>(buf.index));
+    return true;
+}
+
+int V4L2Source::getDmabufFd(size_t index) const {
+    return index < buffers_.size() ? buffers_[index].dmabuf_fd : -1;
+}
+
+void V4L2Source::release() {
+    if (fd_ < 0) {
+        return;
+    }
+
+    if (streaming_) {
+        enum v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        xioctl(VIDIOC_STREAMOFF, &type);
+        streaming_ = false;
+        if (dropped_frames_ > 0) {
+            LOG_INFO("V4L2 driver dropped " << dropped_frames_ << " frames");
+        }
+        if (skipped_frames_ > 0) {
+            LOG_INFO("V4L2 skipped " << skipped_frames_ << " stale frames (latest frame only)");
+        }
+    }
+    for (Buffer& buffer : buffers_) {
+        if (buffer.dmabuf_fd >= 0) {
+            close(buffer.dmabuf_fd);
+        }
+        if (buffer.start) {
+            munmap(buffer.start, buffer.length);
+        }
+    }
+    buffers_.clear();
+
+    // 释放驱动侧缓冲区
+    struct v4l2_requestbuffers req;
+    memset(&req, 0, sizeof(req));
+    req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    req.memory = V4L2_MEMORY_MMAP;
+    xioctl(VIDIOC_REQBUFS, &req);
+
+    close(fd_);
+    fd_ = -1;
+    LOG_INFO("V4L2 device " << device_ << " released");
+}
+
+std::string V4L2Source::getName() const {
+    return "V4L2: " + device_;
+}
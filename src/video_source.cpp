@@ -1,3 +1,62 @@
 #include "video_source.h"
 
-// Base class - no implementation needed as it's pure virtual
+// FrameLease implementation
+FrameLease& FrameLease::operator=(FrameLease&& other) noexcept {
+    if (this != &other) {
+        reset();
+        image_ = std::move(other.image_);
+        format_ = other.format_;
+        capture_time_us_ = other.capture_time_us_;
+        owner_ = other.owner_;
+        buffer_index_ = other.buffer_index_;
+        other.owner_ = nullptr;
+        other.buffer_index_ = -1;
+        other.image_.release();
+    }
+    return *this;
+}
+
+void FrameLease::reset() {
+    // 先放掉 Mat 头再归还：源可能立即把缓冲区交给驱动或下一个租约
+    image_.release();
+    capture_time_us_ = 0;
+    VideoSource* owner = owner_;
+    owner_ = nullptr;
+    if (owner) {
+        owner->releaseFrame(buffer_index_);
+    }
+    buffer_index_ = -1;
+}
+
+// VideoSource implementation
+bool VideoSource::getFrame(cv::Mat& frame) {
+    // 上一帧先归还，池里才有空闲缓冲区
+    compat_lease_.reset();
+    if (!acquireFrame(compat_lease_)) {
+        return false;
+    }
+    frame = compat_lease_.image();
+    return true;
+}
+
+// MatVideoSource implementation
+bool MatVideoSource::acquireFrame(FrameLease& lease) {
+    lease.reset();
+    if (!getFrame(lease.image_) || lease.image_.empty()) {
+        lease.image_.release();
+        return false;
+    }
+    lease.format_ = getPixelFormat();
+    lease.capture_time_us_ = getLastCaptureTimeUs();
+    return true;
+}
+
+void VideoSource::lend(FrameLease& lease, const cv::Mat& image, PixelFormat format,
+                       int64_t capture_time_us, int buffer_index) {
+    lease.reset();
+    lease.image_ = image;
+    lease.format_ = format;
+    lease.capture_time_us_ = capture_time_us;
+    lease.owner_ = this;
+    lease.buffer_index_ = buffer_index;
+}
@@ -1,7 +1,18 @@
 #include "webrtc_client.h"
 #include "custom_video_source.h"
 #include "simple_video_codec_factory.h"
-#include <iostream>
+#include "latency_tracer.h"
+#include "signaling_utils.h"
+#include "encoded_recorder.h"
+#include "recording_frame_transformer.h"
+#include "thread_utils.h"
+#include "control_channel.h"
+#include "instrumented_video_encoder.h"
+#include "sensor_telemetry.h"
+#include "adaptation_controller.h"
+#include "logger.h"
+#include <algorithm>
+#include <cctype>
 #include <sstream>
 #include <iomanip>
 #include <cstring>
@@ -17,10 +28,54 @@
 #include <api/video_codecs/builtin_video_decoder_factory.h>
 #include <api/video_codecs/builtin_video_encoder_factory.h>
 #include <api/peer_connection_interface.h>
+#include <api/rtp_parameters.h>
+#include <api/stats/rtcstats_objects.h>
 #include <rtc_base/ssl_adapter.h>
 #include <rtc_base/thread.h>
-#include <rtc_base/logging.h>
 #include <pc/video_track_source.h>
+#include <system_wrappers/include/field_trial.h>
+
+namespace {
+
+// CPU 或带宽不足时 WebRTC 的取舍：降帧率、降分辨率或两者兼顾
+webrtc::DegradationPreference parseDegradationPreference(const std::string& preference) {
+    if (preference == "maintain_resolution") {
+        return webrtc::DegradationPreference::MAINTAIN_RESOLUTION;
+    } else if (preference == "maintain_framerate") {
+        return webrtc::DegradationPreference::MAINTAIN_FRAMERATE;
+    } else if (preference != "balanced") {
+        LOG_WARN("⚠️  Unknown degradation preference '" << preference << "', using balanced");
+    }
+    return webrtc::DegradationPreference::BALANCED;
+}
+
+// FlexFEC 在 M100 中仍需 field trial 才会出现在编码能力里并实际生效；字符串须在进程内一直有效
+constexpr char kFlexFecFieldTrials[] = "WebRTC-FlexFEC-03-Advertised/Enabled/WebRTC-FlexFEC-03/Enabled/";
+
+bool sameCodecName(const std::string& a, const std::string& b) {
+    return a.size() == b.size() &&
+           std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+               return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+           });
+}
+
+// 热加载字段 "video.<setting>"（主视频）或 "video.<i>.<setting>"（数组中第 i 路）
+bool parseVideoField(const std::string& field, size_t& index, std::string& setting) {
+    if (field.rfind("video.", 0) != 0) {
+        return false;
+    }
+    setting = field.substr(6);
+    index = 0;
+    size_t dot = setting.find('.');
+    if (dot != std::string::npos && dot > 0 &&
+        std::all_of(setting.begin(), setting.begin() + dot, ::isdigit)) {
+        index = std::stoul(setting.substr(0, dot));
+        setting = setting.substr(dot + 1);
+    }
+    return true;
+}
+
+}  // namespace
 
 // Observer classes
 class PeerConnectionObserver : public webrtc::PeerConnectionObserver {
@@ -28,15 +83,16 @@ public:
     explicit PeerConnectionObserver(WebRTCClient* client) : client_(client) {}
     
     void OnSignalingChange(webrtc::PeerConnectionInterface::SignalingState new_state) override {
-        RTC_LOG(LS_INFO) << "Signaling state: " << new_state;
+        LOG_INFO("📶 Signaling state: " << new_state);
     }
     
     void OnDataChannel(rtc::scoped_refptr<webrtc::DataChannelInterface> channel) override {
-        RTC_LOG(LS_INFO) << "Data channel created";
+        LOG_INFO("📨 Data channel created");
+        client_->OnDataChannel(channel);
     }
     
     void OnRenegotiationNeeded() override {
-        RTC_LOG(LS_INFO) << "Renegotiation needed";
+        LOG_INFO("🔁 Renegotiation needed");
     }
     
     void OnIceConnectionChange(webrtc::PeerConnectionInterface::IceConnectionState new_state) override {
@@ -45,26 +101,33 @@ public:
             "failed", "disconnected", "closed"
         };
         int state_idx = static_cast<int>(new_state);
-        std::cout << "🧊 ICE connection state: " << state_str[state_idx] << std::endl;
+        LOG_INFO("🧊 ICE connection state: " << state_str[state_idx]);
         
         if (new_state == webrtc::PeerConnectionInterface::kIceConnectionConnected) {
-            std::cout << "✅ ICE connection established!" << std::endl;
+            LOG_INFO("✅ ICE connection established!");
             client_->OnConnectionChange(true);
         } else if (new_state == webrtc::PeerConnectionInterface::kIceConnectionFailed) {
-            std::cout << "❌ ICE connection failed! Check TURN server configuration." << std::endl;
+            LOG_ERROR("❌ ICE connection failed! Check TURN server configuration.");
             client_->OnConnectionChange(false);
         } else if (new_state == webrtc::PeerConnectionInterface::kIceConnectionDisconnected) {
-            std::cout << "⚠️  ICE connection disconnected" << std::endl;
+            LOG_WARN("⚠️  ICE connection disconnected");
         } else if (new_state == webrtc::PeerConnectionInterface::kIceConnectionClosed) {
-            std::cout << "⚠️  ICE connection closed" << std::endl;
+            LOG_WARN("⚠️  ICE connection closed");
             client_->OnConnectionChange(false);
         }
     }
     
+    void OnConnectionChange(webrtc::PeerConnectionInterface::PeerConnectionState new_state) override {
+        // ICE connected 时 DTLS 可能还没完成，此时编出的关键帧会被丢掉；等到可以发送媒体
+        if (new_state == webrtc::PeerConnectionInterface::PeerConnectionState::kConnected) {
+            client_->OnPeerJoined();
+        }
+    }
+    
     void OnIceGatheringChange(webrtc::PeerConnectionInterface::IceGatheringState new_state) override {
         const char* state_str[] = {"new", "gathering", "complete"};
         int state_idx = static_cast<int>(new_state);
-        std::cout << "🔍 ICE gathering state: " << state_str[state_idx] << std::endl;
+        LOG_INFO("🔍 ICE gathering state: " << state_str[state_idx]);
     }
     
     void OnIceCandidate(const webrtc::IceCandidateInterface* candidate) override {
@@ -72,17 +135,17 @@ public:
         candidate->ToString(&sdp);
         // 显示 candidate 类型（host/srflx/relay）
         if (sdp.find("typ host") != std::string::npos) {
-            std::cout << "📡 ICE candidate (host): local network" << std::endl;
+            LOG_INFO("📡 ICE candidate (host): local network");
         } else if (sdp.find("typ srflx") != std::string::npos) {
-            std::cout << "📡 ICE candidate (srflx): via STUN" << std::endl;
+            LOG_INFO("📡 ICE candidate (srflx): via STUN");
         } else if (sdp.find("typ relay") != std::string::npos) {
-            std::cout << "📡 ICE candidate (relay): via TURN ✅" << std::endl;
+            LOG_INFO("📡 ICE candidate (relay): via TURN ✅");
         }
         client_->OnIceCandidate(candidate);
     }
     
     void OnTrack(rtc::scoped_refptr<webrtc::RtpTransceiverInterface> transceiver) override {
-        RTC_LOG(LS_INFO) << "Track added";
+        LOG_INFO("🎞️  Track added");
     }
     
 private:
@@ -98,7 +161,19 @@ public:
     }
     
     void OnFailure(webrtc::RTCError error) override {
-        RTC_LOG(LS_ERROR) << "Create session description failed: " << error.message();
+        LOG_ERROR("❌ Create session description failed: " << error.message());
+    }
+    
+private:
+    WebRTCClient* client_;
+};
+
+class StatsCallback : public webrtc::RTCStatsCollectorCallback {
+public:
+    explicit StatsCallback(WebRTCClient* client) : client_(client) {}
+    
+    void OnStatsDelivered(const rtc::scoped_refptr<const webrtc::RTCStatsReport>& report) override {
+        client_->OnStatsDelivered(report);
     }
     
 private:
@@ -114,186 +189,119 @@ public:
     }
     
     void OnFailure(webrtc::RTCError error) override {
-        RTC_LOG(LS_ERROR) << "Set session description failed: " << error.message();
+        LOG_ERROR("❌ Set session description failed: " << error.message());
     }
     
 private:
     WebRTCClient* client_;
 };
 
-// Helper to escape JSON strings
-std::string escapeJsonString(const std::string& input) {
-    std::ostringstream ss;
-    for (char c : input) {
-        switch (c) {
-            case '"': ss << "\\\""; break;
-            case '\\': ss << "\\\\"; break;
-            case '\b': ss << "\\b"; break;
-            case '\f': ss << "\\f"; break;
-            case '\n': ss << "\\n"; break;
-            case '\r': ss << "\\r"; break;
-            case '\t': ss << "\\t"; break;
-            default:
-                if ('\x00' <= c && c <= '\x1f') {
-                    ss << "\\u" << std::hex << std::setw(4) << std::setfill('0') << (int)c;
-                } else {
-                    ss << c;
-                }
+// WebRTCClient implementation
+WebRTCClient::WebRTCClient(std::vector<std::shared_ptr<VideoSource>> video_sources,
+                           const AppConfig& config)
+    : config_(config),
+      is_streaming_(false), should_stop_(false), peer_connected_(false),
+      last_bytes_sent_(0), last_stats_us_(0), ws_socket_(-1), next_frame_id_(0),
+      key_frames_(std::make_shared<KeyFrameTrigger>()) {
+    for (size_t i = 0; i < video_sources.size(); i++) {
+        auto track = std::make_unique<VideoTrackContext>();
+        if (i == 0) {
+            track->config = config_.video;
+        } else if (i - 1 < config_.extra_videos.size()) {
+            track->config = config_.extra_videos[i - 1];
         }
+        // 单路时沿用原有的轨道 ID，接收端无需改动
+        if (!track->config.name.empty()) {
+            track->track_id = track->config.name;
+        } else {
+            track->track_id = i == 0 ? "video_track" : "video_track_" + std::to_string(i);
+        }
+        track->source = video_sources[i];
+        tracks_.push_back(std::move(track));
     }
-    return ss.str();
-}
-
-// WebSocket helper functions
-std::string encodeWebSocketFrame(const std::string& message) {
-    std::string frame;
-    size_t length = message.length();
-    
-    frame.push_back(0x81);  // FIN bit + text frame
-    
-    if (length <= 125) {
-        frame.push_back(static_cast<char>(length | 0x80));  // Masked
-    } else if (length <= 65535) {
-        frame.push_back(126 | 0x80);
-        frame.push_back((length >> 8) & 0xFF);
-        frame.push_back(length & 0xFF);
-    }
-    
-    // Masking key (simplified - should be random)
-    char mask[4] = {0x12, 0x34, 0x56, 0x78};
-    frame.append(mask, 4);
-    
-    // Apply mask to payload
-    for (size_t i = 0; i < length; i++) {
-        frame.push_back(message[i] ^ mask[i % 4]);
-    }
-    
-    return frame;
 }
 
-std::string decodeWebSocketFrame(const char* data, size_t len) {
-    if (len < 2) return "";
-    
-    // 检查 opcode（第一个字节的低 4 位）
-    unsigned char opcode = data[0] & 0x0F;
-    
-    // 0x8 = close, 0x9 = ping, 0xA = pong
-    if (opcode == 0x8) {
-        // Close frame
-        return "";
-    } else if (opcode == 0x9 || opcode == 0xA) {
-        // Ping/Pong frame - 自动回复 pong（如果是 ping）
-        if (opcode == 0x9) {
-            // 这是 ping，应该回复 pong（在接收消息的地方处理）
-        }
-        return "";  // 不返回 ping/pong 内容
-    }
-    
-    // 检查是否有 mask（第二个字节的最高位）
-    bool is_masked = (data[1] & 0x80) != 0;
-    size_t payload_len = data[1] & 0x7F;
-    size_t pos = 2;
-    
-    // 处理扩展 payload 长度
-    if (payload_len == 126) {
-        if (len < 4) return "";
-        payload_len = (static_cast<unsigned char>(data[2]) << 8) | 
-                      static_cast<unsigned char>(data[3]);
-        pos = 4;
-    } else if (payload_len == 127) {
-        if (len < 10) return "";
-        // 64-bit 长度（通常不需要，但为了完整性）
-        payload_len = 0;
-        for (int i = 0; i < 8; i++) {
-            payload_len = (payload_len << 8) | static_cast<unsigned char>(data[2 + i]);
-        }
-        pos = 10;
-    }
-    
-    // 处理 mask key
-    char mask[4] = {0};
-    if (is_masked) {
-        if (len < pos + 4) return "";
-        memcpy(mask, data + pos, 4);
-        pos += 4;
-    }
-    
-    // 检查是否有足够的数据
-    if (len < pos + payload_len) return "";
-    
-    // 解码 payload
-    std::string payload;
-    payload.reserve(payload_len);
-    
-    if (is_masked) {
-        for (size_t i = 0; i < payload_len; i++) {
-            payload.push_back(data[pos + i] ^ mask[i % 4]);
-        }
-    } else {
-        // 服务器发送的消息通常不 mask
-        payload.assign(data + pos, payload_len);
-    }
-    
-    return payload;
+WebRTCClient::WebRTCClient(std::shared_ptr<VideoSource> video_source,
+                           const AppConfig& config)
+    : WebRTCClient(std::vector<std::shared_ptr<VideoSource>>{video_source}, config) {
 }
 
-// WebRTCClient implementation
 WebRTCClient::WebRTCClient(std::shared_ptr<VideoSource> video_source,
                            const WebRTCConfig& webrtc_config)
-    : video_source_(video_source), webrtc_config_(webrtc_config),
-      is_streaming_(false), should_stop_(false), peer_connected_(false),
-      ws_socket_(-1), frame_count_(0) {
+    : WebRTCClient(video_source, AppConfig()) {
+    config_.webrtc = webrtc_config;
 }
 
 WebRTCClient::~WebRTCClient() {
     stop();
+    // factory 内部对象在 signaling/worker 线程上析构，必须先于线程释放
+    peer_connection_factory_ = nullptr;
+    rtc_signaling_thread_.reset();
+    rtc_worker_thread_.reset();
+    rtc_network_thread_.reset();
+}
+
+void WebRTCClient::startRtcThread(rtc::Thread* thread, const ThreadSettings& settings,
+                                  const std::string& default_name) {
+    thread->SetName(settings.name.empty() ? default_name : settings.name, nullptr);
+    thread->Start();
+    if (!settings.isDefault()) {
+        thread->Invoke<void>(RTC_FROM_HERE, [&settings, &default_name] {
+            applyThreadSettings(settings, default_name);
+        });
+    }
 }
 
 bool WebRTCClient::initialize() {
-    if (!video_source_ || !video_source_->isReady()) {
-        std::cerr << "Video source is not ready" << std::endl;
+    if (tracks_.empty()) {
+        LOG_ERROR("No video source configured");
         return false;
     }
+    for (const auto& track : tracks_) {
+        if (!track->source || !track->source->isReady()) {
+            LOG_ERROR("Video source is not ready: " << track->track_id);
+            return false;
+        }
+    }
     
-    std::cout << "Initializing WebRTC client..." << std::endl;
+    LOG_INFO("Initializing WebRTC client...");
     
     // Initialize SSL
     rtc::InitializeSSL();
     
-    // Create threads
-    std::unique_ptr<rtc::Thread> network_thread = rtc::Thread::CreateWithSocketServer();
-    std::unique_ptr<rtc::Thread> worker_thread = rtc::Thread::Create();
-    std::unique_ptr<rtc::Thread> signaling_thread = rtc::Thread::Create();
+    // field trial 必须在创建 factory 之前设置
+    if (config_.resilience.flexfec) {
+        webrtc::field_trial::InitFieldTrialsFromString(kFlexFecFieldTrials);
+    }
     
-    network_thread->Start();
-    worker_thread->Start();
-    signaling_thread->Start();
+    // Create threads（由客户端持有，按 config_.threads 命名、绑核、设置调度策略）
+    rtc_network_thread_ = rtc::Thread::CreateWithSocketServer();
+    rtc_worker_thread_ = rtc::Thread::Create();
+    rtc_signaling_thread_ = rtc::Thread::Create();
+    
+    startRtcThread(rtc_network_thread_.get(), config_.threads.network, "rtc_network");
+    startRtcThread(rtc_worker_thread_.get(), config_.threads.worker, "rtc_worker");
+    startRtcThread(rtc_signaling_thread_.get(), config_.threads.signaling, "rtc_signaling");
     
     // Create PeerConnectionFactory
     peer_connection_factory_ = webrtc::CreatePeerConnectionFactory(
-        network_thread.get(),
-        worker_thread.get(),
-        signaling_thread.get(),
+        rtc_network_thread_.get(),
+        rtc_worker_thread_.get(),
+        rtc_signaling_thread_.get(),
         nullptr,
         webrtc::CreateBuiltinAudioEncoderFactory(),
         webrtc::CreateBuiltinAudioDecoderFactory(),
-        std::make_unique<webrtc::SimpleVideoEncoderFactory>(),
+        std::make_unique<webrtc::SimpleVideoEncoderFactory>(config_.encoder, config_.threads.encoder, key_frames_),
         std::make_unique<webrtc::SimpleVideoDecoderFactory>(),
         nullptr, nullptr
     );
     
     if (!peer_connection_factory_) {
-        std::cerr << "Failed to create PeerConnectionFactory" << std::endl;
+        LOG_ERROR("Failed to create PeerConnectionFactory");
         return false;
     }
     
-    std::cout << "✅ WebRTC initialized successfully" << std::endl;
-    
-    // Keep threads alive
-    network_thread.release();
-    worker_thread.release();
-    signaling_thread.release();
-    
+    LOG_INFO("✅ WebRTC initialized successfully");
     return true;
 }
 
@@ -321,64 +329,257 @@ bool WebRTCClient::createPeerConnection() {
     config.ice_candidate_pool_size = 4;
     
     // Add ICE servers
-    for (const auto& ice_server : webrtc_config_.ice_servers) {
+    config.servers = iceServers();
+    
+    // Create observer
+    pc_observer_ = std::make_shared<PeerConnectionObserver>(this);
+    
+    // Create PeerConnection
+    peer_connection_ = peer_connection_factory_->CreatePeerConnection(
+        config, nullptr, nullptr, pc_observer_.get()
+    );
+    
+    if (!peer_connection_) {
+        LOG_ERROR("Failed to create PeerConnection");
+        return false;
+    }
+    
+    LOG_INFO("✅ PeerConnection created");
+    
+    const ResilienceConfig& resilience = config_.resilience;
+    if (resilience.start_bitrate_kbps > 0 || resilience.min_bitrate_kbps > 0 ||
+        resilience.max_bitrate_kbps > 0) {
+        applyBitrateLimits();
+    }
+    return true;
+}
+
+std::vector<webrtc::PeerConnectionInterface::IceServer> WebRTCClient::iceServers() const {
+    std::vector<webrtc::PeerConnectionInterface::IceServer> servers;
+    for (const auto& ice_server : config_.webrtc.ice_servers) {
         webrtc::PeerConnectionInterface::IceServer server;
         server.urls = ice_server.urls;
         
         if (!ice_server.username.empty()) {
             server.username = ice_server.username;
             server.password = ice_server.credential;
-            std::cout << "🔐 Adding TURN server: " << ice_server.urls[0] 
-                      << " (user: " << ice_server.username << ")" << std::endl;
+            LOG_INFO("🔐 Adding TURN server: " << ice_server.urls[0] 
+                     << " (user: " << ice_server.username << ")");
         } else {
-            std::cout << "🌐 Adding STUN server: " << ice_server.urls[0] << std::endl;
+            LOG_INFO("🌐 Adding STUN server: " << ice_server.urls[0]);
         }
         
-        config.servers.push_back(server);
+        servers.push_back(server);
+    }
+    return servers;
+}
+
+void WebRTCClient::applyBitrateLimits() {
+    // 带宽估计的起始值与上下限（整个连接共用）；未设置的项交给 WebRTC 默认值
+    const ResilienceConfig& resilience = config_.resilience;
+    webrtc::BitrateSettings bitrate;
+    if (resilience.min_bitrate_kbps > 0) {
+        bitrate.min_bitrate_bps = resilience.min_bitrate_kbps * 1000;
+    }
+    if (resilience.start_bitrate_kbps > 0) {
+        bitrate.start_bitrate_bps = resilience.start_bitrate_kbps * 1000;
+    }
+    if (resilience.max_bitrate_kbps > 0) {
+        bitrate.max_bitrate_bps = resilience.max_bitrate_kbps * 1000;
+    }
+    webrtc::RTCError error = peer_connection_->SetBitrate(bitrate);
+    if (!error.ok()) {
+        LOG_WARN("⚠️  Failed to set bitrate limits: " << error.message());
+    }
+}
+
+rtc::scoped_refptr<webrtc::RtpTransceiverInterface> WebRTCClient::findTransceiver(
+    VideoTrackContext* track) const {
+    for (const auto& transceiver : peer_connection_->GetTransceivers()) {
+        if (transceiver->sender() == track->sender) {
+            return transceiver;
+        }
+    }
+    return nullptr;
+}
+
+bool WebRTCClient::enablePlayoutDelayExtension(VideoTrackContext* track) {
+    rtc::scoped_refptr<webrtc::RtpTransceiverInterface> transceiver = findTransceiver(track);
+    if (!transceiver) {
+        return false;
     }
     
-    // Create observer
-    pc_observer_ = std::make_shared<PeerConnectionObserver>(this);
-    
-    // Create PeerConnection
-    peer_connection_ = peer_connection_factory_->CreatePeerConnection(
-        config, nullptr, nullptr, pc_observer_.get()
-    );
+    // 编码器在每帧上标记了播放延迟，扩展必须出现在 offer 中接收端才能看到
+    std::vector<webrtc::RtpHeaderExtensionCapability> extensions = transceiver->HeaderExtensionsToOffer();
+    auto it = std::find_if(extensions.begin(), extensions.end(),
+                           [](const webrtc::RtpHeaderExtensionCapability& extension) {
+                               return extension.uri == webrtc::RtpExtension::kPlayoutDelayUri;
+                           });
+    if (it == extensions.end()) {
+        LOG_WARN("⚠️  playout-delay header extension not offered by this WebRTC build");
+        return false;
+    }
+    if (it->direction == webrtc::RtpTransceiverDirection::kStopped) {
+        it->direction = webrtc::RtpTransceiverDirection::kSendRecv;
+        webrtc::RTCError error = transceiver->SetOfferedRtpHeaderExtensions(extensions);
+        if (!error.ok()) {
+            LOG_WARN("⚠️  Failed to enable playout-delay extension for " << track->track_id
+                     << ": " << error.message());
+            return false;
+        }
+    }
+    LOG_INFO("⏱️  Playout delay " << config_.encoder.playout_delay_ms << " ms ("
+             << track->track_id << ")");
+    return true;
+}
+
+bool WebRTCClient::applyCodecPreferences(VideoTrackContext* track) {
+    const ResilienceConfig& resilience = config_.resilience;
+    // 与 WebRTC 默认一致时不设置，保持原有 SDP
+    if (resilience.codec_preferences.empty() && resilience.rtx && resilience.red_ulpfec &&
+        !resilience.flexfec) {
+        return true;
+    }
     
-    if (!peer_connection_) {
-        std::cerr << "Failed to create PeerConnection" << std::endl;
+    rtc::scoped_refptr<webrtc::RtpTransceiverInterface> transceiver = findTransceiver(track);
+    if (!transceiver) {
         return false;
     }
     
-    std::cout << "✅ PeerConnection created" << std::endl;
+    webrtc::RtpCapabilities capabilities =
+        peer_connection_factory_->GetRtpSenderCapabilities(cricket::MEDIA_TYPE_VIDEO);
+    
+    // 按配置顺序排列编码格式，未列出的排在后面（保证对端至少能协商出一种）
+    std::vector<webrtc::RtpCodecCapability> codecs;
+    for (const auto& name : resilience.codec_preferences) {
+        for (const auto& codec : capabilities.codecs) {
+            if (sameCodecName(codec.name, name)) {
+                codecs.push_back(codec);
+            }
+        }
+    }
+    std::vector<webrtc::RtpCodecCapability> protection;
+    for (const auto& codec : capabilities.codecs) {
+        if (sameCodecName(codec.name, "rtx")) {
+            if (resilience.rtx) {
+                protection.push_back(codec);
+            }
+        } else if (sameCodecName(codec.name, "red") || sameCodecName(codec.name, "ulpfec")) {
+            if (resilience.red_ulpfec) {
+                protection.push_back(codec);
+            }
+        } else if (sameCodecName(codec.name, "flexfec-03")) {
+            if (resilience.flexfec) {
+                protection.push_back(codec);
+            }
+        } else if (std::find(codecs.begin(), codecs.end(), codec) == codecs.end()) {
+            codecs.push_back(codec);
+        }
+    }
+    if (resilience.flexfec &&
+        std::none_of(protection.begin(), protection.end(), [](const webrtc::RtpCodecCapability& codec) {
+            return sameCodecName(codec.name, "flexfec-03");
+        })) {
+        LOG_WARN("⚠️  FlexFEC not offered by this WebRTC build");
+    }
+    codecs.insert(codecs.end(), protection.begin(), protection.end());
+    
+    webrtc::RTCError error = transceiver->SetCodecPreferences(codecs);
+    if (!error.ok()) {
+        LOG_WARN("⚠️  Failed to set codec preferences for " << track->track_id
+                 << ": " << error.message());
+        return false;
+    }
+    std::string names;
+    for (const auto& codec : codecs) {
+        names += " " + codec.name;
+    }
+    LOG_INFO("🎞️  Codec preferences (" << track->track_id << "):" << names);
     return true;
 }
 
-bool WebRTCClient::addVideoTrack() {
+bool WebRTCClient::addVideoTracks() {
+    for (auto& track : tracks_) {
+        if (!addVideoTrack(track.get())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool WebRTCClient::addVideoTrack(VideoTrackContext* track) {
     // Create custom video source
-    custom_video_source_ = new rtc::RefCountedObject<CustomVideoSource>();
+    track->track_source = new rtc::RefCountedObject<CustomVideoSource>();
+    track->track_source->setMjpegTargetResolution(track->config.mjpeg_scale_width,
+                                                  track->config.mjpeg_scale_height);
+    track->track_source->setCropConfig(track->config.crop);
+    track->track_source->setTimestampOverlay(track->config.timestamp_overlay);
+    if (config_.static_scene.enabled) {
+        track->track_source->enableStaticSceneDetection(config_.static_scene, track->track_id);
+    }
     
     // Create video track
     rtc::scoped_refptr<webrtc::VideoTrackInterface> video_track =
         peer_connection_factory_->CreateVideoTrack(
-            "video_track", 
-            custom_video_source_.get()
+            track->track_id, 
+            track->track_source.get()
         );
     
     if (!video_track) {
-        std::cerr << "Failed to create video track" << std::endl;
+        LOG_ERROR("Failed to create video track: " << track->track_id);
         return false;
     }
     
-    // Add track to peer connection
-    auto result = peer_connection_->AddTrack(video_track, {"stream_id"});
+    // Add track to peer connection（每路独立的 stream，接收端按 msid 区分）
+    std::string stream_id = tracks_.size() == 1 ? "stream_id" : track->track_id;
+    auto result = peer_connection_->AddTrack(video_track, {stream_id});
     if (!result.ok()) {
-        std::cerr << "Failed to add track: " << result.error().message() << std::endl;
+        LOG_ERROR("Failed to add track: " << result.error().message());
         return false;
     }
     
-    video_track_ = video_track;
-    std::cout << "✅ Video track added" << std::endl;
+    track->track = video_track;
+    track->sender = result.value();
+    applyCodecPreferences(track);
+    if (config_.encoder.playout_delay_ms >= 0) {
+        enablePlayoutDelayExtension(track);
+    }
+    
+    // 所有轨道共用一个拥塞控制器，按 bitrate_priority 比例分配可用带宽
+    // degradation_preference 决定 CPU 过载时是否允许 WebRTC 降低编码分辨率
+    webrtc::RtpParameters parameters = track->sender->GetParameters();
+    for (auto& encoding : parameters.encodings) {
+        encoding.bitrate_priority = track->config.bitrate_priority;
+    }
+    // 启用自适应控制时由其策略决定，保证 WebRTC 内部降级与控制器的取舍一致
+    const std::string degradation = adaptation_ ? adaptation_->degradationPreference()
+                                                : config_.encoder.degradation_preference;
+    parameters.degradation_preference = parseDegradationPreference(degradation);
+    webrtc::RTCError error = track->sender->SetParameters(parameters);
+    if (!error.ok()) {
+        LOG_WARN("⚠️  Failed to set sender parameters for " << track->track_id
+                 << ": " << error.message());
+    }
+    LOG_INFO("✅ Video track added: " << track->track_id
+             << " (bitrate priority " << track->config.bitrate_priority
+             << ", degradation " << degradation << ")");
+    
+    // 录制：在编码器与打包器之间旁路已编码帧，不做二次编码
+    if (config_.recording.enabled) {
+        RecordingConfig recording = config_.recording;
+        if (tracks_.size() > 1) {
+            recording.prefix += "_" + track->track_id;
+        }
+        track->recorder = std::make_shared<EncodedRecorder>(recording);
+        if (track->recorder->start()) {
+            track->recording_transformer =
+                new rtc::RefCountedObject<RecordingFrameTransformer>(track->recorder, "");
+            track->sender->SetEncoderToPacketizerFrameTransformer(track->recording_transformer);
+        } else {
+            LOG_WARN("⚠️  Recording disabled for " << track->track_id);
+            track->recorder.reset();
+        }
+    }
     
     return true;
 }
@@ -389,7 +590,7 @@ void WebRTCClient::createOffer() {
     options.offer_to_receive_video = 0;  // 明确设置为 0（不接收）
     options.offer_to_receive_audio = 0;  // 明确设置为 0（不接收）
     
-    std::cout << "📤 Creating offer (sendonly mode)" << std::endl;
+    LOG_INFO("📤 Creating offer (sendonly mode)");
     
     rtc::scoped_refptr<CreateSessionDescriptionObserver> observer(
         new rtc::RefCountedObject<CreateSessionDescriptionObserver>(this)
@@ -404,39 +605,19 @@ void WebRTCClient::OnOfferCreated(webrtc::SessionDescriptionInterface* desc) {
     desc->ToString(&sdp);
     
     // 打印原始 Offer SDP
-    std::cout << "📤 Offer SDP (before modification):" << std::endl;
-    std::cout << sdp << std::endl;
+    LOG_DEBUG("📤 Offer SDP (before modification):\n" << sdp);
     
     // 确保 SDP 中设置为 sendonly
-    // 查找并替换 a=sendrecv 或 a=recvonly 为 a=sendonly
-    size_t pos = 0;
-    while ((pos = sdp.find("a=sendrecv", pos)) != std::string::npos) {
-        sdp.replace(pos, 10, "a=sendonly");
-        std::cout << "✏️  Modified: sendrecv → sendonly" << std::endl;
-        pos += 10;
+    int direction_changes = forceSendOnlyDirection(sdp);
+    if (direction_changes > 0) {
+        LOG_INFO("✏️  Modified " << direction_changes 
+                 << " direction attribute(s) → sendonly");
     }
     
-    pos = 0;
-    while ((pos = sdp.find("a=recvonly", pos)) != std::string::npos) {
-        sdp.replace(pos, 10, "a=sendonly");
-        std::cout << "✏️  Modified: recvonly → sendonly" << std::endl;
-        pos += 10;
-    }
-    
-    // 如果没有任何方向属性，添加 sendonly
-    if (sdp.find("a=sendonly") == std::string::npos && 
-        sdp.find("a=recvonly") == std::string::npos &&
-        sdp.find("a=sendrecv") == std::string::npos) {
-        
-        // 在第一个 m= 行之后添加 a=sendonly
-        size_t m_line = sdp.find("m=video");
-        if (m_line != std::string::npos) {
-            size_t next_line = sdp.find("\r\n", m_line);
-            if (next_line != std::string::npos) {
-                sdp.insert(next_line + 2, "a=sendonly\r\n");
-                std::cout << "➕ Added: a=sendonly" << std::endl;
-            }
-        }
+    // 关闭 NACK：去掉通用 NACK 反馈，接收端不再请求重传（保留 nack pli）
+    if (!config_.resilience.nack) {
+        int removed = removeNackFeedback(sdp);
+        LOG_INFO("✏️  Removed " << removed << " NACK feedback line(s)");
     }
     
     // 重新创建 SessionDescription
@@ -445,14 +626,13 @@ void WebRTCClient::OnOfferCreated(webrtc::SessionDescriptionInterface* desc) {
         webrtc::CreateSessionDescription(webrtc::SdpType::kOffer, sdp, &error);
     
     if (!modified_desc) {
-        std::cerr << "❌ Failed to parse modified SDP: " << error.description << std::endl;
+        LOG_ERROR("❌ Failed to parse modified SDP: " << error.description);
         return;
     }
     
-    std::cout << "📤 Offer SDP (after modification):" << std::endl;
     std::string final_sdp;
     modified_desc->ToString(&final_sdp);
-    std::cout << final_sdp << std::endl;
+    LOG_DEBUG("📤 Offer SDP (after modification):\n" << final_sdp);
     
     // Set local description
     rtc::scoped_refptr<SetSessionDescriptionObserver> observer(
@@ -466,11 +646,11 @@ void WebRTCClient::OnOfferCreated(webrtc::SessionDescriptionInterface* desc) {
     json << "{\"type\":\"offer\",\"sdp\":\"" << escapeJsonString(final_sdp) << "\"";
     
     // 如果指定了目标 ID，添加到消息中
-    if (!webrtc_config_.target_id.empty()) {
-        json << ",\"target_id\":\"" << webrtc_config_.target_id << "\"";
-        std::cout << "📤 Sending offer to: " << webrtc_config_.target_id << std::endl;
+    if (!config_.webrtc.target_id.empty()) {
+        json << ",\"target_id\":\"" << config_.webrtc.target_id << "\"";
+        LOG_INFO("📤 Sending offer to: " << config_.webrtc.target_id);
     } else {
-        std::cout << "📤 Broadcasting offer to all receivers" << std::endl;
+        LOG_INFO("📤 Broadcasting offer to all receivers");
     }
     
     json << "}";
@@ -479,7 +659,394 @@ void WebRTCClient::OnOfferCreated(webrtc::SessionDescriptionInterface* desc) {
 }
 
 void WebRTCClient::OnAnswerSet() {
-    std::cout << "✅ Answer set successfully" << std::endl;
+    LOG_INFO("✅ Answer set successfully");
+    
+    // 协商完成后才知道实际发送的编码格式
+    for (auto& track : tracks_) {
+        if (track->recording_transformer && track->sender) {
+            webrtc::RtpParameters parameters = track->sender->GetParameters();
+            if (!parameters.codecs.empty()) {
+                track->recording_transformer->setCodec(parameters.codecs[0].name);
+            }
+        }
+    }
+}
+
+bool WebRTCClient::createControlChannel() {
+    webrtc::DataChannelInit init;
+    init.ordered = true;
+    auto result = peer_connection_->CreateDataChannelOrError("control", &init);
+    if (!result.ok()) {
+        LOG_WARN("⚠️  Failed to create control channel: " << result.error().message());
+        return false;
+    }
+    OnDataChannel(result.MoveValue());
+    return true;
+}
+
+bool WebRTCClient::createTelemetryChannel() {
+    // 无序、不重传：丢失的批次直接跳过，不会阻塞后面更新的数据
+    webrtc::DataChannelInit init;
+    init.ordered = false;
+    init.maxRetransmits = 0;
+    auto result = peer_connection_->CreateDataChannelOrError("telemetry", &init);
+    if (!result.ok()) {
+        LOG_WARN("⚠️  Failed to create telemetry channel: " << result.error().message());
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(telemetry_mutex_);
+    telemetry_channel_ = result.MoveValue();
+    return true;
+}
+
+void WebRTCClient::sendTelemetry(const uint8_t* data, size_t size) {
+    rtc::scoped_refptr<webrtc::DataChannelInterface> channel;
+    {
+        std::lock_guard<std::mutex> lock(telemetry_mutex_);
+        channel = telemetry_channel_;
+    }
+    if (!channel || channel->state() != webrtc::DataChannelInterface::kOpen) {
+        return;
+    }
+    // SCTP 发送缓冲区有积压时丢弃，过时的传感器数据不值得排队
+    if (channel->buffered_amount() > kMaxTelemetryBufferedBytes) {
+        return;
+    }
+    channel->Send(webrtc::DataBuffer(rtc::CopyOnWriteBuffer(data, size), true));
+}
+
+void WebRTCClient::startTelemetry() {
+    telemetry_ = std::make_shared<SensorTelemetry>(config_.telemetry);
+    for (auto& track : tracks_) {
+        // 只接第一路能提供传感器数据的源（目前为 RealSense）
+        if (track->source->attachTelemetry(telemetry_)) {
+            LOG_INFO("📡 Telemetry source: " << track->track_id);
+            telemetry_->start([this](const uint8_t* data, size_t size) {
+                sendTelemetry(data, size);
+            });
+            return;
+        }
+    }
+    LOG_WARN("⚠️  Telemetry enabled but no video source provides sensor data");
+    telemetry_.reset();
+}
+
+void WebRTCClient::OnDataChannel(rtc::scoped_refptr<webrtc::DataChannelInterface> channel) {
+    if (channel->label() != "control") {
+        LOG_INFO("Ignoring data channel '" << channel->label() << "'");
+        return;
+    }
+    auto control = std::make_unique<ControlChannel>(channel,
+        [this](const ControlCommand& command, std::string& error) {
+            return handleControlCommand(command, error);
+        });
+    std::lock_guard<std::mutex> lock(control_mutex_);
+    control_channels_.push_back(std::move(control));
+}
+
+bool WebRTCClient::updateEncodings(VideoTrackContext* track,
+                                   const std::function<void(webrtc::RtpEncodingParameters&)>& update,
+                                   std::string& error) {
+    if (!track->sender) {
+        error = "track " + track->track_id + " has no sender";
+        return false;
+    }
+    webrtc::RtpParameters parameters = track->sender->GetParameters();
+    for (auto& encoding : parameters.encodings) {
+        update(encoding);
+    }
+    webrtc::RTCError result = track->sender->SetParameters(parameters);
+    if (!result.ok()) {
+        error = result.message();
+        return false;
+    }
+    return true;
+}
+
+bool WebRTCClient::applyEncodingLimits(VideoTrackContext* track, std::string& error) {
+    // 控制通道的设置是上限，自适应控制只会在其基础上进一步降低
+    double scale = track->control_scale;
+    double max_fps = track->control_max_fps;
+    if (track->config_max_fps > 0) {
+        max_fps = max_fps > 0 ? std::min(max_fps, track->config_max_fps) : track->config_max_fps;
+    }
+    if (adaptation_) {
+        const AdaptationLevel& level = adaptation_->level();
+        scale = std::max(scale, level.scale);
+        if (level.fps_factor < 1.0) {
+            int source_fps = track->source->getFrameRate() > 0 ? track->source->getFrameRate()
+                                                               : track->config.fps;
+            double adaptive_fps = std::max(1.0, source_fps * level.fps_factor);
+            max_fps = max_fps > 0 ? std::min(max_fps, adaptive_fps) : adaptive_fps;
+        }
+    }
+    return updateEncodings(track, [&](webrtc::RtpEncodingParameters& encoding) {
+        encoding.scale_resolution_down_by = scale;
+        encoding.max_framerate = max_fps > 0 ? absl::optional<double>(max_fps) : absl::nullopt;
+    }, error);
+}
+
+void WebRTCClient::adaptationThread() {
+    applyThreadSettings(config_.threads.adaptation, "adaptation");
+    const auto interval = std::chrono::milliseconds(std::max(config_.adaptation.interval_ms, 100));
+    auto next_poll = std::chrono::steady_clock::now() + interval;
+    
+    while (!should_stop_) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        if (std::chrono::steady_clock::now() < next_poll) {
+            continue;
+        }
+        next_poll += interval;
+        
+        // 结果在 signaling 线程回调 OnStatsDelivered
+        if (peer_connected_ && peer_connection_) {
+            peer_connection_->GetStats(rtc::scoped_refptr<StatsCallback>(
+                new rtc::RefCountedObject<StatsCallback>(this)).get());
+        }
+    }
+}
+
+void WebRTCClient::OnStatsDelivered(const rtc::scoped_refptr<const webrtc::RTCStatsReport>& report) {
+    if (!adaptation_ || should_stop_) {
+        return;
+    }
+    
+    LinkStats stats;
+    // 多路轨道共用一条链路：取最差的 RTT / 丢包
+    for (const auto* remote : report->GetStatsOfType<webrtc::RTCRemoteInboundRtpStreamStats>()) {
+        if (remote->kind.is_defined() && *remote->kind != "video") {
+            continue;
+        }
+        if (remote->round_trip_time.is_defined()) {
+            stats.rtt_ms = std::max(stats.rtt_ms, *remote->round_trip_time * 1000.0);
+        }
+        if (remote->fraction_lost.is_defined()) {
+            stats.loss = std::max(stats.loss, *remote->fraction_lost);
+        }
+    }
+    for (const auto* pair : report->GetStatsOfType<webrtc::RTCIceCandidatePairStats>()) {
+        if (!pair->nominated.is_defined() || !*pair->nominated) {
+            continue;
+        }
+        if (pair->available_outgoing_bitrate.is_defined()) {
+            stats.available_bitrate_bps = static_cast<int64_t>(*pair->available_outgoing_bitrate);
+        }
+        // 还没有 RTCP RR 时用 STUN 测得的 RTT
+        if (stats.rtt_ms < 0 && pair->current_round_trip_time.is_defined()) {
+            stats.rtt_ms = *pair->current_round_trip_time * 1000.0;
+        }
+    }
+    uint64_t bytes_sent = 0;
+    for (const auto* outbound : report->GetStatsOfType<webrtc::RTCOutboundRTPStreamStats>()) {
+        if (outbound->kind.is_defined() && *outbound->kind != "video") {
+            continue;
+        }
+        if (outbound->bytes_sent.is_defined()) {
+            bytes_sent += *outbound->bytes_sent;
+        }
+        if (outbound->quality_limitation_reason.is_defined() &&
+            (stats.quality_limitation.empty() || stats.quality_limitation == "none")) {
+            stats.quality_limitation = *outbound->quality_limitation_reason;
+        }
+    }
+    const int64_t now_us = report->timestamp_us();
+    if (last_stats_us_ > 0 && now_us > last_stats_us_ && bytes_sent >= last_bytes_sent_) {
+        stats.sent_bitrate_bps = static_cast<int64_t>((bytes_sent - last_bytes_sent_) * 8 * 1000000 /
+                                                      (now_us - last_stats_us_));
+    }
+    last_bytes_sent_ = bytes_sent;
+    last_stats_us_ = now_us;
+    
+    if (!adaptation_->update(stats, now_us / 1000)) {
+        return;
+    }
+    for (auto& track : tracks_) {
+        std::string error;
+        if (!applyEncodingLimits(track.get(), error)) {
+            LOG_WARN("⚠️  Failed to apply adaptation to " << track->track_id << ": " << error);
+        }
+    }
+}
+
+std::vector<std::string> WebRTCClient::applyConfig(const AppConfig& next,
+                                                   const std::vector<std::string>& changed) {
+    if (!rtc_signaling_thread_) {
+        return changed;
+    }
+    // 与控制通道命令、自适应控制同在 signaling 线程修改编码参数，互不覆盖
+    std::vector<std::string> restart;
+    rtc_signaling_thread_->Invoke<void>(RTC_FROM_HERE, [&] {
+        bool ice_servers = false;
+        bool bitrate_limits = false;
+        bool videos = false;
+        size_t video_index = 0;
+        std::string video_setting;
+        for (const auto& field : changed) {
+            if (field.rfind("webrtc.ice_servers", 0) == 0) {
+                ice_servers = true;
+            } else if (field == "resilience.start_bitrate_kbps" || field == "resilience.min_bitrate_kbps" ||
+                       field == "resilience.max_bitrate_kbps") {
+                bitrate_limits = true;
+            } else if (field == "encoder.degradation_preference") {
+                // 启用自适应控制时降级策略由其决定，配置值不生效
+                config_.encoder.degradation_preference = next.encoder.degradation_preference;
+                for (auto& track : tracks_) {
+                    if (track->sender && !adaptation_) {
+                        webrtc::RtpParameters parameters = track->sender->GetParameters();
+                        parameters.degradation_preference =
+                            parseDegradationPreference(config_.encoder.degradation_preference);
+                        webrtc::RTCError result = track->sender->SetParameters(parameters);
+                        if (!result.ok()) {
+                            LOG_WARN("⚠️  Failed to set degradation preference for " << track->track_id
+                                     << ": " << result.message());
+                        }
+                    }
+                }
+            } else if (field.rfind("logging.", 0) == 0) {
+                config_.logging = next.logging;
+                Logger::instance().configure(config_.logging);
+            } else if (field == "tracing.enabled") {
+                config_.tracing.enabled = next.tracing.enabled;
+                LatencyTracer::instance().setEnabled(config_.tracing.enabled);
+            } else if (parseVideoField(field, video_index, video_setting) &&
+                       (video_index == 0 || !config_.mosaic.enabled) &&
+                       (video_setting == "fps" || video_setting == "bitrate_priority" ||
+                        video_setting == "timestamp_overlay" || video_setting == "crop" ||
+                        video_setting.rfind("crop.", 0) == 0)) {
+                videos = true;
+            } else {
+                restart.push_back(field);
+            }
+        }
+        
+        if (ice_servers) {
+            // 只影响之后的 ICE 收集（ICE restart 或下一次会话），当前连接不受影响
+            config_.webrtc.ice_servers = next.webrtc.ice_servers;
+            if (peer_connection_) {
+                webrtc::PeerConnectionInterface::RTCConfiguration configuration =
+                    peer_connection_->GetConfiguration();
+                configuration.servers = iceServers();
+                webrtc::RTCError error = peer_connection_->SetConfiguration(configuration);
+                if (!error.ok()) {
+                    LOG_WARN("⚠️  Failed to update ICE servers: " << error.message());
+                    restart.push_back("webrtc.ice_servers");
+                }
+            }
+        }
+        if (bitrate_limits) {
+            config_.resilience.start_bitrate_kbps = next.resilience.start_bitrate_kbps;
+            config_.resilience.min_bitrate_kbps = next.resilience.min_bitrate_kbps;
+            config_.resilience.max_bitrate_kbps = next.resilience.max_bitrate_kbps;
+            if (peer_connection_) {
+                applyBitrateLimits();
+            }
+        }
+        if (videos) {
+            // 马赛克模式只有一路合成轨道，沿用主视频的设置；各小窗源的设置（video.<i>.*）需要重启
+            std::vector<VideoConfig> next_videos = {next.video};
+            if (!config_.mosaic.enabled) {
+                next_videos.insert(next_videos.end(), next.extra_videos.begin(), next.extra_videos.end());
+            }
+            if (next_videos.size() != tracks_.size()) {
+                restart.push_back("video");
+            } else {
+                for (size_t i = 0; i < tracks_.size(); i++) {
+                    applyVideoConfig(tracks_[i].get(), next_videos[i],
+                                     i == 0 ? "video" : "video." + std::to_string(i), restart);
+                }
+            }
+        }
+    });
+    
+    std::sort(restart.begin(), restart.end());
+    restart.erase(std::unique(restart.begin(), restart.end()), restart.end());
+    return restart;
+}
+
+bool WebRTCClient::applyVideoConfig(VideoTrackContext* track, const VideoConfig& next,
+                                    const std::string& field_prefix, std::vector<std::string>& restart) {
+    VideoConfig& current = track->config;
+    std::string error;
+    bool ok = true;
+    
+    if (next.fps != current.fps) {
+        // 采集帧率在打开设备时确定，在线只能通过 max_framerate 往下限
+        int source_fps = track->source->getFrameRate() > 0 ? track->source->getFrameRate() : current.fps;
+        if (next.fps > source_fps) {
+            restart.push_back(field_prefix + ".fps");
+        } else {
+            track->config_max_fps = next.fps < source_fps ? next.fps : 0;
+            current.fps = next.fps;
+            ok = applyEncodingLimits(track, error) && ok;
+        }
+    }
+    if (next.bitrate_priority != current.bitrate_priority) {
+        current.bitrate_priority = next.bitrate_priority;
+        ok = updateEncodings(track, [&](webrtc::RtpEncodingParameters& encoding) {
+            encoding.bitrate_priority = current.bitrate_priority;
+        }, error) && ok;
+    }
+    const CropConfig& crop = next.crop;
+    if (crop.x != current.crop.x || crop.y != current.crop.y || crop.width != current.crop.width ||
+        crop.height != current.crop.height || crop.output_width != current.crop.output_width ||
+        crop.output_height != current.crop.output_height || crop.transition_ms != current.crop.transition_ms) {
+        current.crop = crop;
+        if (track->track_source) {
+            track->track_source->setCropConfig(current.crop);
+        }
+    }
+    if (next.timestamp_overlay != current.timestamp_overlay) {
+        current.timestamp_overlay = next.timestamp_overlay;
+        if (track->track_source) {
+            track->track_source->setTimestampOverlay(current.timestamp_overlay);
+        }
+    }
+    
+    if (!ok) {
+        LOG_WARN("⚠️  Failed to apply video settings to " << track->track_id << ": " << error);
+    }
+    return ok;
+}
+
+bool WebRTCClient::handleControlCommand(const ControlCommand& command, std::string& error) {
+    if (command.cmd == "keyframe") {
+        key_frames_->request();
+        return true;
+    }
+    
+    bool matched = false;
+    for (auto& track : tracks_) {
+        if (!command.track.empty() && command.track != track->track_id) {
+            continue;
+        }
+        matched = true;
+        
+        bool ok = true;
+        if (command.cmd == "bitrate") {
+            ok = updateEncodings(track.get(), [&](webrtc::RtpEncodingParameters& encoding) {
+                encoding.max_bitrate_bps = command.max_kbps > 0
+                    ? absl::optional<int>(command.max_kbps * 1000) : absl::nullopt;
+            }, error);
+        } else if (command.cmd == "fps") {
+            track->control_max_fps = command.max_fps;
+            ok = applyEncodingLimits(track.get(), error);
+        } else if (command.cmd == "scale") {
+            track->control_scale = command.scale;
+            ok = applyEncodingLimits(track.get(), error);
+        } else if (command.cmd == "crop") {
+            track->track_source->setCropWindow(command.crop_x, command.crop_y,
+                                               command.crop_width, command.crop_height);
+        }
+        if (!ok) {
+            return false;
+        }
+    }
+    
+    if (!matched) {
+        error = "unknown track: " + command.track;
+        return false;
+    }
+    return true;
 }
 
 void WebRTCClient::OnIceCandidate(const webrtc::IceCandidateInterface* candidate) {
@@ -494,15 +1061,27 @@ void WebRTCClient::OnIceCandidate(const webrtc::IceCandidateInterface* candidate
          << "}}";
     
     sendMessage(json.str());
-    RTC_LOG(LS_INFO) << "ICE candidate sent";
+    LOG_DEBUG("📤 ICE candidate sent");
 }
 
 void WebRTCClient::OnConnectionChange(bool connected) {
     peer_connected_ = connected;
     if (connected) {
-        std::cout << "✅ WebRTC peer connected!" << std::endl;
+        LOG_INFO("✅ WebRTC peer connected!");
     } else {
-        std::cout << "⚠️  WebRTC peer disconnected" << std::endl;
+        LOG_WARN("⚠️  WebRTC peer disconnected");
+    }
+}
+
+void WebRTCClient::OnPeerJoined() {
+    // 新观众或断线重连：不等接收端 PLI 往返，立即编码关键帧；
+    // 重发最近一帧，关键帧不必等到下一次采集（静止画面时可能要等一个保活周期）
+    LOG_INFO("🔑 Peer joined, sending key frame");
+    key_frames_->request();
+    for (auto& track : tracks_) {
+        if (track->track_source) {
+            track->track_source->repeatLastFrame();
+        }
     }
 }
 
@@ -514,11 +1093,25 @@ bool WebRTCClient::start() {
     should_stop_ = false;
     is_streaming_ = true;
     
+    // 传感器数据源须在采集线程启动前接上
+    if (config_.telemetry.enabled) {
+        startTelemetry();
+    }
+    // 控制器须在添加轨道（signaling 线程）之前创建，轨道的降级策略取自它
+    if (config_.adaptation.enabled) {
+        adaptation_ = std::make_unique<AdaptationController>(config_.adaptation);
+    }
+    
     // Start threads
     signaling_thread_ = std::thread(&WebRTCClient::signalingThread, this);
-    streaming_thread_ = std::thread(&WebRTCClient::captureAndEncodeFrames, this);
+    for (auto& track : tracks_) {
+        track->capture_thread = std::thread(&WebRTCClient::captureAndEncodeFrames, this, track.get());
+    }
+    if (adaptation_) {
+        adaptation_thread_ = std::thread(&WebRTCClient::adaptationThread, this);
+    }
     
-    std::cout << "🚀 Streaming started" << std::endl;
+    LOG_INFO("🚀 Streaming started");
     return true;
 }
 
@@ -535,15 +1128,54 @@ void WebRTCClient::stop() {
         signaling_thread_.join();
     }
     
-    if (streaming_thread_.joinable()) {
-        streaming_thread_.join();
+    for (auto& track : tracks_) {
+        if (track->capture_thread.joinable()) {
+            track->capture_thread.join();
+        }
+    }
+    if (adaptation_thread_.joinable()) {
+        adaptation_thread_.join();
     }
     
+    if (telemetry_) {
+        telemetry_->stop();
+        for (auto& track : tracks_) {
+            track->source->attachTelemetry(nullptr);
+        }
+        telemetry_.reset();
+    }
+    rtc::scoped_refptr<webrtc::DataChannelInterface> telemetry_channel;
+    {
+        std::lock_guard<std::mutex> lock(telemetry_mutex_);
+        telemetry_channel.swap(telemetry_channel_);
+    }
+    if (telemetry_channel) {
+        telemetry_channel->Close();
+    }
+    
+    // 在锁外析构：注销观察者会同步切换到 signaling 线程，而该线程可能正在等待这把锁
+    std::vector<std::unique_ptr<ControlChannel>> control_channels;
+    {
+        std::lock_guard<std::mutex> lock(control_mutex_);
+        control_channels.swap(control_channels_);
+    }
+    control_channels.clear();
+    
     if (peer_connection_) {
         peer_connection_->Close();
         peer_connection_ = nullptr;
     }
     
+    // PeerConnection 关闭后不会再有编码帧，写完队列并关闭当前分段
+    for (auto& track : tracks_) {
+        track->sender = nullptr;
+        if (track->recorder) {
+            track->recorder->stop();
+            track->recorder.reset();
+            track->recording_transformer = nullptr;
+        }
+    }
+    
     if (ws_socket_ >= 0) {
         close(ws_socket_);
         ws_socket_ = -1;
@@ -551,49 +1183,56 @@ void WebRTCClient::stop() {
     
     rtc::CleanupSSL();
     
-    std::cout << "Streaming stopped" << std::endl;
+    LOG_INFO("Streaming stopped");
 }
 
-void WebRTCClient::captureAndEncodeFrames() {
-    std::cout << "Capture thread started" << std::endl;
+void WebRTCClient::captureAndEncodeFrames(VideoTrackContext* track) {
+    LOG_INFO("Capture thread started: " << track->track_id);
+    applyThreadSettings(config_.threads.capture, "cap_" + track->track_id);
     
-    auto frame_duration = std::chrono::milliseconds(33);  // ~30 fps
+    VideoSource* video_source = track->source.get();
+    int fps = video_source->getFrameRate() > 0 ? video_source->getFrameRate() : 30;
+    auto frame_duration = std::chrono::microseconds(1000000 / fps);
     auto next_frame_time = std::chrono::steady_clock::now();
     
+    // 帧缓冲区租自采集源，转换进 I420 池后立即归还，稳态下不分配内存
+    FrameLease lease;
     while (!should_stop_) {
-        cv::Mat frame;
-        if (video_source_->getFrame(frame) && !frame.empty()) {
-            frame_count_++;
-            
-            // Add timestamp
-            auto now = std::chrono::system_clock::now();
-            auto time_t_now = std::chrono::system_clock::to_time_t(now);
-            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-                now.time_since_epoch()) % 1000;
-            
-            char timestamp[100];
-            std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", 
-                         std::localtime(&time_t_now));
-            sprintf(timestamp + strlen(timestamp), ".%03d", static_cast<int>(ms.count()));
+        int64_t capture_begin_us = LatencyTracer::nowUs();
+        bool got_frame = video_source->acquireFrame(lease) && lease.valid();
+        int64_t capture_time_us = got_frame ? lease.captureTimeUs() : 0;
+        
+        if (got_frame) {
+            // 帧 ID 在各轨道间全局递增，取到帧后再分配
+            uint64_t frame_id = ++next_frame_id_;
+            track->frame_count++;
             
-            cv::putText(frame, timestamp, cv::Point(10, 30),
-                       cv::FONT_HERSHEY_SIMPLEX, 0.7, cv::Scalar(0, 255, 0), 2);
+            // 有内核时间戳时，采集阶段从曝光完成算起，而不是从调用 acquireFrame 算起
+            int64_t begin_us = capture_time_us > 0 ? std::min(capture_time_us, capture_begin_us)
+                                                   : capture_begin_us;
+            LatencyTracer::instance().record(TraceStage::kCapture, frame_id, begin_us, LatencyTracer::nowUs());
             
             // Push to WebRTC video source
-            if (custom_video_source_) {
-                custom_video_source_->PushFrame(frame);
+            if (track->track_source) {
+                track->track_source->PushFrame(lease.image(), lease.format(), frame_id, capture_time_us);
             }
+            lease.reset();
             
-            if (frame_count_ % 30 == 0) {
-                std::cout << "📹 Captured " << frame_count_ << " frames" << std::endl;
-            }
+            LOG_EVERY_MS(LogLevel::kInfo, 5000, "📹 [" << track->track_id << "] Captured "
+                         << track->frame_count << " frames");
         }
         
+        // 自行阻塞等待新帧的源（如共享内存）不再额外等待，避免增加一帧延迟；
+        // 取帧失败时仍按帧间隔等待，不空转
+        if (video_source->isSelfPaced() && got_frame) {
+            next_frame_time = std::chrono::steady_clock::now();
+            continue;
+        }
         next_frame_time += frame_duration;
         std::this_thread::sleep_until(next_frame_time);
     }
     
-    std::cout << "Capture thread stopped" << std::endl;
+    LOG_INFO("Capture thread stopped: " << track->track_id);
 }
 
 void WebRTCClient::sendMessage(const std::string& message) {
@@ -637,7 +1276,7 @@ std::string WebRTCClient::receiveMessage() {
     
     // 检查是否是 close frame (opcode 0x8)
     if (bytes >= 2 && (buffer[0] & 0x0F) == 0x8) {
-        std::cout << "⚠️  WebSocket close frame received" << std::endl;
+        LOG_WARN("⚠️  WebSocket close frame received");
         return "";
     }
     
@@ -645,26 +1284,27 @@ std::string WebRTCClient::receiveMessage() {
 }
 
 void WebRTCClient::signalingThread() {
-    std::cout << "Signaling thread started" << std::endl;
+    LOG_INFO("Signaling thread started");
+    applyThreadSettings(config_.threads.signaling, "ws_signaling");
     
     // Connect to WebSocket server
     ws_socket_ = socket(AF_INET, SOCK_STREAM, 0);
     if (ws_socket_ < 0) {
-        std::cerr << "Failed to create socket" << std::endl;
+        LOG_ERROR("Failed to create socket");
         return;
     }
     
     struct sockaddr_in server_addr;
     memset(&server_addr, 0, sizeof(server_addr));
     server_addr.sin_family = AF_INET;
-    server_addr.sin_port = htons(webrtc_config_.server_port);
-    inet_pton(AF_INET, webrtc_config_.server_ip.c_str(), &server_addr.sin_addr);
+    server_addr.sin_port = htons(config_.webrtc.server_port);
+    inet_pton(AF_INET, config_.webrtc.server_ip.c_str(), &server_addr.sin_addr);
     
-    std::cout << "Connecting to " << webrtc_config_.server_ip 
-              << ":" << webrtc_config_.server_port << "..." << std::endl;
+    LOG_INFO("Connecting to " << config_.webrtc.server_ip 
+             << ":" << config_.webrtc.server_port << "...");
     
     if (connect(ws_socket_, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
-        std::cerr << "Failed to connect: " << strerror(errno) << std::endl;
+        LOG_ERROR("Failed to connect: " << strerror(errno));
         close(ws_socket_);
         ws_socket_ = -1;
         return;
@@ -673,7 +1313,7 @@ void WebRTCClient::signalingThread() {
     // WebSocket handshake
     std::ostringstream handshake;
     handshake << "GET / HTTP/1.1\r\n"
-              << "Host: " << webrtc_config_.server_ip << "\r\n"
+              << "Host: " << config_.webrtc.server_ip << "\r\n"
               << "Upgrade: websocket\r\n"
               << "Connection: Upgrade\r\n"
               << "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
@@ -685,23 +1325,30 @@ void WebRTCClient::signalingThread() {
     char buffer[4096];
     recv(ws_socket_, buffer, sizeof(buffer), 0);
     
-    std::cout << "✅ WebSocket connected" << std::endl;
+    LOG_INFO("✅ WebSocket connected");
     
     // Register with server
     std::ostringstream register_msg;
     register_msg << "{\"type\":\"register\",\"client_id\":\"" 
-                 << webrtc_config_.client_id << "\"}";
+                 << config_.webrtc.client_id << "\"}";
     sendMessage(register_msg.str());
-    std::cout << "📤 Registered as: " << webrtc_config_.client_id << std::endl;
+    LOG_INFO("📤 Registered as: " << config_.webrtc.client_id);
     
     // Wait for registration confirmation
     std::string reg_response = receiveMessage();
-    std::cout << "📥 Server response: " << reg_response << std::endl;
+    LOG_INFO("📥 Server response: " << reg_response);
     
     // Create PeerConnection and add video track
-    if (!createPeerConnection() || !addVideoTrack()) {
+    if (!createPeerConnection() || !addVideoTracks()) {
         return;
     }
+    // DataChannel 必须在 offer 之前创建，SDP 中才会包含 SCTP 段
+    if (config_.webrtc.control_channel) {
+        createControlChannel();
+    }
+    if (telemetry_) {
+        createTelemetryChannel();
+    }
     
     // Create and send offer
     createOffer();
@@ -723,9 +1370,7 @@ void WebRTCClient::signalingThread() {
             continue;
         }
         
-        std::cout << "📥 Received: " << message.substr(0, 100);
-        if (message.length() > 100) std::cout << "...";
-        std::cout << std::endl;
+        LOG_DEBUG("📥 Received: " << message.substr(0, 100) << (message.length() > 100 ? "..." : ""));
 
         // Parse JSON (simplified)
         if (message.find("\"type\"") != std::string::npos && 
@@ -766,16 +1411,16 @@ void WebRTCClient::signalingThread() {
             if (answer) {
                 std::string answer_sdp;
                 answer->ToString(&answer_sdp);
-                std::cout << "📥 Answer SDP:\n" << answer_sdp << std::endl;
+                LOG_DEBUG("📥 Answer SDP:\n" << answer_sdp);
 
                 rtc::scoped_refptr<SetSessionDescriptionObserver> observer(
                     new rtc::RefCountedObject<SetSessionDescriptionObserver>(this)
                 );
                 peer_connection_->SetRemoteDescription(observer.get(), answer.release());
-                std::cout << "✅ Answer received and set" << std::endl;
+                LOG_INFO("✅ Answer received and set");
             }
         }
     }
     
-    std::cout << "Signaling thread stopped" << std::endl;
+    LOG_INFO("Signaling thread stopped");
 }
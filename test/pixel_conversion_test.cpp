@@ -0,0 +1,304 @@
+/**
+ * @brief Checks CustomVideoSource's I420 conversion against a scalar reference
+ *
+ * Every format the conversion table and the GRAY16 / NV12 / I420 special
+ * cases handle is converted from frames with padded rows, at odd and even
+ * sizes, both whole-frame and as a sub-region into a padded destination.
+ * Run through ctest; exits non-zero on the first mismatch of each case.
+ */
+
+#include "custom_video_source.h"
+
+#include <api/video/i420_buffer.h>
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// 带行填充的随机帧（step 大于有效宽度），I420 / NV12 为 height * 3 / 2 行
+cv::Mat paddedFrame(PixelFormat format, int width, int height) {
+    int type = CV_8UC1;
+    switch (format) {
+        case PixelFormat::kBGR:
+        case PixelFormat::kRGB:    type = CV_8UC3; break;
+        case PixelFormat::kBGRA:   type = CV_8UC4; break;
+        case PixelFormat::kGRAY16: type = CV_16UC1; break;
+        case PixelFormat::kYUYV:
+        case PixelFormat::kUYVY:   type = CV_8UC2; break;
+        default:                   break;
+    }
+    const int rows = (format == PixelFormat::kI420 || format == PixelFormat::kNV12) ? height * 3 / 2 : height;
+    cv::Mat padded(rows, width + 16, type);
+    cv::randu(padded, cv::Scalar::all(0), cv::Scalar::all(type == CV_16UC1 ? 65535 : 255));
+    return padded(cv::Rect(0, 0, width, rows));
+}
+
+// 逐像素参考转换（BT.601 limited range，与 libyuv 相同的定点系数），奇数宽高的色度取边缘像素
+struct ReferenceI420 {
+    int width;
+    int height;
+    std::vector<int> y;
+    std::vector<int> u;
+    std::vector<int> v;
+};
+
+ReferenceI420 referenceToI420(const cv::Mat& frame, PixelFormat format, const cv::Rect& region) {
+    const int width = region.width;
+    const int height = region.height;
+    const int chroma_width = (width + 1) / 2;
+    const int chroma_height = (height + 1) / 2;
+    ReferenceI420 ref{width, height, std::vector<int>(width * height),
+                      std::vector<int>(chroma_width * chroma_height), std::vector<int>(chroma_width * chroma_height)};
+
+    // 区域内坐标 → 源帧中的样本
+    auto row_ptr = [&](int row) { return frame.ptr(region.y + row); };
+    auto rgb = [&](int x, int row, int& r, int& g, int& b) {
+        const uint8_t* p = row_ptr(row) + (region.x + x) * frame.elemSize();
+        if (format == PixelFormat::kRGB) {
+            r = p[0]; g = p[1]; b = p[2];
+        } else {
+            b = p[0]; g = p[1]; r = p[2];
+        }
+    };
+
+    switch (format) {
+        case PixelFormat::kBGR:
+        case PixelFormat::kRGB:
+        case PixelFormat::kBGRA:
+            for (int row = 0; row < height; row++) {
+                for (int x = 0; x < width; x++) {
+                    int r, g, b;
+                    rgb(x, row, r, g, b);
+                    ref.y[row * width + x] = (66 * r + 129 * g + 25 * b + 0x1080) >> 8;
+                }
+            }
+            for (int cy = 0; cy < chroma_height; cy++) {
+                for (int cx = 0; cx < chroma_width; cx++) {
+                    int sum_r = 0, sum_g = 0, sum_b = 0, count = 0;
+                    for (int dy = 0; dy < 2 && cy * 2 + dy < height; dy++) {
+                        for (int dx = 0; dx < 2 && cx * 2 + dx < width; dx++) {
+                            int r, g, b;
+                            rgb(cx * 2 + dx, cy * 2 + dy, r, g, b);
+                            sum_r += r; sum_g += g; sum_b += b; count++;
+                        }
+                    }
+                    const int r = (sum_r + count / 2) / count;
+                    const int g = (sum_g + count / 2) / count;
+                    const int b = (sum_b + count / 2) / count;
+                    ref.u[cy * chroma_width + cx] = (112 * b - 74 * g - 38 * r + 0x8080) >> 8;
+                    ref.v[cy * chroma_width + cx] = (112 * r - 94 * g - 18 * b + 0x8080) >> 8;
+                }
+            }
+            break;
+        case PixelFormat::kGRAY8:
+        case PixelFormat::kGRAY16:
+            for (int row = 0; row < height; row++) {
+                for (int x = 0; x < width; x++) {
+                    ref.y[row * width + x] = format == PixelFormat::kGRAY8
+                        ? row_ptr(row)[region.x + x]
+                        : reinterpret_cast<const uint16_t*>(row_ptr(row))[region.x + x] >> 8;
+                }
+            }
+            std::fill(ref.u.begin(), ref.u.end(), 128);
+            std::fill(ref.v.begin(), ref.v.end(), 128);
+            break;
+        case PixelFormat::kYUYV:
+        case PixelFormat::kUYVY: {
+            const int y_offset = format == PixelFormat::kYUYV ? 0 : 1;
+            const int u_offset = format == PixelFormat::kYUYV ? 1 : 0;
+            for (int row = 0; row < height; row++) {
+                for (int x = 0; x < width; x++) {
+                    ref.y[row * width + x] = row_ptr(row)[(region.x + x) * 2 + y_offset];
+                }
+            }
+            // 4:2:2 → 4:2:0：相邻两行色度取平均（向上取整），奇数高度的最后一行单独使用
+            for (int cy = 0; cy < chroma_height; cy++) {
+                const uint8_t* row0 = row_ptr(cy * 2) + region.x * 2;
+                const uint8_t* row1 = row_ptr(std::min(cy * 2 + 1, height - 1)) + region.x * 2;
+                for (int cx = 0; cx < chroma_width; cx++) {
+                    const int u = cx * 4 + u_offset;
+                    ref.u[cy * chroma_width + cx] = (row0[u] + row1[u] + 1) >> 1;
+                    ref.v[cy * chroma_width + cx] = (row0[u + 2] + row1[u + 2] + 1) >> 1;
+                }
+            }
+            break;
+        }
+        case PixelFormat::kNV12:
+        case PixelFormat::kI420: {
+            const int full_height = frame.rows * 2 / 3;
+            for (int row = 0; row < height; row++) {
+                for (int x = 0; x < width; x++) {
+                    ref.y[row * width + x] = row_ptr(row)[region.x + x];
+                }
+            }
+            for (int cy = 0; cy < chroma_height; cy++) {
+                for (int cx = 0; cx < chroma_width; cx++) {
+                    const int sx = region.x / 2 + cx;
+                    const int sy = region.y / 2 + cy;
+                    if (format == PixelFormat::kNV12) {
+                        const uint8_t* uv = frame.ptr(full_height + sy);
+                        ref.u[cy * chroma_width + cx] = uv[sx * 2];
+                        ref.v[cy * chroma_width + cx] = uv[sx * 2 + 1];
+                    } else {
+                        // 色度行步长为 Mat 步长的一半
+                        const size_t chroma_step = frame.step / 2;
+                        const uint8_t* u = frame.ptr(full_height) + sy * chroma_step;
+                        const uint8_t* v = frame.ptr(full_height) + (full_height / 2 + sy) * chroma_step;
+                        ref.u[cy * chroma_width + cx] = u[sx];
+                        ref.v[cy * chroma_width + cx] = v[sx];
+                    }
+                }
+            }
+            break;
+        }
+        default:
+            break;
+    }
+    return ref;
+}
+
+// 返回第一处超出容差的样本，一致时返回空字符串
+std::string compareI420(const ReferenceI420& ref, const webrtc::I420Buffer& buffer, int tolerance) {
+    auto check = [&](const char* plane, const std::vector<int>& expected, const uint8_t* data, int stride,
+                     int width, int height) -> std::string {
+        for (int row = 0; row < height; row++) {
+            for (int x = 0; x < width; x++) {
+                const int actual = data[row * stride + x];
+                if (std::abs(actual - expected[row * width + x]) > tolerance) {
+                    return std::string(plane) + " mismatch at (" + std::to_string(x) + ", " + std::to_string(row) +
+                           "): " + std::to_string(actual) + " vs reference " +
+                           std::to_string(expected[row * width + x]);
+                }
+            }
+        }
+        return std::string();
+    };
+    const int chroma_width = (ref.width + 1) / 2;
+    const int chroma_height = (ref.height + 1) / 2;
+    std::string error = check("Y", ref.y, buffer.DataY(), buffer.StrideY(), ref.width, ref.height);
+    if (error.empty()) {
+        error = check("U", ref.u, buffer.DataU(), buffer.StrideU(), chroma_width, chroma_height);
+    }
+    if (error.empty()) {
+        error = check("V", ref.v, buffer.DataV(), buffer.StrideV(), chroma_width, chroma_height);
+    }
+    return error;
+}
+
+struct FormatCase {
+    const char* name;
+    PixelFormat format;
+    bool even_width;    // 源帧宽度必须为偶数（YUYV / UYVY / NV12 / I420）
+    bool even_height;   // 源帧高度必须为偶数（NV12 / I420）
+    bool odd_region_width;
+};
+
+const FormatCase kFormats[] = {
+    {"bgr",    PixelFormat::kBGR,    false, false, true},
+    {"rgb",    PixelFormat::kRGB,    false, false, true},
+    {"bgra",   PixelFormat::kBGRA,   false, false, true},
+    {"gray8",  PixelFormat::kGRAY8,  false, false, true},
+    {"gray16", PixelFormat::kGRAY16, false, false, true},
+    {"yuyv",   PixelFormat::kYUYV,   true,  false, false},
+    {"uyvy",   PixelFormat::kUYVY,   true,  false, false},
+    {"nv12",   PixelFormat::kNV12,   true,  true,  true},
+    {"i420",   PixelFormat::kI420,   true,  true,  true},
+};
+
+int failures = 0;
+
+void expect(bool ok, const std::string& what) {
+    if (!ok) {
+        std::cerr << "FAIL " << what << std::endl;
+        failures++;
+    }
+}
+
+// 整帧转换（目标缓冲区紧凑）和区域转换（偶数起点、奇数尺寸，目标缓冲区带行填充）都与参考一致
+void checkFormat(const FormatCase& c, int width, int height) {
+    width = c.even_width ? width & ~1 : width;
+    height = c.even_height ? height & ~1 : height;
+    const std::string label = std::string(c.name) + " " + std::to_string(width) + "x" + std::to_string(height);
+    // RGB 系：libyuv 各版本色度平均的舍入方式不同，允许少量误差；YUV / 灰度应逐位一致
+    const bool rgb = c.format == PixelFormat::kBGR || c.format == PixelFormat::kRGB ||
+                     c.format == PixelFormat::kBGRA;
+    const int tolerance = rgb ? 3 : 0;
+
+    cv::Mat frame = paddedFrame(c.format, width, height);
+    rtc::scoped_refptr<webrtc::I420Buffer> buffer = webrtc::I420Buffer::Create(width, height);
+    if (!CustomVideoSource::convertToI420(frame, c.format, buffer.get())) {
+        expect(false, label + ": conversion rejected the frame");
+    } else {
+        std::string mismatch = compareI420(referenceToI420(frame, c.format, cv::Rect(0, 0, width, height)),
+                                           *buffer, tolerance);
+        expect(mismatch.empty(), label + ": " + mismatch);
+    }
+
+    cv::Rect region(2, 4, width - 5, height - 7);
+    if (!c.odd_region_width) {
+        region.width &= ~1;
+    }
+    const int chroma_width = (region.width + 1) / 2;
+    rtc::scoped_refptr<webrtc::I420Buffer> padded = webrtc::I420Buffer::Create(
+        region.width, region.height, region.width + 32, chroma_width + 16, chroma_width + 16);
+    const std::string region_label = label + " region " + std::to_string(region.width) + "x" +
+                                     std::to_string(region.height) + "+" + std::to_string(region.x) + "+" +
+                                     std::to_string(region.y);
+    if (!CustomVideoSource::convertRegionToI420(frame, c.format, region,
+                                                padded->MutableDataY(), padded->StrideY(),
+                                                padded->MutableDataU(), padded->StrideU(),
+                                                padded->MutableDataV(), padded->StrideV())) {
+        expect(false, region_label + ": conversion rejected the region");
+    } else {
+        std::string mismatch = compareI420(referenceToI420(frame, c.format, region), *padded, tolerance);
+        expect(mismatch.empty(), region_label + ": " + mismatch);
+    }
+}
+
+// 不匹配的 Mat 类型、尺寸和区域必须被拒绝，而不是越界读取
+void checkRejects() {
+    rtc::scoped_refptr<webrtc::I420Buffer> buffer = webrtc::I420Buffer::Create(63, 47);
+    uint8_t* y = buffer->MutableDataY();
+    uint8_t* u = buffer->MutableDataU();
+    uint8_t* v = buffer->MutableDataV();
+    const int sy = buffer->StrideY();
+    const int suv = buffer->StrideU();
+
+    cv::Mat bgr = paddedFrame(PixelFormat::kBGR, 64, 48);
+    expect(!CustomVideoSource::convertToI420(bgr, PixelFormat::kBGRA, buffer.get()), "BGR Mat accepted as BGRA");
+    expect(!CustomVideoSource::convertToI420(bgr, PixelFormat::kGRAY16, buffer.get()), "BGR Mat accepted as GRAY16");
+    cv::Mat yuyv = paddedFrame(PixelFormat::kYUYV, 64, 48);
+    expect(!CustomVideoSource::convertRegionToI420(yuyv, PixelFormat::kYUYV, cv::Rect(0, 0, 63, 47),
+                                                   y, sy, u, suv, v, suv), "YUYV odd-width region accepted");
+    expect(!CustomVideoSource::convertRegionToI420(bgr, PixelFormat::kBGR, cv::Rect(1, 0, 32, 32),
+                                                   y, sy, u, suv, v, suv), "odd region origin accepted");
+    expect(!CustomVideoSource::convertRegionToI420(bgr, PixelFormat::kBGR, cv::Rect(34, 0, 32, 32),
+                                                   y, sy, u, suv, v, suv), "region past the right edge accepted");
+    cv::Mat nv12 = paddedFrame(PixelFormat::kNV12, 64, 48);
+    expect(!CustomVideoSource::convertRegionToI420(nv12, PixelFormat::kNV12, cv::Rect(0, 0, 64, 50),
+                                                   y, sy, u, suv, v, suv), "region into the NV12 UV plane accepted");
+}
+
+}  // namespace
+
+int main() {
+    cv::theRNG().state = 0x5eed;
+    const int sizes[][2] = {{641, 481}, {640, 480}, {1920, 1080}, {17, 9}};
+    for (const FormatCase& c : kFormats) {
+        for (const auto& size : sizes) {
+            checkFormat(c, size[0], size[1]);
+        }
+    }
+    checkRejects();
+
+    if (failures > 0) {
+        std::cerr << failures << " pixel conversion check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All pixel conversion checks passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,672 @@
+/**
+ * @brief Loopback glass-to-glass latency harness
+ *
+ * Runs a sender WebRTCClient and a native receiver PeerConnection in one
+ * process over localhost, with an in-process WebSocket signaling stand-in.
+ * Every frame carries a pixel watermark (frame id + capture time); the
+ * receiver decodes it after the video decoder and reports capture-to-decode
+ * latency percentiles, fps and frame loss.
+ *
+ * Usage: webrtc_latency_harness [--width W] [--height H] [--fps N]
+ *                               [--duration S] [--port P] [--json FILE]
+ *                               [--latency-mode normal|ultra]
+ */
+
+#include "video_source.h"
+#include "webrtc_client.h"
+#include "latency_tracer.h"
+#include "signaling_utils.h"
+#include "simple_video_codec_factory.h"
+
+#include <api/create_peerconnection_factory.h>
+#include <api/audio_codecs/builtin_audio_decoder_factory.h>
+#include <api/audio_codecs/builtin_audio_encoder_factory.h>
+#include <api/jsep.h>
+#include <api/peer_connection_interface.h>
+#include <api/video/i420_buffer.h>
+#include <api/video/video_sink_interface.h>
+#include <rtc_base/ref_counted_object.h>
+#include <rtc_base/thread.h>
+#include <nlohmann/json.hpp>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+
+using json = nlohmann::json;
+
+namespace {
+
+// ---------------------------------------------------------------------------
+// Watermark: 80 cells across a band at the bottom of the frame
+//   [0, 32)  frame id
+//   [32, 64) capture time (us since harness start, wraps after ~71 min)
+//   [64, 80) checksum
+// Cell positions are relative to the frame size so the watermark survives
+// encoder-side downscaling.
+// ---------------------------------------------------------------------------
+
+constexpr int kWatermarkBits = 80;
+
+uint16_t watermarkChecksum(uint32_t frame_id, uint32_t capture_us) {
+    return static_cast<uint16_t>((frame_id ^ capture_us ^ (frame_id >> 16) ^ (capture_us >> 16) ^ 0xA5A5) & 0xFFFF);
+}
+
+int watermarkBandHeight(int height) {
+    return std::max(8, height / 12);
+}
+
+void drawWatermark(cv::Mat& frame, uint32_t frame_id, uint32_t capture_us) {
+    uint64_t low = (static_cast<uint64_t>(capture_us) << 32) | frame_id;
+    uint16_t checksum = watermarkChecksum(frame_id, capture_us);
+
+    const int band = watermarkBandHeight(frame.rows);
+    const int top = frame.rows - band;
+    for (int i = 0; i < kWatermarkBits; i++) {
+        bool bit = i < 64 ? ((low >> i) & 1) : ((checksum >> (i - 64)) & 1);
+        int x0 = i * frame.cols / kWatermarkBits;
+        int x1 = (i + 1) * frame.cols / kWatermarkBits;
+        cv::rectangle(frame, cv::Rect(x0, top, x1 - x0, band),
+                      bit ? cv::Scalar(255, 255, 255) : cv::Scalar(0, 0, 0), cv::FILLED);
+    }
+}
+
+bool readWatermark(const webrtc::I420BufferInterface& buffer, uint32_t* frame_id, uint32_t* capture_us) {
+    const int width = buffer.width();
+    const int height = buffer.height();
+    const int band = watermarkBandHeight(height);
+    const int cell = width / kWatermarkBits;
+    const int sample = std::max(1, std::min(cell, band) / 3);
+    const int y_center = height - band / 2;
+
+    uint64_t low = 0;
+    uint16_t checksum = 0;
+    for (int i = 0; i < kWatermarkBits; i++) {
+        int x_center = (2 * i + 1) * width / (2 * kWatermarkBits);
+        int sum = 0;
+        for (int dy = -sample / 2; dy <= sample / 2; dy++) {
+            const uint8_t* row = buffer.DataY() + (y_center + dy) * buffer.StrideY();
+            for (int dx = -sample / 2; dx <= sample / 2; dx++) {
+                sum += row[x_center + dx];
+            }
+        }
+        int count = (sample / 2 * 2 + 1) * (sample / 2 * 2 + 1);
+        bool bit = sum / count >= 128;
+        if (i < 64) {
+            low |= static_cast<uint64_t>(bit) << i;
+        } else {
+            checksum |= static_cast<uint16_t>(bit) << (i - 64);
+        }
+    }
+
+    *frame_id = static_cast<uint32_t>(low & 0xFFFFFFFF);
+    *capture_us = static_cast<uint32_t>(low >> 32);
+    return checksum == watermarkChecksum(*frame_id, *capture_us);
+}
+
+// ---------------------------------------------------------------------------
+// Sender-side source: moving gradient + watermark
+// ---------------------------------------------------------------------------
+
+class WatermarkSource : public MatVideoSource {
+public:
+    WatermarkSource(int width, int height, int fps, int64_t epoch_us)
+        : width_(width), height_(height), fps_(fps), epoch_us_(epoch_us),
+          next_frame_id_(1), is_initialized_(false) {}
+
+    bool initialize() override {
+        // 宽度两倍的渐变图，每帧平移一段，编码器需要处理真实的运动
+        background_.create(height_, width_ * 2, CV_8UC3);
+        for (int x = 0; x < background_.cols; x++) {
+            uint8_t v = static_cast<uint8_t>((x * 255) / width_);
+            background_.col(x).setTo(cv::Scalar(v, 255 - v, (v * 3) & 0xFF));
+        }
+        is_initialized_ = true;
+        return true;
+    }
+
+    bool getFrame(cv::Mat& frame) override {
+        uint32_t frame_id = next_frame_id_++;
+        int offset = static_cast<int>((frame_id * 8) % width_);
+        background_(cv::Rect(offset, 0, width_, height_)).copyTo(frame);
+
+        uint32_t capture_us = static_cast<uint32_t>(LatencyTracer::nowUs() - epoch_us_);
+        drawWatermark(frame, frame_id, capture_us);
+        last_frame_id_ = frame_id;
+        return true;
+    }
+
+    int getWidth() const override { return width_; }
+    int getHeight() const override { return height_; }
+    int getFrameRate() const override { return fps_; }
+    void release() override { is_initialized_ = false; }
+    std::string getName() const override { return "Latency Harness Watermark"; }
+    bool isReady() const override { return is_initialized_; }
+
+    uint32_t lastFrameId() const { return last_frame_id_; }
+
+private:
+    int width_;
+    int height_;
+    int fps_;
+    int64_t epoch_us_;
+    uint32_t next_frame_id_;
+    std::atomic<uint32_t> last_frame_id_{0};
+    bool is_initialized_;
+    cv::Mat background_;
+};
+
+// ---------------------------------------------------------------------------
+// Receiver-side sink: decodes the watermark of every decoded frame
+// ---------------------------------------------------------------------------
+
+class LatencySink : public rtc::VideoSinkInterface<webrtc::VideoFrame> {
+public:
+    explicit LatencySink(int64_t epoch_us) : epoch_us_(epoch_us) {}
+
+    void OnFrame(const webrtc::VideoFrame& frame) override {
+        int64_t now_us = LatencyTracer::nowUs();
+        rtc::scoped_refptr<webrtc::I420BufferInterface> buffer = frame.video_frame_buffer()->ToI420();
+
+        uint32_t frame_id = 0;
+        uint32_t capture_us = 0;
+        if (!readWatermark(*buffer, &frame_id, &capture_us)) {
+            decode_errors_++;
+            return;
+        }
+
+        uint32_t now_offset = static_cast<uint32_t>(now_us - epoch_us_);
+        int64_t latency_us = static_cast<uint32_t>(now_offset - capture_us);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!measuring_) {
+            first_frame_cv_.notify_all();
+            warmed_up_ = true;
+            return;
+        }
+        latency_.record(latency_us);
+        received_ids_.insert(frame_id);
+        last_width_ = buffer->width();
+        last_height_ = buffer->height();
+    }
+
+    bool waitForFirstFrame(int timeout_s) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return first_frame_cv_.wait_for(lock, std::chrono::seconds(timeout_s),
+                                        [this] { return warmed_up_; });
+    }
+
+    void startMeasuring() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        measuring_ = true;
+        decode_errors_ = 0;
+    }
+
+    void stopMeasuring() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        measuring_ = false;
+    }
+
+    const LatencyHistogram& latency() const { return latency_; }
+    std::set<uint32_t> receivedIds() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return received_ids_;
+    }
+    int decodeErrors() const { return decode_errors_; }
+    int lastWidth() const { return last_width_; }
+    int lastHeight() const { return last_height_; }
+
+private:
+    int64_t epoch_us_;
+    std::mutex mutex_;
+    std::condition_variable first_frame_cv_;
+    bool warmed_up_ = false;
+    bool measuring_ = false;
+    LatencyHistogram latency_;
+    std::set<uint32_t> received_ids_;
+    std::atomic<int> decode_errors_{0};
+    int last_width_ = 0;
+    int last_height_ = 0;
+};
+
+// ---------------------------------------------------------------------------
+// Native receiver PeerConnection
+// ---------------------------------------------------------------------------
+
+class Receiver : public webrtc::PeerConnectionObserver {
+public:
+    explicit Receiver(LatencySink* sink) : sink_(sink) {}
+
+    bool initialize() {
+        network_thread_ = rtc::Thread::CreateWithSocketServer();
+        worker_thread_ = rtc::Thread::Create();
+        signaling_thread_ = rtc::Thread::Create();
+        network_thread_->SetName("rx_network", nullptr);
+        worker_thread_->SetName("rx_worker", nullptr);
+        signaling_thread_->SetName("rx_signaling", nullptr);
+        network_thread_->Start();
+        worker_thread_->Start();
+        signaling_thread_->Start();
+
+        factory_ = webrtc::CreatePeerConnectionFactory(
+            network_thread_.get(), worker_thread_.get(), signaling_thread_.get(),
+            nullptr,
+            webrtc::CreateBuiltinAudioEncoderFactory(),
+            webrtc::CreateBuiltinAudioDecoderFactory(),
+            std::make_unique<webrtc::SimpleVideoEncoderFactory>(),
+            std::make_unique<webrtc::SimpleVideoDecoderFactory>(),
+            nullptr, nullptr);
+        if (!factory_) {
+            std::cerr << "Failed to create receiver PeerConnectionFactory" << std::endl;
+            return false;
+        }
+
+        webrtc::PeerConnectionInterface::RTCConfiguration config;
+        config.bundle_policy = webrtc::PeerConnectionInterface::kBundlePolicyMaxBundle;
+        config.rtcp_mux_policy = webrtc::PeerConnectionInterface::kRtcpMuxPolicyRequire;
+        pc_ = factory_->CreatePeerConnection(config, nullptr, nullptr, this);
+        return pc_ != nullptr;
+    }
+
+    void close() {
+        if (pc_) {
+            pc_->Close();
+            pc_ = nullptr;
+        }
+        factory_ = nullptr;
+    }
+
+    /**
+     * @brief Apply a remote offer and return the complete (non-trickle) answer
+     */
+    std::string answer(const std::string& offer_sdp) {
+        webrtc::SdpParseError error;
+        std::unique_ptr<webrtc::SessionDescriptionInterface> offer =
+            webrtc::CreateSessionDescription(webrtc::SdpType::kOffer, offer_sdp, &error);
+        if (!offer) {
+            std::cerr << "Failed to parse offer: " << error.description << std::endl;
+            return "";
+        }
+
+        pc_->SetRemoteDescription(new rtc::RefCountedObject<SetObserver>(), offer.release());
+        pc_->CreateAnswer(new rtc::RefCountedObject<AnswerObserver>(this),
+                          webrtc::PeerConnectionInterface::RTCOfferAnswerOptions());
+
+        // 等待 ICE 收集完成，answer 中直接包含全部 candidate
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!gathering_cv_.wait_for(lock, std::chrono::seconds(10), [this] { return gathering_complete_; })) {
+            std::cerr << "Receiver ICE gathering timed out" << std::endl;
+            return "";
+        }
+        std::string sdp;
+        pc_->local_description()->ToString(&sdp);
+        return sdp;
+    }
+
+    void addCandidate(const std::string& sdp_mid, int sdp_mline_index, const std::string& candidate) {
+        webrtc::SdpParseError error;
+        std::unique_ptr<webrtc::IceCandidateInterface> ice(
+            webrtc::CreateIceCandidate(sdp_mid, sdp_mline_index, candidate, &error));
+        if (ice) {
+            pc_->AddIceCandidate(ice.get());
+        }
+    }
+
+    // PeerConnectionObserver implementation
+    void OnSignalingChange(webrtc::PeerConnectionInterface::SignalingState) override {}
+    void OnDataChannel(rtc::scoped_refptr<webrtc::DataChannelInterface>) override {}
+    void OnRenegotiationNeeded() override {}
+    void OnIceConnectionChange(webrtc::PeerConnectionInterface::IceConnectionState state) override {
+        if (state == webrtc::PeerConnectionInterface::kIceConnectionConnected) {
+            std::cout << "✅ Receiver ICE connected" << std::endl;
+        }
+    }
+    void OnIceGatheringChange(webrtc::PeerConnectionInterface::IceGatheringState state) override {
+        if (state == webrtc::PeerConnectionInterface::kIceGatheringComplete) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            gathering_complete_ = true;
+            gathering_cv_.notify_all();
+        }
+    }
+    void OnIceCandidate(const webrtc::IceCandidateInterface*) override {}
+    void OnTrack(rtc::scoped_refptr<webrtc::RtpTransceiverInterface> transceiver) override {
+        auto track = transceiver->receiver()->track();
+        if (track && track->kind() == webrtc::MediaStreamTrackInterface::kVideoKind) {
+            static_cast<webrtc::VideoTrackInterface*>(track.get())
+                ->AddOrUpdateSink(sink_, rtc::VideoSinkWants());
+            std::cout << "📺 Receiver video track attached" << std::endl;
+        }
+    }
+
+private:
+    class SetObserver : public webrtc::SetSessionDescriptionObserver {
+    public:
+        void OnSuccess() override {}
+        void OnFailure(webrtc::RTCError error) override {
+            std::cerr << "Receiver set description failed: " << error.message() << std::endl;
+        }
+    };
+
+    class AnswerObserver : public webrtc::CreateSessionDescriptionObserver {
+    public:
+        explicit AnswerObserver(Receiver* receiver) : receiver_(receiver) {}
+        void OnSuccess(webrtc::SessionDescriptionInterface* desc) override {
+            receiver_->pc_->SetLocalDescription(new rtc::RefCountedObject<SetObserver>(), desc);
+        }
+        void OnFailure(webrtc::RTCError error) override {
+            std::cerr << "Receiver create answer failed: " << error.message() << std::endl;
+        }
+    private:
+        Receiver* receiver_;
+    };
+
+    LatencySink* sink_;
+    std::unique_ptr<rtc::Thread> network_thread_;
+    std::unique_ptr<rtc::Thread> worker_thread_;
+    std::unique_ptr<rtc::Thread> signaling_thread_;
+    rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> factory_;
+    rtc::scoped_refptr<webrtc::PeerConnectionInterface> pc_;
+
+    std::mutex mutex_;
+    std::condition_variable gathering_cv_;
+    bool gathering_complete_ = false;
+};
+
+// ---------------------------------------------------------------------------
+// In-process signaling stand-in (single WebSocket client)
+// ---------------------------------------------------------------------------
+
+class LoopbackSignaling {
+public:
+    LoopbackSignaling(int port, Receiver* receiver)
+        : port_(port), receiver_(receiver), listen_socket_(-1), client_socket_(-1), should_stop_(false) {}
+
+    ~LoopbackSignaling() { stop(); }
+
+    bool start() {
+        listen_socket_ = socket(AF_INET, SOCK_STREAM, 0);
+        int reuse = 1;
+        setsockopt(listen_socket_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port_);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (bind(listen_socket_, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(listen_socket_, 1) < 0) {
+            std::cerr << "Signaling stand-in failed to listen on port " << port_ << ": "
+                      << strerror(errno) << std::endl;
+            return false;
+        }
+        thread_ = std::thread(&LoopbackSignaling::run, this);
+        return true;
+    }
+
+    void stop() {
+        should_stop_ = true;
+        if (client_socket_ >= 0) shutdown(client_socket_, SHUT_RDWR);
+        if (listen_socket_ >= 0) shutdown(listen_socket_, SHUT_RDWR);
+        if (thread_.joinable()) thread_.join();
+        if (client_socket_ >= 0) { close(client_socket_); client_socket_ = -1; }
+        if (listen_socket_ >= 0) { close(listen_socket_); listen_socket_ = -1; }
+    }
+
+private:
+    void run() {
+        client_socket_ = accept(listen_socket_, nullptr, nullptr);
+        if (client_socket_ < 0) {
+            return;
+        }
+
+        // HTTP Upgrade：客户端使用固定 key，返回 RFC 6455 示例中对应的 accept 值
+        std::string request;
+        char buffer[8192];
+        while (request.find("\r\n\r\n") == std::string::npos) {
+            ssize_t n = recv(client_socket_, buffer, sizeof(buffer), 0);
+            if (n <= 0) return;
+            request.append(buffer, n);
+        }
+        std::string response =
+            "HTTP/1.1 101 Switching Protocols\r\n"
+            "Upgrade: websocket\r\n"
+            "Connection: Upgrade\r\n"
+            "Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=\r\n\r\n";
+        send(client_socket_, response.data(), response.size(), 0);
+
+        std::string pending = request.substr(request.find("\r\n\r\n") + 4);
+        while (!should_stop_) {
+            std::string message;
+            while (nextFrame(pending, &message)) {
+                handleMessage(message);
+            }
+            ssize_t n = recv(client_socket_, buffer, sizeof(buffer), 0);
+            if (n <= 0) break;
+            pending.append(buffer, n);
+        }
+    }
+
+    // 从缓冲区中取出一个完整帧（TCP 可能把多条消息合并）
+    static bool nextFrame(std::string& pending, std::string* message) {
+        if (pending.size() < 2) return false;
+        size_t header = 2;
+        size_t payload_len = static_cast<unsigned char>(pending[1]) & 0x7F;
+        if (payload_len == 126) {
+            if (pending.size() < 4) return false;
+            payload_len = (static_cast<unsigned char>(pending[2]) << 8) | static_cast<unsigned char>(pending[3]);
+            header = 4;
+        } else if (payload_len == 127) {
+            return false;   // 信令消息不会超过 64KB
+        }
+        if (pending[1] & 0x80) header += 4;
+        if (pending.size() < header + payload_len) return false;
+
+        *message = decodeWebSocketFrame(pending.data(), header + payload_len);
+        pending.erase(0, header + payload_len);
+        return true;
+    }
+
+    void sendText(const std::string& text) {
+        // 服务器 → 客户端的帧不加 mask
+        std::string frame;
+        frame.push_back(static_cast<char>(0x81));
+        if (text.size() <= 125) {
+            frame.push_back(static_cast<char>(text.size()));
+        } else {
+            frame.push_back(126);
+            frame.push_back(static_cast<char>((text.size() >> 8) & 0xFF));
+            frame.push_back(static_cast<char>(text.size() & 0xFF));
+        }
+        frame += text;
+        send(client_socket_, frame.data(), frame.size(), 0);
+    }
+
+    void handleMessage(const std::string& message) {
+        if (message.empty()) return;
+        json msg = json::parse(message, nullptr, false);
+        if (msg.is_discarded() || !msg.contains("type")) return;
+
+        std::string type = msg["type"].get<std::string>();
+        if (type == "register") {
+            sendText(json{{"type", "registered"}, {"client_id", msg.value("client_id", "")}}.dump());
+        } else if (type == "offer") {
+            std::string answer_sdp = receiver_->answer(msg["sdp"].get<std::string>());
+            if (!answer_sdp.empty()) {
+                sendText(json{{"type", "answer"}, {"sdp", answer_sdp}}.dump());
+            }
+        } else if (type == "candidate" && msg.contains("candidate")) {
+            const json& c = msg["candidate"];
+            receiver_->addCandidate(c.value("sdpMid", ""), c.value("sdpMLineIndex", 0),
+                                    c.value("candidate", ""));
+        }
+    }
+
+    int port_;
+    Receiver* receiver_;
+    int listen_socket_;
+    int client_socket_;
+    std::atomic<bool> should_stop_;
+    std::thread thread_;
+};
+
+void printUsage(const char* program_name) {
+    std::cout << "Usage: " << program_name << " [options]" << std::endl;
+    std::cout << "  --width <w>        视频宽度 (default: 1920)" << std::endl;
+    std::cout << "  --height <h>       视频高度 (default: 1080)" << std::endl;
+    std::cout << "  --fps <n>          帧率 (default: 60)" << std::endl;
+    std::cout << "  --duration <s>     测量时长，秒 (default: 20)" << std::endl;
+    std::cout << "  --port <port>      本地信令端口 (default: 50071)" << std::endl;
+    std::cout << "  --json <file>      以 JSON 写出结果" << std::endl;
+    std::cout << "  --latency-mode <m> 发送端延迟模式: normal|ultra (default: normal)" << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    int width = 1920;
+    int height = 1080;
+    int fps = 60;
+    int duration_s = 20;
+    int port = 50071;
+    std::string json_file;
+    AppConfig config;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--width" && i + 1 < argc) {
+            width = std::stoi(argv[++i]);
+        } else if (arg == "--height" && i + 1 < argc) {
+            height = std::stoi(argv[++i]);
+        } else if (arg == "--fps" && i + 1 < argc) {
+            fps = std::stoi(argv[++i]);
+        } else if (arg == "--duration" && i + 1 < argc) {
+            duration_s = std::stoi(argv[++i]);
+        } else if (arg == "--port" && i + 1 < argc) {
+            port = std::stoi(argv[++i]);
+        } else if (arg == "--json" && i + 1 < argc) {
+            json_file = argv[++i];
+        } else if (arg == "--latency-mode" && i + 1 < argc) {
+            config.latency_mode = argv[++i];
+        } else {
+            printUsage(argv[0]);
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+    if (!applyLatencyProfile(config)) {
+        return 1;
+    }
+
+    const int64_t epoch_us = LatencyTracer::nowUs();
+    LatencySink sink(epoch_us);
+
+    Receiver receiver(&sink);
+    if (!receiver.initialize()) {
+        return 1;
+    }
+
+    LoopbackSignaling signaling(port, &receiver);
+    if (!signaling.start()) {
+        return 1;
+    }
+
+    auto source = std::make_shared<WatermarkSource>(width, height, fps, epoch_us);
+    source->initialize();
+
+    config.webrtc.server_ip = "127.0.0.1";
+    config.webrtc.server_port = port;
+    config.webrtc.client_id = "latency_harness";
+    config.webrtc.ice_servers.clear();   // 本机回环只需要 host candidate
+
+    auto client = std::make_unique<WebRTCClient>(source, config);
+    if (!client->initialize() || !client->start()) {
+        std::cerr << "Failed to start sender" << std::endl;
+        return 1;
+    }
+
+    std::cout << "⏳ Waiting for first decoded frame..." << std::endl;
+    if (!sink.waitForFirstFrame(15)) {
+        std::cerr << "❌ No frame decoded within 15 s" << std::endl;
+        receiver.close();
+        client->stop();
+        return 1;
+    }
+
+    // 预热：等待码率爬升和编码器稳定
+    std::this_thread::sleep_for(std::chrono::seconds(2));
+
+    uint32_t first_id = source->lastFrameId() + 1;
+    sink.startMeasuring();
+    auto start = std::chrono::steady_clock::now();
+    std::cout << "📏 Measuring for " << duration_s << " s at "
+              << width << "x" << height << "@" << fps << "..." << std::endl;
+    std::this_thread::sleep_for(std::chrono::seconds(duration_s));
+    uint32_t last_id = source->lastFrameId();
+    // 留出在途帧的时间
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    sink.stopMeasuring();
+    double elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() - 0.5;
+
+    receiver.close();
+    signaling.stop();
+    client->stop();
+
+    std::set<uint32_t> received = sink.receivedIds();
+    uint64_t sent = last_id >= first_id ? last_id - first_id + 1 : 0;
+    uint64_t received_in_window = 0;
+    for (uint32_t id : received) {
+        if (id >= first_id && id <= last_id) received_in_window++;
+    }
+    uint64_t lost = sent - received_in_window;
+    double loss_pct = sent ? 100.0 * lost / sent : 0.0;
+    double recv_fps = received_in_window / elapsed_s;
+    const LatencyHistogram& latency = sink.latency();
+
+    std::cout << "\n========================================" << std::endl;
+    std::cout << "Glass-to-glass (capture → decode) latency" << std::endl;
+    std::cout << "========================================" << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "  Resolution:     " << width << "x" << height << " @ " << fps
+              << " fps (decoded " << sink.lastWidth() << "x" << sink.lastHeight() << ")" << std::endl;
+    std::cout << "  Latency mode:   " << config.latency_mode << std::endl;
+    std::cout << "  Frames sent:    " << sent << std::endl;
+    std::cout << "  Frames decoded: " << received_in_window << std::endl;
+    std::cout << "  Frame loss:     " << lost << " (" << loss_pct << "%)" << std::endl;
+    std::cout << "  Decoded fps:    " << recv_fps << std::endl;
+    std::cout << "  Watermark errs: " << sink.decodeErrors() << std::endl;
+    std::cout << "  Latency p50:    " << latency.percentile(50) / 1000.0 << " ms" << std::endl;
+    std::cout << "  Latency p90:    " << latency.percentile(90) / 1000.0 << " ms" << std::endl;
+    std::cout << "  Latency p99:    " << latency.percentile(99) / 1000.0 << " ms" << std::endl;
+    std::cout << "  Latency max:    " << latency.max() / 1000.0 << " ms" << std::endl;
+
+    if (!json_file.empty()) {
+        json result = {
+            {"width", width}, {"height", height}, {"fps", fps},
+            {"latency_mode", config.latency_mode},
+            {"decoded_width", sink.lastWidth()}, {"decoded_height", sink.lastHeight()},
+            {"duration_s", elapsed_s},
+            {"frames_sent", sent}, {"frames_decoded", received_in_window},
+            {"frames_lost", lost}, {"loss_percent", loss_pct},
+            {"decoded_fps", recv_fps}, {"watermark_errors", sink.decodeErrors()},
+            {"latency_us", {
+                {"p50", latency.percentile(50)}, {"p90", latency.percentile(90)},
+                {"p99", latency.percentile(99)}, {"max", latency.max()}
+            }}
+        };
+        std::ofstream out(json_file);
+        out << result.dump(2) << std::endl;
+        std::cout << "Results written to " << json_file << std::endl;
+    }
+
+    return 0;
+}